@@ -265,7 +265,16 @@ Java_com_openpajak_pph_PPH21Calculator_nativeGetBreakdownLabel(JNIEnv *env, jcla
     if (result == NULL || index < 0 || index >= (jint)result->breakdown_count) {
         return NULL;
     }
-    return create_jstring(env, result->breakdown[index].label);
+    return create_jstring(env, pph_result_row_label(result, (pph_size_t)index));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_openpajak_pph_PPH21Calculator_nativeGetBreakdownLabelId(JNIEnv *env, jclass clazz, jlong resultPtr, jint index) {
+    pph_result_t *result = (pph_result_t*)(intptr_t)resultPtr;
+    if (result == NULL || index < 0 || index >= (jint)result->breakdown_count) {
+        return 0;
+    }
+    return (jint)result->breakdown[index].label;
 }
 
 JNIEXPORT jlong JNICALL
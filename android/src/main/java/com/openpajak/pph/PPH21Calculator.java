@@ -73,6 +73,7 @@ public class PPH21Calculator {
     static native long nativeGetTotalTax(long resultPtr);
     static native int nativeGetBreakdownCount(long resultPtr);
     static native String nativeGetBreakdownLabel(long resultPtr, int index);
+    static native int nativeGetBreakdownLabelId(long resultPtr, int index);
     static native long nativeGetBreakdownValue(long resultPtr, int index);
     static native int nativeGetBreakdownVariant(long resultPtr, int index);
     static native void nativeFreeResult(long resultPtr);
@@ -188,11 +189,13 @@ public class PPH21Calculator {
      */
     public static class BreakdownRow {
         public final String label;
+        public final int labelId;  // Stable pph_label_id_t value, for matching rows
         public final PPHMoney value;
         public final BreakdownVariant variant;
 
-        BreakdownRow(String label, PPHMoney value, BreakdownVariant variant) {
+        BreakdownRow(String label, int labelId, PPHMoney value, BreakdownVariant variant) {
             this.label = label;
+            this.labelId = labelId;
             this.value = value;
             this.variant = variant;
         }
@@ -221,11 +224,12 @@ public class PPH21Calculator {
 
             for (int i = 0; i < count; i++) {
                 String label = nativeGetBreakdownLabel(resultPtr, i);
+                int labelId = nativeGetBreakdownLabelId(resultPtr, i);
                 long value = nativeGetBreakdownValue(resultPtr, i);
                 int variantOrdinal = nativeGetBreakdownVariant(resultPtr, i);
 
                 BreakdownVariant variant = BreakdownVariant.values()[variantOrdinal];
-                breakdown.add(new BreakdownRow(label, PPHMoney.fromValue(value), variant));
+                breakdown.add(new BreakdownRow(label, labelId, PPHMoney.fromValue(value), variant));
             }
         }
 
@@ -7,6 +7,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pph/pph_calculator.h>
+#include "mapped_file.h"
+#include "payroll.h"
+#include "payroll_binary.h"
 
 static void print_version(void) {
     printf(
@@ -25,9 +28,19 @@ static void print_usage(void) {
         "  pph4-2   Calculate PPh Final Pasal 4(2)\n"
         "  ppn      Calculate PPN\n"
         "  ppnbm    Calculate PPnBM\n"
+        "  convert  Convert a payroll CSV to the binary payroll format\n"
+        "  rules    Export the built-in tax rules as a ruleset file\n"
         "  version  Show version information\n"
         "  help     Show this help message\n"
     );
+    printf(
+        "\npph21 options:\n"
+        "  --input FILE     Payroll CSV or binary payroll ('-' for CSV on stdin)\n"
+        "  --output FILE    Result CSV (default: stdout)\n"
+        "  --amounts id     Amounts use Indonesian format (10.000.000,50)\n"
+        "  --threads N      Worker threads for file input (default: all CPUs)\n"
+        "  --rules FILE     Tax ruleset file (default: built-in rules)\n"
+    );
 }
 
 static void print_breakdown(pph_result_t *result) {
@@ -42,22 +55,23 @@ static void print_breakdown(pph_result_t *result) {
 
     for (i = 0; i < result->breakdown_count; i++) {
         pph_breakdown_row_t *row = &result->breakdown[i];
+        const char *note = pph_result_row_note(result, i);
 
         if (row->variant == PPH_BREAKDOWN_SECTION) {
-            printf("\n>>> %s\n", row->label);
+            printf("\n>>> %s\n", pph_result_row_label(result, i));
         } else {
-            printf("  %-40s ", row->label);
+            printf("  %-40s ", pph_result_row_label(result, i));
 
             if (row->value_type == PPH_VALUE_CURRENCY) {
-                pph_money_to_string_formatted(row->value, buf, sizeof(buf));
+                pph_money_format(row->value, PPH_MONEY_FORMAT_EN, buf, sizeof(buf));
                 printf("%15s", buf);
             } else if (row->value_type == PPH_VALUE_PERCENT) {
                 pph_percent_to_string(row->value, buf, sizeof(buf));
                 printf("%15s", buf);
             }
 
-            if (row->note[0] != '\0') {
-                printf("  (%s)", row->note);
+            if (note[0] != '\0') {
+                printf("  (%s)", note);
             }
             printf("\n");
 
@@ -68,10 +82,203 @@ static void print_breakdown(pph_result_t *result) {
     }
 
     printf("\nTotal Tax: ");
-    pph_money_to_string_formatted(result->total_tax, buf, sizeof(buf));
+    pph_money_format(result->total_tax, PPH_MONEY_FORMAT_EN, buf, sizeof(buf));
     printf("%s IDR\n\n", buf);
 }
 
+/* pphc pph21 --input payroll.csv [--output taxes.csv] [--amounts id] [--threads N]
+               [--rules rules.pphr] */
+static int run_pph21_csv(int argc, char *argv[]) {
+    const char *input_path = NULL;
+    const char *output_path = NULL;
+    payroll_amount_format_t format = PAYROLL_AMOUNT_PLAIN;
+    payroll_stats_t stats;
+    mapped_file_t mapped;
+    pph_executor_t *executor;
+    FILE *in, *out;
+    int threads = 0;
+    int i, rc;
+
+    for (i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+            pph_ruleset_t *ruleset = pph_ruleset_load(argv[++i]);
+
+            if (ruleset == NULL) {
+                fprintf(stderr, "Cannot load %s: %s\n", argv[i], pph_get_last_error());
+                return 1;
+            }
+            pph_ruleset_publish(ruleset);
+        } else if (strcmp(argv[i], "--amounts") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "id") == 0) {
+                format = PAYROLL_AMOUNT_ID;
+            } else if (strcmp(argv[i], "plain") != 0) {
+                fprintf(stderr, "Unknown amount format: %s\n", argv[i]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (input_path == NULL) {
+        fprintf(stderr, "Missing --input\n");
+        return 1;
+    }
+
+    /* Files are parsed in place from a mapping, in parallel; pipes and
+       targets without mmap are streamed through a line buffer */
+    in = NULL;
+    if (strcmp(input_path, "-") == 0) {
+        in = stdin;
+    } else if (mapped_file_open(input_path, &mapped) != 0) {
+        in = fopen(input_path, "r");
+        if (in == NULL) {
+            fprintf(stderr, "Cannot open %s\n", input_path);
+            return 1;
+        }
+    }
+
+    out = stdout;
+    if (output_path != NULL && strcmp(output_path, "-") != 0) {
+        out = fopen(output_path, "w");
+        if (out == NULL) {
+            fprintf(stderr, "Cannot create %s\n", output_path);
+        }
+    }
+
+    if (out == NULL) {
+        rc = -1;
+    } else if (in == NULL) {
+        executor = pph_executor_create(threads);
+        if (executor == NULL) {
+            fprintf(stderr, "Error: %s\n", pph_get_last_error());
+            rc = -1;
+        } else {
+            rc = payroll_binary_detect(mapped.data, mapped.size)
+               ? payroll_binary_run(mapped.data, mapped.size, out, executor, &stats)
+               : payroll_run_parallel(mapped.data, mapped.size, out, format, executor, &stats);
+            pph_executor_free(executor);
+        }
+    } else {
+        rc = payroll_run_csv(in, out, format, &stats);
+    }
+
+    if (in == NULL) {
+        mapped_file_close(&mapped);
+    } else if (in != stdin) {
+        fclose(in);
+    }
+    if (out == NULL) {
+        return 1;
+    }
+    if (out != stdout && fclose(out) != 0) rc = -1;
+
+    if (rc != 0) {
+        fprintf(stderr, "I/O error while processing %s\n", input_path);
+        return 1;
+    }
+
+    fprintf(stderr, "%lu records, %lu failed\n", stats.records, stats.failed);
+    return (stats.failed > 0) ? 2 : 0;
+}
+
+/* pphc convert --input payroll.csv --output payroll.pphb [--amounts id] */
+static int run_convert(int argc, char *argv[]) {
+    const char *input_path = NULL;
+    const char *output_path = NULL;
+    payroll_amount_format_t format = PAYROLL_AMOUNT_PLAIN;
+    payroll_stats_t stats;
+    FILE *in, *out;
+    int i, rc;
+
+    for (i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--amounts") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "id") == 0) {
+                format = PAYROLL_AMOUNT_ID;
+            } else if (strcmp(argv[i], "plain") != 0) {
+                fprintf(stderr, "Unknown amount format: %s\n", argv[i]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (input_path == NULL || output_path == NULL) {
+        fprintf(stderr, "Usage: pphc convert --input payroll.csv --output payroll.pphb\n");
+        return 1;
+    }
+
+    in = (strcmp(input_path, "-") == 0) ? stdin : fopen(input_path, "r");
+    if (in == NULL) {
+        fprintf(stderr, "Cannot open %s\n", input_path);
+        return 1;
+    }
+    out = fopen(output_path, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "Cannot create %s\n", output_path);
+        if (in != stdin) fclose(in);
+        return 1;
+    }
+
+    rc = payroll_binary_convert(in, out, format, &stats);
+
+    if (in != stdin) fclose(in);
+    if (fclose(out) != 0) rc = -1;
+    if (rc != 0) {
+        remove(output_path);
+        return 1;
+    }
+
+    fprintf(stderr, "%lu records converted\n", stats.records);
+    return 0;
+}
+
+/* pphc rules --output rules.pphr [--label TEXT] */
+static int run_rules_export(int argc, char *argv[]) {
+    const char *output_path = NULL;
+    const char *label = NULL;
+    int i;
+
+    for (i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            label = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (output_path == NULL) {
+        fprintf(stderr, "Usage: pphc rules --output rules.pphr [--label TEXT]\n");
+        return 1;
+    }
+
+    if (pph_ruleset_write(NULL, label, output_path) != PPH_OK) {
+        fprintf(stderr, "Error: %s\n", pph_get_last_error());
+        remove(output_path);
+        return 1;
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     pph_result_t *result;
 
@@ -92,6 +299,18 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    if (strcmp(argv[1], "convert") == 0) {
+        return run_convert(argc, argv);
+    }
+
+    if (strcmp(argv[1], "rules") == 0) {
+        return run_rules_export(argc, argv);
+    }
+
+    if (strcmp(argv[1], "pph21") == 0 && argc > 2) {
+        return run_pph21_csv(argc, argv);
+    }
+
     if (strcmp(argv[1], "pph21") == 0) {
         /* Example PPh21 calculation */
         pph21_input_t input;
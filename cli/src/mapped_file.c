@@ -0,0 +1,148 @@
+/*
+ * PPHC Mapped File - Read-only memory-mapped input files
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    /* mmap() and posix_madvise() are hidden in strict C90 mode */
+    #define _POSIX_C_SOURCE 200112L
+#endif
+#if !defined(_FILE_OFFSET_BITS)
+    #define _FILE_OFFSET_BITS 64
+#endif
+
+#include <stddef.h>
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #define MAPPED_FILE_WIN32 1
+#elif defined(__unix__) || defined(__unix) || defined(__APPLE__)
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define MAPPED_FILE_POSIX 1
+#endif
+
+#if defined(MAPPED_FILE_POSIX)
+
+int mapped_file_open(const char *path, mapped_file_t *file) {
+    struct stat st;
+    void *data;
+    int fd;
+
+    file->data = NULL;
+    file->size = 0;
+    file->handle = NULL;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        (pph_uint64_t)st.st_size > (pph_uint64_t)(~(pph_size_t)0)) {
+        close(fd);
+        return -1;
+    }
+
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    data = mmap(NULL, (pph_size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+    /* Aggressive read-ahead; pages behind the reader can be dropped early */
+    posix_madvise(data, (pph_size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+    file->data = (const char*)data;
+    file->size = (pph_size_t)st.st_size;
+    return 0;
+}
+
+void mapped_file_close(mapped_file_t *file) {
+    if (file->data != NULL) {
+        munmap((void*)file->data, file->size);
+    }
+    file->data = NULL;
+    file->size = 0;
+}
+
+#elif defined(MAPPED_FILE_WIN32)
+
+int mapped_file_open(const char *path, mapped_file_t *file) {
+    HANDLE handle, mapping;
+    LARGE_INTEGER size;
+    void *data;
+
+    file->data = NULL;
+    file->size = 0;
+    file->handle = NULL;
+
+    handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                         FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+
+    if (!GetFileSizeEx(handle, &size) ||
+        (pph_uint64_t)size.QuadPart > (pph_uint64_t)(~(pph_size_t)0)) {
+        CloseHandle(handle);
+        return -1;
+    }
+
+    if (size.QuadPart == 0) {
+        CloseHandle(handle);
+        return 0;
+    }
+
+    mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+    if (mapping == NULL) {
+        return -1;
+    }
+
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        CloseHandle(mapping);
+        return -1;
+    }
+
+    file->data = (const char*)data;
+    file->size = (pph_size_t)size.QuadPart;
+    file->handle = mapping;
+    return 0;
+}
+
+void mapped_file_close(mapped_file_t *file) {
+    if (file->data != NULL) {
+        UnmapViewOfFile(file->data);
+        CloseHandle((HANDLE)file->handle);
+    }
+    file->data = NULL;
+    file->size = 0;
+    file->handle = NULL;
+}
+
+#else
+
+int mapped_file_open(const char *path, mapped_file_t *file) {
+    (void)path;
+    file->data = NULL;
+    file->size = 0;
+    file->handle = NULL;
+    return -1;
+}
+
+void mapped_file_close(mapped_file_t *file) {
+    (void)file;
+}
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * PPHC Mapped File - Read-only memory-mapped input files
+ * Copyright (c) 2025 OpenPajak Contributors
+ *
+ * Maps a whole file for sequential reading on POSIX and Win32. Other
+ * targets (DOS, OpenWatcom) report failure and the caller falls back to
+ * stdio.
+ */
+
+#ifndef PPHC_MAPPED_FILE_H
+#define PPHC_MAPPED_FILE_H
+
+#include <pph/pph_types.h>
+
+typedef struct {
+    const char *data;       /* NULL for an empty file */
+    pph_size_t size;
+    void *handle;           /* Platform mapping state */
+} mapped_file_t;
+
+/**
+ * Map a file read-only and advise the kernel it is read sequentially
+ * @return 0 on success, -1 if the file cannot be mapped
+ */
+int mapped_file_open(const char *path, mapped_file_t *file);
+
+/**
+ * Unmap a file opened with mapped_file_open()
+ */
+void mapped_file_close(mapped_file_t *file);
+
+#endif /* PPHC_MAPPED_FILE_H */
@@ -0,0 +1,475 @@
+/*
+ * PPHC Payroll - CSV payroll batch processing for the pphc CLI
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#include <string.h>
+#include "payroll.h"
+
+/* ============================================
+   CSV Fields
+   ============================================ */
+
+int payroll_split_fields(const char *line, pph_size_t len,
+                         payroll_field_t *fields, int max_fields) {
+    const char *p = line;
+    const char *end = line + len;
+    int count = 0;
+
+    while (count < max_fields) {
+        payroll_field_t *field = &fields[count++];
+
+        if (p < end && *p == '"') {
+            /* Quoted: the slice excludes the quotes, "" stays doubled */
+            field->ptr = ++p;
+            for (;;) {
+                if (p == end) {
+                    return -1;
+                }
+                if (*p == '"') {
+                    if (p + 1 == end || p[1] != '"') {
+                        break;
+                    }
+                    p++;
+                }
+                p++;
+            }
+            field->len = (pph_size_t)(p - field->ptr);
+            while (p < end && *p != ',') {
+                p++;
+            }
+        } else {
+            field->ptr = p;
+            while (p < end && *p != ',') {
+                p++;
+            }
+            field->len = (pph_size_t)(p - field->ptr);
+        }
+
+        if (p == end) {
+            break;
+        }
+        p++;
+    }
+
+    return count;
+}
+
+/* ============================================
+   Field Parsers
+   ============================================ */
+
+static int is_blank(payroll_field_t f) {
+    pph_size_t i;
+
+    for (i = 0; i < f.len; i++) {
+        if (f.ptr[i] != ' ' && f.ptr[i] != '\t') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int field_equals(payroll_field_t f, const char *s) {
+    return strlen(s) == f.len && memcmp(f.ptr, s, f.len) == 0;
+}
+
+/* A blank amount is zero; anything else must be one whole amount */
+static int parse_amount(payroll_field_t f, payroll_amount_format_t format, pph_money_t *amount) {
+    pph_size_t consumed;
+
+    if (is_blank(f)) {
+        *amount = PPH_ZERO;
+        return 0;
+    }
+    if (pph_money_parse(f.ptr, f.len,
+                        (format == PAYROLL_AMOUNT_ID) ? PPH_MONEY_FORMAT_ID : PPH_MONEY_FORMAT_PLAIN,
+                        amount, &consumed) != PPH_OK || consumed != f.len) {
+        return -1;
+    }
+    return 0;
+}
+
+static int parse_small_int(payroll_field_t f, int *value) {
+    const char *p = f.ptr;
+    const char *end = f.ptr + f.len;
+    int v = 0, digits = 0;
+
+    while (p < end && *p == ' ') p++;
+    while (p < end && *p >= '0' && *p <= '9' && digits < 4) {
+        v = v * 10 + (*p - '0');
+        p++;
+        digits++;
+    }
+    while (p < end && *p == ' ') p++;
+    if (digits == 0 || p != end) {
+        return -1;
+    }
+    *value = v;
+    return 0;
+}
+
+static int parse_ptkp(payroll_field_t f, pph_ptkp_status_t *status) {
+    const char *p = f.ptr;
+    const char *end = f.ptr + f.len;
+    int married;
+
+    while (p < end && *p == ' ') p++;
+    if (end - p >= 2 && (p[0] == 'T' || p[0] == 't') && (p[1] == 'K' || p[1] == 'k')) {
+        married = 0;
+        p += 2;
+    } else if (p < end && (p[0] == 'K' || p[0] == 'k')) {
+        married = 1;
+        p += 1;
+    } else {
+        return -1;
+    }
+    if (p < end && *p == '/') {
+        p++;
+    }
+    if (end - p != 1 || *p < '0' || *p > '3') {
+        return -1;
+    }
+
+    *status = (pph_ptkp_status_t)(married * 4 + (*p - '0'));
+    return 0;
+}
+
+/* TER category of a PTKP status (PP 58/2023) */
+static pph21_ter_category_t category_for_ptkp(pph_ptkp_status_t status) {
+    switch (status) {
+        case PPH_PTKP_TK0:
+        case PPH_PTKP_TK1:
+        case PPH_PTKP_K0:
+            return PPH21_TER_CATEGORY_A;
+        case PPH_PTKP_K3:
+            return PPH21_TER_CATEGORY_C;
+        default:
+            return PPH21_TER_CATEGORY_B;
+    }
+}
+
+static const char* parse_bonuses(payroll_field_t f, payroll_amount_format_t format,
+                                 payroll_record_t *record) {
+    const char *p = f.ptr;
+    const char *end = f.ptr + f.len;
+    int count = 0;
+
+    while (p < end) {
+        const char *next = memchr(p, ';', (pph_size_t)(end - p));
+        const char *colon;
+        payroll_field_t item, month_field, amount_field;
+        int month;
+
+        if (next == NULL) {
+            next = end;
+        }
+        item.ptr = p;
+        item.len = (pph_size_t)(next - p);
+
+        if (!is_blank(item)) {
+            if (count == PAYROLL_MAX_BONUSES) {
+                return "too many bonuses";
+            }
+            colon = memchr(item.ptr, ':', item.len);
+            if (colon == NULL) {
+                return "bonus must be month:amount";
+            }
+            month_field.ptr = item.ptr;
+            month_field.len = (pph_size_t)(colon - item.ptr);
+            amount_field.ptr = colon + 1;
+            amount_field.len = (pph_size_t)(next - amount_field.ptr);
+
+            if (parse_small_int(month_field, &month) != 0 || month < 1 || month > 12) {
+                return "bad bonus month";
+            }
+
+            if (parse_amount(amount_field, format, &record->bonuses[count].amount) != 0) {
+                return "bad bonus amount";
+            }
+            record->bonuses[count].month = month;
+            strcpy(record->bonuses[count].name, "Bonus");
+            count++;
+        }
+
+        p = next + 1;
+    }
+
+    record->input.bonuses = (count > 0) ? record->bonuses : NULL;
+    record->input.bonus_count = count;
+    return NULL;
+}
+
+void payroll_copy_id(payroll_field_t f, char *id) {
+    pph_size_t i, n = 0;
+
+    for (i = 0; i < f.len && n < PAYROLL_ID_MAX - 1; i++) {
+        id[n++] = f.ptr[i];
+        if (f.ptr[i] == '"' && i + 1 < f.len && f.ptr[i + 1] == '"') {
+            i++;
+        }
+    }
+    id[n] = '\0';
+}
+
+/* ============================================
+   Records
+   ============================================ */
+
+const char* payroll_parse_record(const payroll_field_t *fields, int count,
+                                 payroll_amount_format_t format,
+                                 payroll_record_t *record) {
+    static const payroll_field_t empty = { "", 0 };
+    pph21_input_t *input = &record->input;
+    payroll_field_t field;
+    int value;
+
+    memset(input, 0, sizeof(*input));
+    payroll_copy_id(fields[0], record->id);
+
+    if (count < 6) {
+        return "expected at least 6 fields";
+    }
+
+    input->subject_type = PPH21_PEGAWAI_TETAP;
+
+    if (is_blank(fields[1])) {
+        return "missing bruto_monthly";
+    }
+    if (parse_amount(fields[1], format, &input->bruto_monthly) != 0) {
+        return "bad bruto_monthly";
+    }
+
+    input->months_paid = 12;
+    if (!is_blank(fields[2])) {
+        if (parse_small_int(fields[2], &value) != 0 || value < 1 || value > 12) {
+            return "bad months_paid";
+        }
+        input->months_paid = value;
+    }
+
+    if (parse_amount(fields[3], format, &input->pension_contribution) != 0) {
+        return "bad pension";
+    }
+    if (parse_amount(fields[4], format, &input->zakat_or_donation) != 0) {
+        return "bad zakat";
+    }
+
+    if (parse_ptkp(fields[5], &input->ptkp_status) != 0) {
+        return "bad ptkp";
+    }
+
+    field = (count > 6) ? fields[6] : empty;
+    if (is_blank(field) || field_equals(field, "TER") || field_equals(field, "ter")) {
+        input->scheme = PPH21_SCHEME_TER;
+    } else if (field_equals(field, "LAMA") || field_equals(field, "lama")) {
+        input->scheme = PPH21_SCHEME_LAMA;
+    } else {
+        return "bad scheme";
+    }
+
+    field = (count > 7) ? fields[7] : empty;
+    if (is_blank(field)) {
+        input->ter_category = category_for_ptkp(input->ptkp_status);
+    } else if (field.len == 1 && field.ptr[0] >= 'A' && field.ptr[0] <= 'C') {
+        input->ter_category = (pph21_ter_category_t)(field.ptr[0] - 'A');
+    } else {
+        return "bad ter_category";
+    }
+
+    if (count > 8) {
+        return parse_bonuses(fields[8], format, record);
+    }
+    return NULL;
+}
+
+/* Write a field, quoting it when it holds a delimiter or quote */
+static void write_field(FILE *out, const char *s) {
+    if (strpbrk(s, ",\"\r\n") == NULL) {
+        fputs(s, out);
+        return;
+    }
+
+    fputc('"', out);
+    for (; *s != '\0'; s++) {
+        if (*s == '"') {
+            fputc('"', out);
+        }
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+void payroll_write_result(FILE *out, const char *id,
+                          const pph21_summary_t *summary, const char *error) {
+    char line[3 * PPH_MONEY_FORMAT_MAX + 8];
+    pph_size_t len;
+
+    write_field(out, id);
+
+    if (error != NULL) {
+        fputs(",,,,", out);
+        write_field(out, error);
+        fputc('\n', out);
+        return;
+    }
+
+    /* The three amounts become one ",tax,ter,adj,OK\n" write */
+    line[0] = ',';
+    len = 1;
+    len += pph_money_format(summary->total_tax, PPH_MONEY_FORMAT_PLAIN, line + len, sizeof(line) - len);
+    line[len++] = ',';
+    len += pph_money_format(summary->ter_paid, PPH_MONEY_FORMAT_PLAIN, line + len, sizeof(line) - len);
+    line[len++] = ',';
+    len += pph_money_format(summary->adjustment, PPH_MONEY_FORMAT_PLAIN, line + len, sizeof(line) - len);
+    memcpy(line + len, ",OK\n", 4);
+    fwrite(line, 1, len + 4, out);
+}
+
+const char* payroll_status_error(pph_status_t status) {
+    /* The kernel works on parsed records, so the range check is its only
+       per-record failure; the text is the one pph21_calculate_summary()
+       sets */
+    switch (status) {
+        case PPH_OK:
+            return NULL;
+        case PPH_ERR_OVERFLOW:
+            return "Amounts out of range";
+        default:
+            return "Calculation failed";
+    }
+}
+
+/* ============================================
+   Drivers
+   ============================================ */
+
+void payroll_write_header(FILE *out) {
+    fprintf(out, "id,total_tax,ter_paid,adjustment,status\n");
+}
+
+/* Parse one line (without its line terminator) and hand it to fn */
+static int process_line(const char *line, pph_size_t len, const char *error,
+                        payroll_amount_format_t format,
+                        payroll_record_fn fn, void *ctx) {
+    static payroll_record_t record;
+    payroll_field_t fields[PAYROLL_FIELD_COUNT];
+    int count;
+
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;
+    }
+    if (len == 0 && error == NULL) {
+        return 0;
+    }
+
+    record.id[0] = '\0';
+
+    if (error == NULL) {
+        count = payroll_split_fields(line, len, fields, PAYROLL_FIELD_COUNT);
+        error = (count < 0) ? "unterminated quote"
+                            : payroll_parse_record(fields, count, format, &record);
+    }
+
+    return fn(ctx, &record, error);
+}
+
+/* Read one line into buf; a line longer than the buffer is consumed
+   whole and reported as too long. Returns 0 at end of input. */
+static int read_line(FILE *in, char *buf, int size, pph_size_t *len, int *too_long) {
+    int c;
+
+    if (fgets(buf, size, in) == NULL) {
+        return 0;
+    }
+
+    *len = strlen(buf);
+    *too_long = 0;
+    if (*len > 0 && buf[*len - 1] == '\n') {
+        (*len)--;
+    } else if (!feof(in)) {
+        *too_long = 1;
+        while ((c = fgetc(in)) != EOF && c != '\n') {
+        }
+    }
+    return 1;
+}
+
+static int quote_open(const char *line, pph_size_t len) {
+    int open = 0;
+    pph_size_t i;
+
+    for (i = 0; i < len; i++) {
+        open ^= (line[i] == '"');
+    }
+    return open;
+}
+
+int payroll_read_csv(FILE *in, payroll_amount_format_t format,
+                     payroll_record_fn fn, void *ctx) {
+    static char line[PAYROLL_LINE_MAX];
+    pph_size_t len;
+    int too_long;
+
+    /* Header */
+    if (!read_line(in, line, sizeof(line), &len, &too_long)) {
+        return ferror(in) ? -1 : 0;
+    }
+
+    while (read_line(in, line, sizeof(line), &len, &too_long)) {
+        pph_size_t more;
+
+        /* A quoted field may hold a newline: keep reading while a quote
+           is open, as the mapped reader does */
+        while (!too_long && quote_open(line, len) && len + 2 < sizeof(line) &&
+               read_line(in, line + len + 1, (int)(sizeof(line) - len - 1), &more, &too_long)) {
+            line[len] = '\n';
+            len += 1 + more;
+        }
+
+        if (process_line(line, len, too_long ? "line too long" : NULL, format, fn, ctx) != 0) {
+            return 1;
+        }
+    }
+
+    return ferror(in) ? -1 : 0;
+}
+
+typedef struct {
+    FILE *out;
+    payroll_stats_t *stats;
+} calculate_ctx_t;
+
+/* Calculate one record and write its result line */
+static int calculate_record(void *ctx, payroll_record_t *record, const char *error) {
+    calculate_ctx_t *calc = (calculate_ctx_t*)ctx;
+    pph21_summary_t summary;
+
+    calc->stats->records++;
+
+    if (error == NULL && pph21_calculate_summary(&record->input, &summary) != PPH_OK) {
+        error = pph_get_last_error();
+    }
+
+    if (error != NULL) {
+        calc->stats->failed++;
+    }
+    payroll_write_result(calc->out, record->id, &summary, error);
+    return 0;
+}
+
+int payroll_run_csv(FILE *in, FILE *out, payroll_amount_format_t format,
+                    payroll_stats_t *stats) {
+    calculate_ctx_t calc;
+    int rc;
+
+    stats->records = 0;
+    stats->failed = 0;
+    calc.out = out;
+    calc.stats = stats;
+
+    payroll_write_header(out);
+    rc = payroll_read_csv(in, format, calculate_record, &calc);
+
+    return (rc != 0 || ferror(out)) ? -1 : 0;
+}
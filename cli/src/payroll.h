@@ -0,0 +1,126 @@
+/*
+ * PPHC Payroll - CSV payroll batch processing for the pphc CLI
+ * Copyright (c) 2025 OpenPajak Contributors
+ *
+ * Input is one employee per line after a header line:
+ *
+ *   id,bruto_monthly,months_paid,pension,zakat,ptkp,scheme,ter_category,bonuses
+ *
+ *   ptkp          TK/0..TK/3, K/0..K/3
+ *   scheme        TER (default) or LAMA
+ *   ter_category  A, B or C; empty picks the category of the PTKP status
+ *   bonuses       month:amount pairs separated by ';', e.g. 4:12000000;12:5000000
+ *
+ * Empty months_paid, pension, zakat and bonuses default to 12, 0, 0 and
+ * none. Fields may be quoted, which Indonesian-format amounts
+ * ("10.000.000,50") need. Output is one line per input record:
+ *
+ *   id,total_tax,ter_paid,adjustment,status
+ */
+
+#ifndef PPHC_PAYROLL_H
+#define PPHC_PAYROLL_H
+
+#include <stdio.h>
+#include <pph/pph_calculator.h>
+
+#define PAYROLL_LINE_MAX 4096
+#define PAYROLL_FIELD_COUNT 9
+#define PAYROLL_MAX_BONUSES 32
+#define PAYROLL_ID_MAX 64
+
+typedef enum {
+    PAYROLL_AMOUNT_PLAIN = 0,   /* 10000000.50 (PPH_MONEY_FORMAT_PLAIN) */
+    PAYROLL_AMOUNT_ID           /* 10.000.000,50 (PPH_MONEY_FORMAT_ID) */
+} payroll_amount_format_t;
+
+/* A field as a slice of the input; not NUL-terminated */
+typedef struct {
+    const char *ptr;
+    pph_size_t len;
+} payroll_field_t;
+
+typedef struct {
+    char id[PAYROLL_ID_MAX];
+    pph21_input_t input;
+    pph21_bonus_t bonuses[PAYROLL_MAX_BONUSES];
+} payroll_record_t;
+
+typedef struct {
+    unsigned long records;
+    unsigned long failed;
+} payroll_stats_t;
+
+/**
+ * Split a CSV line into field slices without copying
+ * Quoted fields exclude their quotes; "" inside them is left doubled.
+ * @param len Line length without the line terminator
+ * @return Number of fields, or -1 on an unterminated quote
+ */
+int payroll_split_fields(const char *line, pph_size_t len,
+                         payroll_field_t *fields, int max_fields);
+
+/**
+ * Build a calculator input from the fields of one line
+ * @return NULL on success, otherwise a short description of the error
+ */
+const char* payroll_parse_record(const payroll_field_t *fields, int count,
+                                 payroll_amount_format_t format,
+                                 payroll_record_t *record);
+
+/**
+ * Copy an id field into id (PAYROLL_ID_MAX bytes), folding "" into "
+ */
+void payroll_copy_id(payroll_field_t field, char *id);
+
+/**
+ * Write the output header line
+ */
+void payroll_write_header(FILE *out);
+
+/**
+ * Write one result line; error is NULL for a successful record
+ */
+void payroll_write_result(FILE *out, const char *id,
+                          const pph21_summary_t *summary, const char *error);
+
+/**
+ * Error text for a record the columns kernel rejected, as the per-record
+ * path would report it; NULL for PPH_OK
+ */
+const char* payroll_status_error(pph_status_t status);
+
+/**
+ * Called for each record read; error is non-NULL when the line could not
+ * be parsed (record->id is still filled in when possible)
+ * @return 0 to continue reading, non-zero to stop
+ */
+typedef int (*payroll_record_fn)(void *ctx, payroll_record_t *record, const char *error);
+
+/**
+ * Read a payroll CSV stream after its header line, one record at a time
+ * @return 0 at end of input, 1 when fn stopped early, -1 on an I/O error
+ */
+int payroll_read_csv(FILE *in, payroll_amount_format_t format,
+                     payroll_record_fn fn, void *ctx);
+
+/**
+ * Stream a payroll CSV through the calculator, one record at a time
+ * @return 0 on success, -1 on an I/O error
+ */
+int payroll_run_csv(FILE *in, FILE *out, payroll_amount_format_t format,
+                    payroll_stats_t *stats);
+
+/**
+ * Calculate a payroll CSV held in memory (e.g. a mapped file) on a pool
+ * The input is cut into ranges that end on record boundaries (quoted
+ * newlines included), each range is parsed into columns and calculated
+ * by its own task, and results are written in input order. Lines have
+ * no length limit.
+ * @return 0 on success, -1 on an I/O or allocation error
+ */
+int payroll_run_parallel(const char *data, pph_size_t size, FILE *out,
+                         payroll_amount_format_t format, pph_executor_t *executor,
+                         payroll_stats_t *stats);
+
+#endif /* PPHC_PAYROLL_H */
@@ -0,0 +1,503 @@
+/*
+ * PPHC Payroll Binary - Columnar binary payroll files
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "payroll_binary.h"
+
+/* Records per calculation task; results for one window of tasks are
+   buffered, written, then reused */
+#define BINARY_TASK_RECORDS 16384
+#define BINARY_TASKS_PER_THREAD 4
+
+#define ALIGN8(x) (((x) + 7) & ~(pph_uint64_t)7)
+
+typedef struct {
+    pph_uint64_t bruto;
+    pph_uint64_t pension;
+    pph_uint64_t zakat;
+    pph_uint64_t bonuses;
+    pph_uint64_t bonus_start;
+    pph_uint64_t id_start;
+    pph_uint64_t months;
+    pph_uint64_t ptkp;
+    pph_uint64_t scheme;
+    pph_uint64_t category;
+    pph_uint64_t ids;
+    pph_uint64_t total;
+} binary_layout_t;
+
+static void compute_layout(pph_uint64_t count, pph_uint64_t bonus_count,
+                           pph_uint64_t id_bytes, binary_layout_t *layout) {
+    pph_uint64_t offset = sizeof(payroll_binary_header_t);
+
+    layout->bruto = offset;       offset = ALIGN8(offset + count * 8);
+    layout->pension = offset;     offset = ALIGN8(offset + count * 8);
+    layout->zakat = offset;       offset = ALIGN8(offset + count * 8);
+    layout->bonuses = offset;     offset = ALIGN8(offset + bonus_count * sizeof(payroll_binary_bonus_t));
+    layout->bonus_start = offset; offset = ALIGN8(offset + (count + 1) * 4);
+    layout->id_start = offset;    offset = ALIGN8(offset + (count + 1) * 4);
+    layout->months = offset;      offset = ALIGN8(offset + count);
+    layout->ptkp = offset;        offset = ALIGN8(offset + count);
+    layout->scheme = offset;      offset = ALIGN8(offset + count);
+    layout->category = offset;    offset = ALIGN8(offset + count);
+    layout->ids = offset;         offset = ALIGN8(offset + id_bytes);
+    layout->total = offset;
+}
+
+int payroll_binary_detect(const char *data, pph_size_t size) {
+    return size >= sizeof(payroll_binary_header_t) &&
+           memcmp(data, PAYROLL_BINARY_MAGIC, 4) == 0;
+}
+
+/* ============================================
+   Conversion
+   ============================================ */
+
+typedef struct {
+    pph_size_t count;
+    pph_size_t capacity;
+    pph_int64_t *bruto;
+    pph_int64_t *pension;
+    pph_int64_t *zakat;
+    pph_uint32_t *bonus_start;
+    pph_uint32_t *id_start;
+    pph_uint8_t *months;
+    pph_uint8_t *ptkp;
+    pph_uint8_t *scheme;
+    pph_uint8_t *category;
+
+    payroll_binary_bonus_t *bonuses;
+    pph_size_t bonus_count;
+    pph_size_t bonus_capacity;
+
+    char *ids;
+    pph_size_t id_bytes;
+    pph_size_t id_capacity;
+
+    payroll_stats_t *stats;
+    const char *error;
+} binary_builder_t;
+
+static int grow(void **array, pph_size_t capacity, pph_size_t element) {
+    void *p = realloc(*array, capacity * element);
+
+    if (p == NULL) {
+        return -1;
+    }
+    *array = p;
+    return 0;
+}
+
+static int builder_reserve(binary_builder_t *b, pph_size_t count) {
+    pph_size_t cap = b->capacity ? b->capacity : 4096;
+
+    if (count <= b->capacity) {
+        return 0;
+    }
+    while (cap < count) {
+        cap *= 2;
+    }
+
+    if (grow((void**)&b->bruto, cap, sizeof(*b->bruto)) != 0 ||
+        grow((void**)&b->pension, cap, sizeof(*b->pension)) != 0 ||
+        grow((void**)&b->zakat, cap, sizeof(*b->zakat)) != 0 ||
+        grow((void**)&b->bonus_start, cap + 1, sizeof(*b->bonus_start)) != 0 ||
+        grow((void**)&b->id_start, cap + 1, sizeof(*b->id_start)) != 0 ||
+        grow((void**)&b->months, cap, sizeof(*b->months)) != 0 ||
+        grow((void**)&b->ptkp, cap, sizeof(*b->ptkp)) != 0 ||
+        grow((void**)&b->scheme, cap, sizeof(*b->scheme)) != 0 ||
+        grow((void**)&b->category, cap, sizeof(*b->category)) != 0) {
+        return -1;
+    }
+    b->capacity = cap;
+    return 0;
+}
+
+static int builder_reserve_bytes(void **array, pph_size_t *capacity, pph_size_t needed,
+                                 pph_size_t element) {
+    pph_size_t cap = *capacity ? *capacity : 4096;
+
+    if (needed <= *capacity) {
+        return 0;
+    }
+    while (cap < needed) {
+        cap *= 2;
+    }
+    if (grow(array, cap, element) != 0) {
+        return -1;
+    }
+    *capacity = cap;
+    return 0;
+}
+
+static void builder_free(binary_builder_t *b) {
+    free(b->bruto);
+    free(b->pension);
+    free(b->zakat);
+    free(b->bonus_start);
+    free(b->id_start);
+    free(b->months);
+    free(b->ptkp);
+    free(b->scheme);
+    free(b->category);
+    free(b->bonuses);
+    free(b->ids);
+}
+
+static int builder_append(void *ctx, payroll_record_t *record, const char *error) {
+    binary_builder_t *b = (binary_builder_t*)ctx;
+    const pph21_input_t *input = &record->input;
+    pph_size_t i = b->count;
+    pph_size_t id_len = strlen(record->id);
+    int k;
+
+    b->stats->records++;
+
+    if (error != NULL) {
+        fprintf(stderr, "Record %lu (%s): %s\n", b->stats->records, record->id, error);
+        b->stats->failed++;
+        b->error = error;
+        return 1;
+    }
+
+    if (builder_reserve(b, i + 1) != 0 ||
+        builder_reserve_bytes((void**)&b->bonuses, &b->bonus_capacity,
+                              b->bonus_count + (pph_size_t)input->bonus_count,
+                              sizeof(*b->bonuses)) != 0 ||
+        builder_reserve_bytes((void**)&b->ids, &b->id_capacity, b->id_bytes + id_len, 1) != 0) {
+        b->error = "out of memory";
+        return 1;
+    }
+
+    if (b->id_bytes + id_len > 0xFFFFFFFFUL || b->bonus_count + (pph_size_t)input->bonus_count > 0xFFFFFFFFUL) {
+        b->error = "payroll too large for the binary format";
+        return 1;
+    }
+
+    if (i == 0) {
+        b->bonus_start[0] = 0;
+        b->id_start[0] = 0;
+    }
+
+    b->bruto[i] = input->bruto_monthly.value;
+    b->pension[i] = input->pension_contribution.value;
+    b->zakat[i] = input->zakat_or_donation.value;
+    b->months[i] = (pph_uint8_t)input->months_paid;
+    b->ptkp[i] = (pph_uint8_t)input->ptkp_status;
+    b->scheme[i] = (pph_uint8_t)input->scheme;
+    b->category[i] = (pph_uint8_t)input->ter_category;
+
+    for (k = 0; k < input->bonus_count; k++) {
+        payroll_binary_bonus_t *bonus = &b->bonuses[b->bonus_count++];
+
+        memset(bonus, 0, sizeof(*bonus));
+        bonus->amount = input->bonuses[k].amount.value;
+        bonus->month = (pph_uint8_t)input->bonuses[k].month;
+    }
+    b->bonus_start[i + 1] = (pph_uint32_t)b->bonus_count;
+
+    memcpy(b->ids + b->id_bytes, record->id, id_len);
+    b->id_bytes += id_len;
+    b->id_start[i + 1] = (pph_uint32_t)b->id_bytes;
+
+    b->count = i + 1;
+    return 0;
+}
+
+/* Write a column and pad the file to the next 8-byte boundary */
+static int write_column(FILE *out, const void *data, pph_uint64_t bytes) {
+    static const char zeros[8] = { 0 };
+
+    if (bytes > 0 && fwrite(data, 1, (pph_size_t)bytes, out) != (pph_size_t)bytes) {
+        return -1;
+    }
+    if (ALIGN8(bytes) != bytes &&
+        fwrite(zeros, 1, (pph_size_t)(ALIGN8(bytes) - bytes), out) != (pph_size_t)(ALIGN8(bytes) - bytes)) {
+        return -1;
+    }
+    return 0;
+}
+
+int payroll_binary_convert(FILE *in, FILE *out, payroll_amount_format_t format,
+                           payroll_stats_t *stats) {
+    static const pph_uint32_t zero_start = 0;
+    payroll_binary_header_t header;
+    binary_builder_t b;
+    pph_uint64_t n;
+    int rc;
+
+    memset(&b, 0, sizeof(b));
+    stats->records = 0;
+    stats->failed = 0;
+    b.stats = stats;
+
+    rc = payroll_read_csv(in, format, builder_append, &b);
+    if (rc != 0) {
+        if (b.error == NULL) {
+            fprintf(stderr, "Read error\n");
+        } else if (stats->failed == 0) {
+            fprintf(stderr, "Error: %s\n", b.error);
+        }
+        builder_free(&b);
+        return -1;
+    }
+
+    n = (pph_uint64_t)b.count;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PAYROLL_BINARY_MAGIC, 4);
+    header.version = PAYROLL_BINARY_VERSION;
+    header.header_size = (pph_uint16_t)sizeof(header);
+    header.byte_order = (pph_uint32_t)PAYROLL_BINARY_BYTE_ORDER;
+    header.count = n;
+    header.bonus_count = (pph_uint64_t)b.bonus_count;
+    header.id_bytes = (pph_uint64_t)b.id_bytes;
+
+    rc = (fwrite(&header, sizeof(header), 1, out) == 1) ? 0 : -1;
+    if (rc == 0) rc = write_column(out, b.bruto, n * 8);
+    if (rc == 0) rc = write_column(out, b.pension, n * 8);
+    if (rc == 0) rc = write_column(out, b.zakat, n * 8);
+    if (rc == 0) rc = write_column(out, b.bonuses, header.bonus_count * sizeof(payroll_binary_bonus_t));
+    if (rc == 0) rc = write_column(out, n ? (const void*)b.bonus_start : &zero_start, (n + 1) * 4);
+    if (rc == 0) rc = write_column(out, n ? (const void*)b.id_start : &zero_start, (n + 1) * 4);
+    if (rc == 0) rc = write_column(out, b.months, n);
+    if (rc == 0) rc = write_column(out, b.ptkp, n);
+    if (rc == 0) rc = write_column(out, b.scheme, n);
+    if (rc == 0) rc = write_column(out, b.category, n);
+    if (rc == 0) rc = write_column(out, b.ids, header.id_bytes);
+
+    if (rc != 0) {
+        fprintf(stderr, "Write error\n");
+    }
+
+    builder_free(&b);
+    return rc;
+}
+
+/* ============================================
+   Loading
+   ============================================ */
+
+typedef struct {
+    pph_size_t count;
+    const pph_int64_t *bruto;
+    const pph_int64_t *pension;
+    const pph_int64_t *zakat;
+    const pph_uint32_t *bonus_start;
+    const pph_uint32_t *id_start;
+    const pph_uint8_t *months;
+    const pph_uint8_t *ptkp;
+    const pph_uint8_t *scheme;
+    const pph_uint8_t *category;
+    const char *ids;
+    pph21_bonus_t *bonuses;     /* Expanded from the side table */
+} binary_view_t;
+
+/* Map the columns of a file onto a view, checking everything the kernel
+   relies on so that a damaged file cannot index out of bounds */
+static const char* binary_open(const char *data, pph_size_t size, binary_view_t *view) {
+    const payroll_binary_header_t *header = (const payroll_binary_header_t*)data;
+    const payroll_binary_bonus_t *bonuses;
+    binary_layout_t layout;
+    pph_size_t i, n, bonus_count;
+
+    if (!payroll_binary_detect(data, size)) {
+        return "not a payroll binary file";
+    }
+    if (header->byte_order != (pph_uint32_t)PAYROLL_BINARY_BYTE_ORDER) {
+        return "file was written with a different byte order";
+    }
+    if (header->version != PAYROLL_BINARY_VERSION || header->header_size != sizeof(*header)) {
+        return "unsupported file version";
+    }
+    if (header->count > 0xFFFFFFFFUL || header->bonus_count > 0xFFFFFFFFUL ||
+        header->id_bytes > 0xFFFFFFFFUL) {
+        return "file is truncated";
+    }
+
+    compute_layout(header->count, header->bonus_count, header->id_bytes, &layout);
+    if (layout.total > (pph_uint64_t)size) {
+        return "file is truncated";
+    }
+
+    n = (pph_size_t)header->count;
+    bonus_count = (pph_size_t)header->bonus_count;
+
+    view->count = n;
+    view->bruto = (const pph_int64_t*)(data + layout.bruto);
+    view->pension = (const pph_int64_t*)(data + layout.pension);
+    view->zakat = (const pph_int64_t*)(data + layout.zakat);
+    view->bonus_start = (const pph_uint32_t*)(data + layout.bonus_start);
+    view->id_start = (const pph_uint32_t*)(data + layout.id_start);
+    view->months = (const pph_uint8_t*)(data + layout.months);
+    view->ptkp = (const pph_uint8_t*)(data + layout.ptkp);
+    view->scheme = (const pph_uint8_t*)(data + layout.scheme);
+    view->category = (const pph_uint8_t*)(data + layout.category);
+    view->ids = data + layout.ids;
+    view->bonuses = NULL;
+
+    if (view->bonus_start[0] != 0 || view->bonus_start[n] != bonus_count ||
+        view->id_start[0] != 0 || view->id_start[n] != header->id_bytes) {
+        return "corrupt offset table";
+    }
+    for (i = 0; i < n; i++) {
+        if (view->bonus_start[i] > view->bonus_start[i + 1] ||
+            view->id_start[i] > view->id_start[i + 1]) {
+            return "corrupt offset table";
+        }
+        if (view->months[i] < 1 || view->months[i] > 12 || view->ptkp[i] > PPH_PTKP_K3 ||
+            view->scheme[i] > PPH21_SCHEME_TER || view->category[i] > PPH21_TER_CATEGORY_C) {
+            return "corrupt record";
+        }
+    }
+
+    bonuses = (const payroll_binary_bonus_t*)(data + layout.bonuses);
+    for (i = 0; i < bonus_count; i++) {
+        if (bonuses[i].month < 1 || bonuses[i].month > 12) {
+            return "corrupt record";
+        }
+    }
+
+    /* The kernel takes pph21_bonus_t, which carries a name; bonuses are
+       rare enough that expanding the side table costs nothing */
+    if (bonus_count > 0) {
+        view->bonuses = (pph21_bonus_t*)malloc(bonus_count * sizeof(pph21_bonus_t));
+        if (view->bonuses == NULL) {
+            return "out of memory";
+        }
+        for (i = 0; i < bonus_count; i++) {
+            view->bonuses[i].month = bonuses[i].month;
+            view->bonuses[i].amount.value = bonuses[i].amount;
+            strcpy(view->bonuses[i].name, "Bonus");
+        }
+    }
+
+    return NULL;
+}
+
+/* ============================================
+   Calculation
+   ============================================ */
+
+typedef struct {
+    const binary_view_t *view;
+    pph_size_t base;            /* First record of the window */
+    pph_size_t count;           /* Records in the window */
+    pph_int64_t *total_tax;
+    pph_int64_t *ter_paid;
+    pph_int64_t *adjustment;
+    pph_uint8_t *status;
+} binary_job_t;
+
+static void binary_task(void *ctx, int worker, pph_size_t task) {
+    binary_job_t *job = (binary_job_t*)ctx;
+    const binary_view_t *view = job->view;
+    pph_size_t offset = task * BINARY_TASK_RECORDS;
+    pph_size_t first = job->base + offset;
+    pph21_columns_t columns;
+    pph21_column_results_t results;
+
+    (void)worker;
+    if (offset >= job->count) {
+        return;
+    }
+
+    columns.count = (job->count - offset < BINARY_TASK_RECORDS) ? job->count - offset : BINARY_TASK_RECORDS;
+    columns.bruto_monthly = view->bruto + first;
+    columns.pension_contribution = view->pension + first;
+    columns.zakat_or_donation = view->zakat + first;
+    columns.months_paid = view->months + first;
+    columns.ptkp_status = view->ptkp + first;
+    columns.scheme = view->scheme + first;
+    columns.ter_category = view->category + first;
+    columns.bonus_start = view->bonuses ? view->bonus_start + first : NULL;
+    columns.bonuses = view->bonuses;
+
+    results.total_tax = job->total_tax + offset;
+    results.ter_paid = job->ter_paid + offset;
+    results.adjustment = job->adjustment + offset;
+    results.status = job->status + offset;
+
+    pph21_calculate_columns(&columns, &results);
+}
+
+int payroll_binary_run(const char *data, pph_size_t size, FILE *out,
+                       pph_executor_t *executor, payroll_stats_t *stats) {
+    binary_view_t view;
+    binary_job_t job;
+    pph21_summary_t summary;
+    char id[PAYROLL_ID_MAX];
+    pph_size_t id_len;
+    const char *error;
+    pph_size_t tasks, window, i;
+
+    stats->records = 0;
+    stats->failed = 0;
+
+    error = binary_open(data, size, &view);
+    if (error != NULL) {
+        fprintf(stderr, "Error: %s\n", error);
+        return -1;
+    }
+
+    tasks = (pph_size_t)pph_executor_thread_count(executor) * BINARY_TASKS_PER_THREAD;
+    window = tasks * BINARY_TASK_RECORDS;
+
+    job.view = &view;
+    job.total_tax = (pph_int64_t*)malloc(window * sizeof(pph_int64_t));
+    job.ter_paid = (pph_int64_t*)malloc(window * sizeof(pph_int64_t));
+    job.adjustment = (pph_int64_t*)malloc(window * sizeof(pph_int64_t));
+    job.status = (pph_uint8_t*)malloc(window);
+    if (job.total_tax == NULL || job.ter_paid == NULL || job.adjustment == NULL ||
+        job.status == NULL) {
+        free(job.total_tax);
+        free(job.ter_paid);
+        free(job.adjustment);
+        free(job.status);
+        free(view.bonuses);
+        fprintf(stderr, "Error: out of memory\n");
+        return -1;
+    }
+
+    payroll_write_header(out);
+
+    for (job.base = 0; job.base < view.count; job.base += window) {
+        job.count = (view.count - job.base < window) ? view.count - job.base : window;
+        pph_executor_run(executor, binary_task, &job,
+                         (job.count + BINARY_TASK_RECORDS - 1) / BINARY_TASK_RECORDS);
+
+        for (i = 0; i < job.count; i++) {
+            pph_size_t r = job.base + i;
+
+            /* Ids are stored unescaped */
+            id_len = view.id_start[r + 1] - view.id_start[r];
+            if (id_len > PAYROLL_ID_MAX - 1) {
+                id_len = PAYROLL_ID_MAX - 1;
+            }
+            memcpy(id, view.ids + view.id_start[r], id_len);
+            id[id_len] = '\0';
+
+            summary.total_tax.value = job.total_tax[i];
+            summary.ter_paid.value = job.ter_paid[i];
+            summary.adjustment.value = job.adjustment[i];
+
+            error = payroll_status_error((pph_status_t)job.status[i]);
+            if (error != NULL) {
+                stats->failed++;
+            }
+            payroll_write_result(out, id, &summary, error);
+        }
+        stats->records += (unsigned long)job.count;
+    }
+
+    free(job.total_tax);
+    free(job.ter_paid);
+    free(job.adjustment);
+    free(job.status);
+    free(view.bonuses);
+
+    return ferror(out) ? -1 : 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * PPHC Payroll Binary - Columnar binary payroll files
+ * Copyright (c) 2025 OpenPajak Contributors
+ *
+ * A payroll converted once with `pphc convert` can be mapped and handed to
+ * pph21_calculate_columns() without parsing. The file is a header followed
+ * by fixed-width columns, each starting on an 8-byte boundary:
+ *
+ *   header                  payroll_binary_header_t (64 bytes)
+ *   bruto_monthly           pph_int64_t[count]    (money units, 1/10000 Rp)
+ *   pension_contribution    pph_int64_t[count]
+ *   zakat_or_donation       pph_int64_t[count]
+ *   bonuses                 payroll_binary_bonus_t[bonus_count]
+ *   bonus_start             pph_uint32_t[count + 1]
+ *   id_start                pph_uint32_t[count + 1]
+ *   months_paid             pph_uint8_t[count]
+ *   ptkp_status             pph_uint8_t[count]    (pph_ptkp_status_t)
+ *   scheme                  pph_uint8_t[count]    (pph21_scheme_t)
+ *   ter_category            pph_uint8_t[count]    (pph21_ter_category_t)
+ *   ids                     char[id_bytes]        (not NUL-terminated)
+ *
+ * Values are in the byte order of the machine that wrote the file; a file
+ * from the other byte order is rejected.
+ */
+
+#ifndef PPHC_PAYROLL_BINARY_H
+#define PPHC_PAYROLL_BINARY_H
+
+#include <stdio.h>
+#include <pph/pph_calculator.h>
+#include "payroll.h"
+
+#define PAYROLL_BINARY_MAGIC "PPHB"
+#define PAYROLL_BINARY_VERSION 1
+#define PAYROLL_BINARY_BYTE_ORDER 0x01020304UL
+
+typedef struct {
+    char magic[4];
+    pph_uint16_t version;
+    pph_uint16_t header_size;
+    pph_uint32_t byte_order;
+    pph_uint32_t reserved;
+    pph_uint64_t count;
+    pph_uint64_t bonus_count;
+    pph_uint64_t id_bytes;
+    pph_uint64_t reserved2[3];
+} payroll_binary_header_t;
+
+typedef struct {
+    pph_int64_t amount;
+    pph_uint8_t month;
+    pph_uint8_t pad[7];
+} payroll_binary_bonus_t;
+
+/**
+ * Check whether a buffer starts with a payroll binary header
+ */
+int payroll_binary_detect(const char *data, pph_size_t size);
+
+/**
+ * Convert a payroll CSV stream into a binary payroll file
+ * Unlike the calculator, conversion stops at the first bad record.
+ * @return 0 on success, -1 on error (reported on stderr)
+ */
+int payroll_binary_convert(FILE *in, FILE *out, payroll_amount_format_t format,
+                           payroll_stats_t *stats);
+
+/**
+ * Calculate a mapped binary payroll file on a pool
+ * Output is the same as for the CSV the file was converted from.
+ * @return 0 on success, -1 on a malformed file, I/O or allocation error
+ */
+int payroll_binary_run(const char *data, pph_size_t size, FILE *out,
+                       pph_executor_t *executor, payroll_stats_t *stats);
+
+#endif /* PPHC_PAYROLL_BINARY_H */
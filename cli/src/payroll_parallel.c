@@ -0,0 +1,419 @@
+/*
+ * PPHC Payroll - Parallel columnar processing of in-memory payroll CSV
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "payroll.h"
+
+/* Bytes of CSV per task and tasks per worker in each window. A window is
+   parsed, calculated and written before the next one starts, so memory
+   stays bounded by the window size rather than the file size. Windows
+   never exceed 512 MB, however many workers there are; tasks then get
+   smaller than PARALLEL_TASK_BYTES. */
+#define PARALLEL_TASK_BYTES ((pph_size_t)4 << 20)
+#define PARALLEL_TASKS_PER_THREAD 4
+#define PARALLEL_WINDOW_MAX ((pph_size_t)512 << 20)
+
+typedef struct {
+    /* Raw byte range for the quote count, then the aligned record range */
+    const char *begin;
+    const char *end;
+    pph_size_t quotes;
+
+    /* Columns for the records of the range */
+    pph_size_t count;
+    pph_size_t capacity;
+    payroll_field_t *ids;
+    const char **errors;
+    pph_int64_t *bruto;
+    pph_int64_t *pension;
+    pph_int64_t *zakat;
+    pph_uint8_t *months;
+    pph_uint8_t *ptkp;
+    pph_uint8_t *scheme;
+    pph_uint8_t *category;
+    pph_uint32_t *bonus_start;
+    pph21_bonus_t *bonuses;
+    pph_size_t bonus_count;
+    pph_size_t bonus_capacity;
+
+    pph_int64_t *total_tax;
+    pph_int64_t *ter_paid;
+    pph_int64_t *adjustment;
+    pph_uint8_t *status;
+
+    int out_of_memory;
+} parallel_chunk_t;
+
+typedef struct {
+    parallel_chunk_t *chunks;
+    payroll_amount_format_t format;
+} parallel_job_t;
+
+/* ============================================
+   Record Boundaries
+   ============================================ */
+
+/* End of the record starting at p: just past the first newline outside
+   quotes, or end. in_quotes is the quote state at p. */
+static const char* record_end(const char *p, const char *end, int in_quotes) {
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (pph_size_t)(end - p));
+
+        if (nl == NULL) {
+            nl = end;
+        }
+
+        /* Fast path: no quote open and none before the newline */
+        if (!in_quotes && memchr(p, '"', (pph_size_t)(nl - p)) == NULL) {
+            return (nl < end) ? nl + 1 : end;
+        }
+
+        for (; p < nl; p++) {
+            if (*p == '"') {
+                in_quotes = !in_quotes;
+            }
+        }
+        if (nl == end) {
+            return end;
+        }
+        p = nl + 1;
+        if (!in_quotes) {
+            return p;
+        }
+    }
+    return end;
+}
+
+static void count_quotes_task(void *ctx, int worker, pph_size_t task) {
+    parallel_chunk_t *chunk = &((parallel_job_t*)ctx)->chunks[task];
+    const char *p = chunk->begin;
+    pph_size_t quotes = 0;
+
+    (void)worker;
+    while ((p = memchr(p, '"', (pph_size_t)(chunk->end - p))) != NULL) {
+        quotes++;
+        p++;
+    }
+    chunk->quotes = quotes;
+}
+
+/* ============================================
+   Columns
+   ============================================ */
+
+static int grow(void **array, pph_size_t capacity, pph_size_t element) {
+    void *p = realloc(*array, capacity * element);
+
+    if (p == NULL) {
+        return -1;
+    }
+    *array = p;
+    return 0;
+}
+
+static int chunk_reserve(parallel_chunk_t *c, pph_size_t count) {
+    pph_size_t cap = c->capacity ? c->capacity : 1024;
+
+    if (count <= c->capacity) {
+        return 0;
+    }
+    while (cap < count) {
+        cap *= 2;
+    }
+
+    if (grow((void**)&c->ids, cap, sizeof(*c->ids)) != 0 ||
+        grow((void**)&c->errors, cap, sizeof(*c->errors)) != 0 ||
+        grow((void**)&c->bruto, cap, sizeof(*c->bruto)) != 0 ||
+        grow((void**)&c->pension, cap, sizeof(*c->pension)) != 0 ||
+        grow((void**)&c->zakat, cap, sizeof(*c->zakat)) != 0 ||
+        grow((void**)&c->months, cap, sizeof(*c->months)) != 0 ||
+        grow((void**)&c->ptkp, cap, sizeof(*c->ptkp)) != 0 ||
+        grow((void**)&c->scheme, cap, sizeof(*c->scheme)) != 0 ||
+        grow((void**)&c->category, cap, sizeof(*c->category)) != 0 ||
+        grow((void**)&c->bonus_start, cap + 1, sizeof(*c->bonus_start)) != 0 ||
+        grow((void**)&c->total_tax, cap, sizeof(*c->total_tax)) != 0 ||
+        grow((void**)&c->ter_paid, cap, sizeof(*c->ter_paid)) != 0 ||
+        grow((void**)&c->adjustment, cap, sizeof(*c->adjustment)) != 0 ||
+        grow((void**)&c->status, cap, sizeof(*c->status)) != 0) {
+        return -1;
+    }
+    c->capacity = cap;
+    return 0;
+}
+
+static int chunk_reserve_bonuses(parallel_chunk_t *c, pph_size_t count) {
+    pph_size_t cap = c->bonus_capacity ? c->bonus_capacity : 256;
+
+    if (count <= c->bonus_capacity) {
+        return 0;
+    }
+    while (cap < count) {
+        cap *= 2;
+    }
+    if (grow((void**)&c->bonuses, cap, sizeof(*c->bonuses)) != 0) {
+        return -1;
+    }
+    c->bonus_capacity = cap;
+    return 0;
+}
+
+static void chunk_free(parallel_chunk_t *c) {
+    free(c->ids);
+    free((void*)c->errors);
+    free(c->bruto);
+    free(c->pension);
+    free(c->zakat);
+    free(c->months);
+    free(c->ptkp);
+    free(c->scheme);
+    free(c->category);
+    free(c->bonus_start);
+    free(c->bonuses);
+    free(c->total_tax);
+    free(c->ter_paid);
+    free(c->adjustment);
+    free(c->status);
+}
+
+/* Append one record; a record that failed to parse keeps its error and
+   neutral column values so the kernel can still run over it */
+static int chunk_append(parallel_chunk_t *c, const payroll_field_t *id,
+                        const payroll_record_t *record, const char *error) {
+    const pph21_input_t *input = &record->input;
+    pph_size_t i = c->count;
+    int b;
+
+    if (chunk_reserve(c, i + 1) != 0) {
+        return -1;
+    }
+
+    c->ids[i] = *id;
+    c->errors[i] = error;
+    if (i == 0) {
+        c->bonus_start[0] = 0;
+    }
+
+    if (error != NULL) {
+        c->bruto[i] = 0;
+        c->pension[i] = 0;
+        c->zakat[i] = 0;
+        c->months[i] = 12;
+        c->ptkp[i] = PPH_PTKP_TK0;
+        c->scheme[i] = PPH21_SCHEME_TER;
+        c->category[i] = PPH21_TER_CATEGORY_A;
+    } else {
+        c->bruto[i] = input->bruto_monthly.value;
+        c->pension[i] = input->pension_contribution.value;
+        c->zakat[i] = input->zakat_or_donation.value;
+        c->months[i] = (pph_uint8_t)input->months_paid;
+        c->ptkp[i] = (pph_uint8_t)input->ptkp_status;
+        c->scheme[i] = (pph_uint8_t)input->scheme;
+        c->category[i] = (pph_uint8_t)input->ter_category;
+
+        if (input->bonus_count > 0) {
+            if (chunk_reserve_bonuses(c, c->bonus_count + (pph_size_t)input->bonus_count) != 0) {
+                return -1;
+            }
+            for (b = 0; b < input->bonus_count; b++) {
+                c->bonuses[c->bonus_count++] = input->bonuses[b];
+            }
+        }
+    }
+
+    c->bonus_start[i + 1] = (pph_uint32_t)c->bonus_count;
+    c->count = i + 1;
+    return 0;
+}
+
+/* ============================================
+   Parse and Calculate
+   ============================================ */
+
+static void parse_task(void *ctx, int worker, pph_size_t task) {
+    parallel_job_t *job = (parallel_job_t*)ctx;
+    parallel_chunk_t *c = &job->chunks[task];
+    payroll_field_t fields[PAYROLL_FIELD_COUNT];
+    payroll_record_t record;
+    pph21_columns_t columns;
+    pph21_column_results_t results;
+    const char *p = c->begin;
+    pph_size_t i;
+
+    (void)worker;
+    c->count = 0;
+    c->bonus_count = 0;
+    c->out_of_memory = 0;
+
+    while (p < c->end) {
+        const char *next = record_end(p, c->end, 0);
+        pph_size_t len = (pph_size_t)(next - p);
+        const char *error;
+        int count;
+
+        if (len > 0 && p[len - 1] == '\n') len--;
+        if (len > 0 && p[len - 1] == '\r') len--;
+
+        if (len > 0) {
+            count = payroll_split_fields(p, len, fields, PAYROLL_FIELD_COUNT);
+            if (count < 0) {
+                fields[0].ptr = p;
+                fields[0].len = 0;
+                error = "unterminated quote";
+            } else {
+                error = payroll_parse_record(fields, count, job->format, &record);
+            }
+
+            if (chunk_append(c, &fields[0], &record, error) != 0) {
+                c->out_of_memory = 1;
+                return;
+            }
+        }
+        p = next;
+    }
+
+    if (c->count == 0) {
+        return;
+    }
+
+    columns.count = c->count;
+    columns.bruto_monthly = c->bruto;
+    columns.pension_contribution = c->pension;
+    columns.zakat_or_donation = c->zakat;
+    columns.months_paid = c->months;
+    columns.ptkp_status = c->ptkp;
+    columns.scheme = c->scheme;
+    columns.ter_category = c->category;
+    columns.bonus_start = (c->bonus_count > 0) ? c->bonus_start : NULL;
+    columns.bonuses = c->bonuses;
+
+    results.total_tax = c->total_tax;
+    results.ter_paid = c->ter_paid;
+    results.adjustment = c->adjustment;
+    results.status = c->status;
+
+    if (pph21_calculate_columns(&columns, &results) == PPH_OK) {
+        return;
+    }
+
+    /* Records that parsed but failed in the kernel */
+    for (i = 0; i < c->count; i++) {
+        if (c->errors[i] == NULL) {
+            c->errors[i] = payroll_status_error((pph_status_t)c->status[i]);
+        }
+    }
+}
+
+static void write_chunk(FILE *out, const parallel_chunk_t *c, payroll_stats_t *stats) {
+    pph21_summary_t summary;
+    char id[PAYROLL_ID_MAX];
+    pph_size_t i;
+
+    for (i = 0; i < c->count; i++) {
+        payroll_copy_id(c->ids[i], id);
+        summary.total_tax.value = c->total_tax[i];
+        summary.ter_paid.value = c->ter_paid[i];
+        summary.adjustment.value = c->adjustment[i];
+
+        if (c->errors[i] != NULL) {
+            stats->failed++;
+        }
+        payroll_write_result(out, id, &summary, c->errors[i]);
+    }
+    stats->records += (unsigned long)c->count;
+}
+
+/* ============================================
+   Driver
+   ============================================ */
+
+int payroll_run_parallel(const char *data, pph_size_t size, FILE *out,
+                         payroll_amount_format_t format, pph_executor_t *executor,
+                         payroll_stats_t *stats) {
+    const char *end = data + size;
+    const char *pos;
+    parallel_job_t job;
+    pph_size_t tasks, window, slice, quotes, k;
+    int rc = 0;
+
+    stats->records = 0;
+    stats->failed = 0;
+
+    payroll_write_header(out);
+    if (size == 0) {
+        return 0;
+    }
+
+    /* Skip the input header */
+    pos = record_end(data, end, 0);
+
+    tasks = (pph_size_t)pph_executor_thread_count(executor) * PARALLEL_TASKS_PER_THREAD;
+    if (tasks == 0) {
+        tasks = 1;
+    }
+
+    job.format = format;
+    job.chunks = (parallel_chunk_t*)calloc(tasks, sizeof(parallel_chunk_t));
+    if (job.chunks == NULL) {
+        return -1;
+    }
+
+    window = (tasks < PARALLEL_WINDOW_MAX / PARALLEL_TASK_BYTES)
+           ? tasks * PARALLEL_TASK_BYTES : PARALLEL_WINDOW_MAX;
+
+    while (pos < end) {
+        const char *window_end;
+
+        window_end = ((pph_size_t)(end - pos) <= window) ? end : pos + window;
+
+        /* Pass 1: count quotes over raw, unaligned slices of the window;
+           the last slice takes the remainder */
+        slice = (pph_size_t)(window_end - pos) / tasks;
+        for (k = 0; k < tasks; k++) {
+            job.chunks[k].begin = pos + slice * k;
+            job.chunks[k].end = (k + 1 == tasks) ? window_end : pos + slice * (k + 1);
+        }
+        pph_executor_run(executor, count_quotes_task, &job, tasks);
+
+        /* The window starts between records, so the running quote parity
+           gives the state at every raw cut; move each cut forward to the
+           end of the record it falls in */
+        quotes = 0;
+        for (k = 0; k < tasks; k++) {
+            const char *raw_end = job.chunks[k].end;
+
+            quotes += job.chunks[k].quotes;
+            job.chunks[k].begin = (k == 0) ? pos : job.chunks[k - 1].end;
+            job.chunks[k].end = (raw_end == end) ? end
+                              : record_end(raw_end, end, (int)(quotes & 1));
+            if (job.chunks[k].end < job.chunks[k].begin) {
+                job.chunks[k].end = job.chunks[k].begin;
+            }
+        }
+
+        /* Pass 2: parse and calculate each range into its own columns */
+        pph_executor_run(executor, parse_task, &job, tasks);
+
+        for (k = 0; k < tasks; k++) {
+            if (job.chunks[k].out_of_memory) {
+                rc = -1;
+                break;
+            }
+            write_chunk(out, &job.chunks[k], stats);
+        }
+        if (rc != 0) {
+            break;
+        }
+
+        pos = job.chunks[tasks - 1].end;
+    }
+
+    for (k = 0; k < tasks; k++) {
+        chunk_free(&job.chunks[k]);
+    }
+    free(job.chunks);
+
+    return (rc != 0 || ferror(out)) ? -1 : 0;
+}
@@ -0,0 +1,57 @@
+# Run one payroll CSV through the streaming path (stdin) and the mapped
+# parallel path at several thread counts, and require identical output.
+# With CONVERT set the CSV is also converted to the binary format, whose
+# output must match as well.
+#
+# payroll_edge.csv mixes LF and CRLF endings, quoted ids holding commas,
+# doubled quotes and newlines, records that fail parsing and records the
+# calculation rejects as out of range. With 8 threads each task covers a
+# few bytes, so raw cuts land inside quotes and several cuts fall in one
+# record. payroll_range.csv holds only records that parse, as conversion
+# requires, including ones out of range in the monthly and bonus columns.
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+execute_process(
+    COMMAND ${PPHC} pph21 --input -
+    INPUT_FILE ${INPUT}
+    OUTPUT_FILE ${WORK_DIR}/stream.csv
+    ERROR_VARIABLE stream_summary
+    RESULT_VARIABLE stream_rc
+)
+
+set(inputs ${INPUT})
+if(CONVERT)
+    get_filename_component(name ${INPUT} NAME_WE)
+    set(binary ${WORK_DIR}/${name}.pphb)
+    execute_process(
+        COMMAND ${PPHC} convert --input ${INPUT} --output ${binary}
+        ERROR_QUIET
+        RESULT_VARIABLE convert_rc
+    )
+    if(NOT convert_rc EQUAL 0)
+        message(FATAL_ERROR "pphc convert failed with ${convert_rc}")
+    endif()
+    list(APPEND inputs ${binary})
+endif()
+
+foreach(input ${inputs})
+    foreach(threads 1 2 8)
+        execute_process(
+            COMMAND ${PPHC} pph21 --input ${input} --threads ${threads}
+            OUTPUT_FILE ${WORK_DIR}/mapped_${threads}.csv
+            ERROR_VARIABLE mapped_summary
+            RESULT_VARIABLE mapped_rc
+        )
+        if(NOT mapped_rc EQUAL stream_rc OR NOT mapped_summary STREQUAL stream_summary)
+            message(FATAL_ERROR "${input} --threads ${threads}: exit ${mapped_rc} (${mapped_summary}), "
+                                "stdin: exit ${stream_rc} (${stream_summary})")
+        endif()
+
+        file(READ ${WORK_DIR}/stream.csv expected)
+        file(READ ${WORK_DIR}/mapped_${threads}.csv actual)
+        if(NOT actual STREQUAL expected)
+            message(FATAL_ERROR "${input} --threads ${threads} output differs from stdin output")
+        endif()
+    endforeach()
+endforeach()
@@ -28,20 +28,63 @@ set(EMSCRIPTEN_EXPORTED_FUNCTIONS
     "_pph_money_min"
     "_pph_money_max"
     "_pph_money_cmp"
+    "_pph_money_add_checked"
+    "_pph_money_sub_checked"
+    "_pph_money_mul_int_checked"
+    "_pph_money_percent_checked"
     "_pph_money_round_down_thousand"
     "_pph_money_floor"
+    "_pph_money_mul_array"
+    "_pph_money_percent_array"
+    "_pph_money_round_down_thousand_array"
     "_pph_money_to_string"
     "_pph_money_to_string_formatted"
+    "_pph_money_format"
+    "_pph_money_format_column"
     "_pph_percent_to_string"
     "_pph_money_from_string"
     "_pph_money_from_string_id"
+    "_pph_money_from_string_n"
+    "_pph_money_from_string_id_n"
+    "_pph_money_parse"
     "_pph21_calculate"
+    "_pph21_calculate_summary"
+    "_pph21_calculate_batch"
+    "_pph21_calculate_columns"
+    "_pph21_ytd_init"
+    "_pph21_ytd_apply_month"
+    "_pph21_curve_compile"
+    "_pph21_curve_total_tax"
+    "_pph21_curve_evaluate"
+    "_pph21_curve_sweep"
+    "_pph21_curve_gross_up"
+    "_pph21_gross_up"
+    "_pph21_gross_up_batch"
+    "_pph_executor_create"
+    "_pph_executor_free"
+    "_pph_executor_run"
+    "_pph_executor_thread_count"
+    "_pph21_calculate_batch_parallel"
+    "_pph_ruleset_load"
+    "_pph_ruleset_free"
+    "_pph_ruleset_label"
+    "_pph_ruleset_write"
+    "_pph_ruleset_publish"
+    "_pph_ruleset_collect"
+    "_pph_ruleset_registry_create"
+    "_pph_ruleset_registry_free"
+    "_pph_ruleset_registry_add"
+    "_pph_ruleset_registry_label"
+    "_pph21_calculate_batch_dated"
     "_pph22_calculate"
     "_pph23_calculate"
     "_pph4_2_calculate"
     "_ppn_calculate"
     "_ppnbm_calculate"
     "_pph_result_free"
+    "_pph_result_row_label"
+    "_pph_result_row_note"
+    "_pph_label_text"
     "_pph_get_ptkp"
     "_pph_calculate_pasal17"
     "_pph_get_ter_bulanan_rate"
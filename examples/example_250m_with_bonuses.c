@@ -56,19 +56,21 @@ int main(void) {
     /* Print breakdown */
     for (i = 0; i < result->breakdown_count; i++) {
         pph_breakdown_row_t *item = &result->breakdown[i];
+        const char *label = pph_result_row_label(result, i);
+        const char *note = pph_result_row_note(result, i);
 
         if (item->variant == PPH_BREAKDOWN_SECTION) {
-            printf("\n%s\n", item->label);
+            printf("\n%s\n", label);
         } else if (item->value_type == PPH_VALUE_CURRENCY) {
             pph_money_to_string_formatted(item->value, buffer, sizeof(buffer));
-            if (item->note[0] != '\0') {
-                printf("  %s: %s IDR (%s)\n", item->label, buffer, item->note);
+            if (note[0] != '\0') {
+                printf("  %s: %s IDR (%s)\n", label, buffer, note);
             } else {
-                printf("  %s: %s IDR\n", item->label, buffer);
+                printf("  %s: %s IDR\n", label, buffer);
             }
         } else if (item->value_type == PPH_VALUE_PERCENT) {
             pph_percent_to_string(item->value, buffer, sizeof(buffer));
-            printf("  %s: %s\n", item->label, buffer);
+            printf("  %s: %s\n", label, buffer);
         }
     }
 
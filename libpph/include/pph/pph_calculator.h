@@ -23,6 +23,18 @@ extern "C" {
 #define PPH_VERSION_BUILD 1
 #define PPH_VERSION_STRING "0.1a"
 
+/* ============================================
+   Status Codes
+   ============================================ */
+typedef enum {
+    PPH_OK = 0,
+    PPH_ERR_NULL_INPUT,
+    PPH_ERR_NO_MEMORY,
+    PPH_ERR_INVALID_INPUT,
+    PPH_ERR_SYNTAX,         /* Malformed text */
+    PPH_ERR_OVERFLOW        /* Value out of range */
+} pph_status_t;
+
 /* ============================================
    Money Type (Fixed-Point Decimal)
    ============================================ */
@@ -105,10 +117,33 @@ PPH_EXPORT pph_money_t pph_money_min(pph_money_t a, pph_money_t b);
 PPH_EXPORT pph_money_t pph_money_max(pph_money_t a, pph_money_t b);
 PPH_EXPORT int pph_money_cmp(pph_money_t a, pph_money_t b);
 
+/* Checked forms: store the result and return PPH_OK, or return
+   PPH_ERR_OVERFLOW (PPH_ERR_INVALID_INPUT for a zero den) and leave *out
+   untouched. pph_money_percent_checked requires amount * num to fit, as
+   the unchecked form does. */
+PPH_EXPORT pph_status_t pph_money_add_checked(pph_money_t a, pph_money_t b, pph_money_t *out);
+PPH_EXPORT pph_status_t pph_money_sub_checked(pph_money_t a, pph_money_t b, pph_money_t *out);
+PPH_EXPORT pph_status_t pph_money_mul_int_checked(pph_money_t a, pph_int64_t scalar, pph_money_t *out);
+PPH_EXPORT pph_status_t pph_money_percent_checked(pph_money_t amount, pph_int64_t num,
+                                                  pph_int64_t den, pph_money_t *out);
+
 /* Rounding functions */
 PPH_EXPORT pph_money_t pph_money_round_down_thousand(pph_money_t value);
 PPH_EXPORT pph_money_t pph_money_floor(pph_money_t value);
 
+/* Array forms: out[i] = op(values[i]) for count elements, with the same
+   results as the single-value functions; out may equal values. AVX2 is
+   selected at run time on x86 and NEON is used on AArch64; elements whose
+   product reaches 2^51 take the scalar path. pph_money_percent_array
+   rejects a zero divisor, and a negative divisor paired with an INT64_MIN
+   operand, with PPH_ERR_INVALID_INPUT. */
+PPH_EXPORT pph_status_t pph_money_mul_array(const pph_money_t *values, pph_money_t rate,
+                                            pph_money_t *out, pph_size_t count);
+PPH_EXPORT pph_status_t pph_money_percent_array(const pph_money_t *values, pph_int64_t num,
+                                                pph_int64_t den, pph_money_t *out, pph_size_t count);
+PPH_EXPORT pph_status_t pph_money_round_down_thousand_array(const pph_money_t *values,
+                                                            pph_money_t *out, pph_size_t count);
+
 /* String conversion */
 PPH_EXPORT char* pph_money_to_string(pph_money_t money, char *buffer, pph_size_t size);
 PPH_EXPORT char* pph_money_to_string_formatted(pph_money_t money, char *buffer, pph_size_t size);
@@ -116,6 +151,42 @@ PPH_EXPORT char* pph_percent_to_string(pph_money_t percent, char *buffer, pph_si
 PPH_EXPORT pph_money_t pph_money_from_string(const char *str);
 PPH_EXPORT pph_money_t pph_money_from_string_id(const char *str); /* Indonesian format: comma=decimal, dot=thousands */
 
+/* Formatting styles: grouping and decimal separators */
+typedef enum {
+    PPH_MONEY_FORMAT_PLAIN = 0,  /* 1234567.8900 */
+    PPH_MONEY_FORMAT_EN = 1,     /* 1,234,567.8900 */
+    PPH_MONEY_FORMAT_ID = 2      /* 1.234.567,8900 */
+} pph_money_format_t;
+
+/* Longest formatted value including the NUL */
+#define PPH_MONEY_FORMAT_MAX 32
+
+/* Writes money with four decimals and a NUL; returns the length without
+   the NUL, or 0 if it does not fit in size bytes */
+PPH_EXPORT pph_size_t pph_money_format(pph_money_t money, pph_money_format_t style,
+                                       char *buffer, pph_size_t size);
+
+/* Bulk form: formats values back to back, each followed by terminator
+   (no NUL). Stops before the first value that does not fit; returns how
+   many were formatted and stores the bytes used in *written, so a large
+   column can be emitted in buffer-sized chunks. */
+PPH_EXPORT pph_size_t pph_money_format_column(const pph_money_t *values, pph_size_t count,
+                                              pph_money_format_t style, char terminator,
+                                              char *buffer, pph_size_t size, pph_size_t *written);
+
+/* Length-bounded parsers: read at most len bytes, no NUL terminator needed */
+PPH_EXPORT pph_money_t pph_money_from_string_n(const char *str, pph_size_t len);
+PPH_EXPORT pph_money_t pph_money_from_string_id_n(const char *str, pph_size_t len);
+
+/* Validating parser: reads one amount in the given style from at most len
+   bytes (surrounding blanks, a sign, digits grouped in threes or not at
+   all, up to four decimals). Stores the bytes consumed, or the offset of
+   the error, in *consumed; a caller parsing a whole field checks it equals
+   len. Returns PPH_ERR_SYNTAX or PPH_ERR_OVERFLOW on bad input, leaving
+   *out zero. */
+PPH_EXPORT pph_status_t pph_money_parse(const char *str, pph_size_t len, pph_money_format_t style,
+                                        pph_money_t *out, pph_size_t *consumed);
+
 /* ============================================
    Tax Breakdown Types
    ============================================ */
@@ -134,11 +205,87 @@ typedef enum {
     PPH_VALUE_TEXT
 } pph_value_type_t;
 
+/* Stable keys for breakdown labels and notes. New IDs are only ever
+   appended, so consumers may store them or switch on them instead of
+   comparing the (Indonesian) label text. */
+typedef enum {
+    PPH_LABEL_NONE = 0,
+
+    /* PPh 21 sections */
+    PPH_LABEL_SECTION_TER,              /* Pemotongan TER (Bulan 1-11) */
+    PPH_LABEL_SECTION_ANNUAL,           /* Perhitungan Tahunan (Pasal 17) */
+    PPH_LABEL_SECTION_DECEMBER,         /* Penyesuaian Bulan 12 */
+    PPH_LABEL_SECTION_BRUTO,            /* Penghasilan Bruto */
+    PPH_LABEL_SECTION_DEDUCTIONS,       /* Pengurang */
+    PPH_LABEL_SECTION_PKP,              /* PKP dan Pajak */
+    PPH_LABEL_SECTION_PENSIUNAN,
+    PPH_LABEL_SECTION_TIDAK_TETAP,
+    PPH_LABEL_SECTION_BUKAN_PEGAWAI,
+    PPH_LABEL_SECTION_PESERTA_KEGIATAN,
+    PPH_LABEL_SECTION_PROGRAM_PENSIUN,
+    PPH_LABEL_SECTION_MANTAN_PEGAWAI,
+    PPH_LABEL_SECTION_WPLN,
+
+    /* PPh 21 TER withholding */
+    PPH_LABEL_TER_BONUS_MONTH,          /* Text: "Bulan <n> (<bonus names>)" */
+    PPH_LABEL_TER_REGULAR_MONTHS,       /* Text: "<n> bulan reguler" */
+    PPH_LABEL_TER_RATE,
+    PPH_LABEL_TER_TAX,
+    PPH_LABEL_TER_TAX_PER_MONTH,
+    PPH_LABEL_TER_TAX_TOTAL,
+    PPH_LABEL_TER_PAID,
+
+    /* PPh 21 annual calculation */
+    PPH_LABEL_GAJI_PER_BULAN,
+    PPH_LABEL_GAJI_SETAHUN,
+    PPH_LABEL_BONUS,                    /* Text: the bonus name */
+    PPH_LABEL_TOTAL_BRUTO,
+    PPH_LABEL_BRUTO_SETAHUN,
+    PPH_LABEL_BIAYA_JABATAN,
+    PPH_LABEL_IURAN_PENSIUN,
+    PPH_LABEL_ZAKAT,
+    PPH_LABEL_NETTO_SETAHUN,
+    PPH_LABEL_PTKP,
+    PPH_LABEL_PKP,
+    PPH_LABEL_PPH21_PROGRESSIVE,
+    PPH_LABEL_PPH21_SETAHUN,
+    PPH_LABEL_TER_DEDUCTED,
+    PPH_LABEL_DECEMBER_BALANCE,
+
+    /* Shared by the flat-rate calculators */
+    PPH_LABEL_PENGHASILAN_BRUTO,
+    PPH_LABEL_DPP,
+    PPH_LABEL_TARIF,
+    PPH_LABEL_PPH21,
+    PPH_LABEL_PPH22,
+    PPH_LABEL_PPH23,
+    PPH_LABEL_PPH4_2,
+    PPH_LABEL_PPN,
+    PPH_LABEL_TARIF_PPN,
+    PPH_LABEL_PPNBM,
+    PPH_LABEL_TARIF_PPNBM,
+    PPH_LABEL_SECTION_PPN_PPNBM,
+    PPH_LABEL_TOTAL_PPN_PPNBM,
+
+    /* Notes */
+    PPH_LABEL_NOTE_PER_MONTH,           /* per bulan */
+    PPH_LABEL_NOTE_MONTHS,              /* Text: "<n> bulan" */
+    PPH_LABEL_NOTE_FLAT_RATE,           /* 5% */
+
+    PPH_LABEL_COUNT
+} pph_label_id_t;
+
+/* One breakdown row. label and note are keys; rows whose text is built
+   at run time (bonus names, month counts) also reference the result's
+   string pool, so read the text through pph_result_row_label() and
+   pph_result_row_note() rather than pph_label_text(). */
 typedef struct {
-    char label[256];
     pph_money_t value;
+    pph_label_id_t label;
+    pph_label_id_t note;
+    pph_uint32_t label_text;    /* Pool offset + 1, or 0 for the static text */
+    pph_uint32_t note_text;
     pph_value_type_t value_type;
-    char note[128];
     pph_breakdown_variant_t variant;
 } pph_breakdown_row_t;
 
@@ -147,11 +294,23 @@ typedef struct {
     pph_breakdown_row_t *breakdown;
     pph_size_t breakdown_count;
     pph_size_t breakdown_capacity;
+    char *strings;              /* Pool of NUL-terminated dynamic texts */
+    pph_size_t strings_size;
+    pph_size_t strings_capacity;
 } pph_result_t;
 
 /* Result management */
 PPH_EXPORT void pph_result_free(pph_result_t *result);
 
+/* Static text of a label ID; "" for PPH_LABEL_NONE or unknown IDs */
+PPH_EXPORT const char* pph_label_text(pph_label_id_t label);
+
+/* Display text of a row's label and note, including dynamic text; ""
+   when index is out of range or the row has no note. The pointers stay
+   valid until the result is freed. */
+PPH_EXPORT const char* pph_result_row_label(const pph_result_t *result, pph_size_t index);
+PPH_EXPORT const char* pph_result_row_note(const pph_result_t *result, pph_size_t index);
+
 /* ============================================
    PPh21/26 Types and Functions
    ============================================ */
@@ -215,6 +374,305 @@ typedef struct {
 
 PPH_EXPORT pph_result_t* pph21_calculate(const pph21_input_t *input);
 
+/* ============================================
+   PPh21 Totals-Only Calculation
+
+   Computes only the numbers needed for withholding: no breakdown rows,
+   no string formatting and no heap allocation.
+
+   pph21_calculate_summary() fills one summary.
+   pph21_calculate_batch() computes a whole payroll into a caller-supplied
+   outputs array (one entry per input, same order) and returns PPH_OK when
+   every record succeeded, otherwise the status of the first failing
+   record. Failed records have zero amounts and their own status set; the
+   rest of the batch is still computed.
+   ============================================ */
+typedef struct {
+    pph_money_t total_tax;        /* Annual PPh 21 (same as result->total_tax) */
+    pph_money_t ter_paid;         /* TER withheld in months 1-11 (TER scheme) */
+    pph_money_t adjustment;       /* Month 12 kurang/(lebih) bayar (TER scheme) */
+    pph_money_t monthly_ter[12];  /* TER withheld per month, zero if none */
+    pph_status_t status;
+} pph21_summary_t;
+
+PPH_EXPORT pph_status_t pph21_calculate_summary(const pph21_input_t *input,
+                                                pph21_summary_t *summary);
+PPH_EXPORT pph_status_t pph21_calculate_batch(const pph21_input_t *inputs,
+                                              pph_size_t count,
+                                              pph21_summary_t *outputs);
+
+/* ============================================
+   PPh21 Year-to-Date Monthly Withholding (Pegawai Tetap)
+
+   Keeps one small state per employee across a tax year so each monthly
+   payroll run applies only that month's figures. Months before the last
+   withhold TER on the month's income; the last month (month 12, or the
+   month flagged is_final when employment ends) withholds annual Pasal 17
+   on the accumulated year less everything already withheld.
+
+   For a full year this reproduces pph21_calculate_summary(): month i
+   withholds monthly_ter[i] and month 12 the adjustment. Under the LAMA
+   scheme nothing is withheld before the true-up, as in the summary.
+   ============================================ */
+typedef struct {
+    int months_applied;               /* Months applied so far (0-12) */
+    int closed;                       /* True-up done; no more months */
+    pph_ptkp_status_t ptkp_status;
+    pph21_scheme_t scheme;
+    pph21_ter_category_t ter_category;
+    pph_money_t bruto_ytd;            /* Salary and bonuses */
+    pph_money_t pension_ytd;          /* Iuran pensiun */
+    pph_money_t zakat_ytd;            /* Zakat/sumbangan */
+    pph_money_t withheld_ytd;         /* PPh 21 withheld so far */
+} pph21_ytd_state_t;
+
+typedef struct {
+    pph_money_t bruto;                /* Regular salary for the month */
+    pph_money_t bonus;                /* Bonuses paid in the month */
+    pph_money_t pension_contribution; /* Iuran pensiun for the month */
+    pph_money_t zakat_or_donation;    /* Zakat/sumbangan paid in the month */
+    int is_final;                     /* Last month of employment: true up now */
+} pph21_month_input_t;
+
+typedef struct {
+    int month;                        /* 1-12 */
+    int is_true_up;                   /* Withholding is the annual true-up */
+    pph_money_t income;               /* Bruto of the month */
+    pph_money_t rate;                 /* TER rate, zero for the true-up */
+    pph_money_t withholding;          /* PPh 21 to withhold, negative = refund */
+    pph_money_t withheld_ytd;         /* Including this month */
+} pph21_month_result_t;
+
+PPH_EXPORT void pph21_ytd_init(pph21_ytd_state_t *state, pph_ptkp_status_t ptkp_status,
+                               pph21_scheme_t scheme, pph21_ter_category_t ter_category);
+PPH_EXPORT pph_status_t pph21_ytd_apply_month(pph21_ytd_state_t *state,
+                                              const pph21_month_input_t *month,
+                                              pph21_month_result_t *result);
+
+/* ============================================
+   PPh21 Salary Curve (Pegawai Tetap)
+
+   For a fixed profile, PPh 21 is a piecewise function of the monthly
+   bruto. pph21_curve_compile() finds the exact bruto at which anything
+   changes regime: the biaya jabatan cap, each Pasal 17 layer of the
+   rounded PKP and each TER bracket ceiling. Evaluating then costs a
+   binary search over at most PPH21_CURVE_MAX_SEGMENTS segments plus the
+   PKP rounding and one multiply-add, with no allocation. Results equal
+   pph21_calculate_summary() for a record without bonuses.
+
+   pph21_curve_sweep() evaluates an ascending series of salaries and
+   walks the segments instead of searching. Bruto is limited to
+   [0, PPH21_CURVE_BRUTO_MAX].
+   ============================================ */
+#define PPH21_CURVE_MAX_SEGMENTS 64
+#define PPH21_CURVE_BRUTO_MAX PPH_INT64_C(100000000000000000)  /* 10 trillion Rp */
+
+typedef struct {
+    pph_ptkp_status_t ptkp_status;
+    pph21_scheme_t scheme;
+    pph21_ter_category_t ter_category;
+    int months_paid;
+    pph_money_t pension_contribution;  /* Per month */
+    pph_money_t zakat_or_donation;     /* Per year */
+} pph21_profile_t;
+
+typedef struct {
+    pph_int64_t bruto_start;           /* First monthly bruto of the segment */
+    int biaya_capped;                  /* Biaya jabatan is at its 6 juta cap */
+    pph_int64_t layer_start;           /* PKP where the Pasal 17 layer starts */
+    pph_int64_t layer_base_tax;        /* Pasal 17 tax at layer_start */
+    pph_money_t layer_rate;
+    pph_money_t ter_rate;              /* Zero under the LAMA scheme */
+} pph21_curve_segment_t;
+
+typedef struct {
+    int months;
+    int ter_months;
+    pph21_scheme_t scheme;
+    pph21_ter_category_t ter_category;
+    pph_int64_t fixed_deductions;      /* Pension, zakat and PTKP for the year */
+    int segment_count;
+    pph21_curve_segment_t segments[PPH21_CURVE_MAX_SEGMENTS];
+} pph21_curve_t;
+
+PPH_EXPORT pph_status_t pph21_curve_compile(const pph21_profile_t *profile, pph21_curve_t *curve);
+PPH_EXPORT pph_money_t pph21_curve_total_tax(const pph21_curve_t *curve, pph_money_t bruto);
+PPH_EXPORT pph_status_t pph21_curve_evaluate(const pph21_curve_t *curve, pph_money_t bruto,
+                                             pph21_summary_t *summary);
+PPH_EXPORT pph_status_t pph21_curve_sweep(const pph21_curve_t *curve, pph_money_t bruto_from,
+                                          pph_money_t step, pph_size_t count,
+                                          pph_money_t *total_tax);
+
+/* ============================================
+   PPh21 Gross-Up (Net to Bruto)
+
+   For net-of-tax contracts: find the smallest monthly bruto whose net,
+   bruto less PPh 21 averaged over the months paid, reaches net_monthly
+   (that is, bruto * months - total_tax >= net_monthly * months). The
+   solver uses the linear form of the curve segment and then steps over
+   the thousand-rupiah PKP rounding, so it costs a handful of tax
+   evaluations. The result equals what bisecting pph21_calculate_summary()
+   would converge to.
+
+   pph21_gross_up_batch() solves a population, reusing the compiled curve
+   while consecutive profiles are equal (sort by profile for best speed).
+   Failed records get a zero bruto; the first failure is returned.
+   ============================================ */
+PPH_EXPORT pph_status_t pph21_curve_gross_up(const pph21_curve_t *curve, pph_money_t net_monthly,
+                                             pph_money_t *bruto_monthly);
+PPH_EXPORT pph_status_t pph21_gross_up(const pph21_profile_t *profile, pph_money_t net_monthly,
+                                       pph_money_t *bruto_monthly);
+PPH_EXPORT pph_status_t pph21_gross_up_batch(const pph21_profile_t *profiles,
+                                             const pph_money_t *net_monthly,
+                                             pph_size_t count,
+                                             pph_money_t *bruto_monthly);
+
+/* ============================================
+   PPh21 Columnar Batch (Pegawai Tetap)
+
+   Struct-of-arrays form of a payroll: each field is its own contiguous
+   column, with money columns holding raw pph_money_t values (10,000
+   scale). Every record is treated as PPH21_PEGAWAI_TETAP.
+
+   Optional columns may be NULL: pension_contribution and
+   zakat_or_donation read as zero, months_paid as 12 and scheme as
+   PPH21_SCHEME_TER. Bonuses live in a side table: the bonuses of record
+   i are bonuses[bonus_start[i]] .. bonuses[bonus_start[i + 1] - 1], so
+   bonus_start has count + 1 entries. Leave bonus_start NULL when no
+   record has bonuses.
+
+   Results are written per record; ter_paid, adjustment and status may
+   be NULL. status receives each record's pph_status_t, so a caller can
+   tell which records failed (their amounts read zero); the return value
+   is only the first failure. Output equals pph21_calculate_summary() for
+   the same record.
+   ============================================ */
+typedef struct {
+    pph_size_t count;
+    const pph_int64_t *bruto_monthly;
+    const pph_int64_t *pension_contribution;  /* Monthly, optional */
+    const pph_int64_t *zakat_or_donation;     /* Annual, optional */
+    const pph_uint8_t *months_paid;           /* Optional */
+    const pph_uint8_t *ptkp_status;           /* pph_ptkp_status_t values */
+    const pph_uint8_t *scheme;                /* pph21_scheme_t values, optional */
+    const pph_uint8_t *ter_category;          /* pph21_ter_category_t values */
+    const pph_uint32_t *bonus_start;          /* count + 1 entries, optional */
+    const pph21_bonus_t *bonuses;
+} pph21_columns_t;
+
+typedef struct {
+    pph_int64_t *total_tax;
+    pph_int64_t *ter_paid;    /* Optional */
+    pph_int64_t *adjustment;  /* Optional */
+    pph_uint8_t *status;      /* pph_status_t values, optional */
+} pph21_column_results_t;
+
+PPH_EXPORT pph_status_t pph21_calculate_columns(const pph21_columns_t *columns,
+                                                pph21_column_results_t *results);
+
+/* ============================================
+   Parallel PPh21 Batch Executor
+
+   A pool of worker threads for large payrolls. The payroll is cut into
+   small tasks of contiguous records, dealt out to per-worker deques;
+   a worker that runs dry steals tasks from the back of another worker's
+   deque, so records with many bonuses do not leave other cores idle.
+   Every result is written to the slot of its input, so outputs are
+   identical to pph21_calculate_batch(). Each worker sums the records it
+   ran into a private slot, and the slots are added together after the
+   run without locks.
+
+   thread_count counts the calling thread, which also computes; pass 0 to
+   use one thread per online processor. Builds without thread support run
+   everything on the calling thread. An executor runs one batch at a time.
+   ============================================ */
+typedef struct pph_executor pph_executor_t;
+
+typedef struct {
+    pph_money_t total_tax;     /* Sum over successful records */
+    pph_money_t ter_paid;
+    pph_money_t adjustment;
+    pph_size_t failed;         /* Records with status != PPH_OK */
+} pph21_batch_totals_t;
+
+PPH_EXPORT pph_executor_t* pph_executor_create(int thread_count);
+PPH_EXPORT void pph_executor_free(pph_executor_t *executor);
+PPH_EXPORT int pph_executor_thread_count(const pph_executor_t *executor);
+
+/**
+ * Run task_count independent tasks on the pool and wait for them all
+ * Tasks are scheduled like batch records (per-worker deques with
+ * stealing); worker is in [0, pph_executor_thread_count()) and may index
+ * per-worker scratch. Tasks must not call back into the same executor.
+ */
+typedef void (*pph_task_fn)(void *ctx, int worker, pph_size_t task);
+
+PPH_EXPORT void pph_executor_run(pph_executor_t *executor, pph_task_fn task,
+                                 void *ctx, pph_size_t task_count);
+
+PPH_EXPORT pph_status_t pph21_calculate_batch_parallel(pph_executor_t *executor,
+                                                       const pph21_input_t *inputs,
+                                                       pph_size_t count,
+                                                       pph21_summary_t *outputs,
+                                                       pph21_batch_totals_t *totals);
+
+/* ============================================
+   Tax Rulesets
+
+   PTKP amounts, the Pasal 17 layers and the TER tables can be loaded
+   from a ruleset file instead of the compiled-in values, so a regulation
+   change is a file, not a rebuild. pph_ruleset_write() with a NULL
+   ruleset exports the built-in rules as a starting point. Files are
+   memory-mapped where the platform allows and validated on load; the
+   format is described in pph_ruleset.c.
+
+   pph_ruleset_publish() makes a ruleset the one every calculation uses
+   from then on (NULL goes back to the built-in rules). Calculations
+   already running finish on the rules they started with, and readers
+   never take a lock. The library owns a published ruleset and frees it
+   once no calculation can still see it; pph_ruleset_collect() retries
+   that and returns how many replaced rulesets are still waiting. Free
+   only rulesets that were never published.
+   ============================================ */
+typedef struct pph_ruleset pph_ruleset_t;
+
+PPH_EXPORT pph_ruleset_t* pph_ruleset_load(const char *path);  /* NULL on error */
+PPH_EXPORT void pph_ruleset_free(pph_ruleset_t *ruleset);
+PPH_EXPORT const char* pph_ruleset_label(const pph_ruleset_t *ruleset);
+PPH_EXPORT pph_status_t pph_ruleset_write(const pph_ruleset_t *ruleset, const char *label,
+                                          const char *path);
+PPH_EXPORT void pph_ruleset_publish(pph_ruleset_t *ruleset);
+PPH_EXPORT int pph_ruleset_collect(void);
+
+/* ============================================
+   Tax Ruleset Registry
+
+   Several rulesets keyed by the date each takes effect (YYYYMMDD), for
+   batches that span tax years. The ruleset in force on a date is the one
+   with the latest effective date not after it, found by binary search.
+   pph_ruleset_registry_add() takes ownership of the ruleset on success
+   (NULL stands for the built-in rules) and replaces one added for the
+   same date. Do not change or free a registry while it is in use.
+
+   pph21_calculate_batch_dated() calculates each record with the ruleset
+   in force on its date, in one pass, independent of the published
+   ruleset. Records dated before the first entry fail with
+   PPH_ERR_INVALID_INPUT; the first failure is returned.
+   ============================================ */
+typedef struct pph_ruleset_registry pph_ruleset_registry_t;
+
+PPH_EXPORT pph_ruleset_registry_t* pph_ruleset_registry_create(void);
+PPH_EXPORT void pph_ruleset_registry_free(pph_ruleset_registry_t *registry);
+PPH_EXPORT pph_status_t pph_ruleset_registry_add(pph_ruleset_registry_t *registry,
+                                                 long effective_date, pph_ruleset_t *ruleset);
+PPH_EXPORT const char* pph_ruleset_registry_label(const pph_ruleset_registry_t *registry,
+                                                  long date);  /* NULL if none in force */
+PPH_EXPORT pph_status_t pph21_calculate_batch_dated(const pph_ruleset_registry_t *registry,
+                                                    const pph21_input_t *inputs,
+                                                    const long *dates,
+                                                    pph_size_t count,
+                                                    pph21_summary_t *outputs);
+
 /* ============================================
    PPh22 Types and Functions
    ============================================ */
@@ -275,8 +733,10 @@ PPH_EXPORT pph_result_t* ppnbm_calculate(const ppnbm_input_t *input);
 /* ============================================
    Library Initialization and Error Handling
    ============================================ */
+/* pph_init() builds the TER lookup index once; later calls, and calls
+   made while other threads calculate, are safe */
 PPH_EXPORT void pph_init(void);
-PPH_EXPORT const char* pph_get_last_error(void);
+PPH_EXPORT const char* pph_get_last_error(void);  /* Per thread when built with threads */
 PPH_EXPORT const char* pph_get_version(void);
 
 /* ============================================
@@ -292,6 +752,8 @@ PPH_EXPORT const char* pph_get_version(void);
 
    Example (reset to default):
      pph_set_custom_allocator(NULL, NULL, NULL);
+
+   Not thread-safe: change the allocator only while no calculation runs.
    ============================================ */
 PPH_EXPORT void pph_set_custom_allocator(
     void* (*malloc_fn)(pph_size_t size),
@@ -0,0 +1,143 @@
+/*
+ * PPH Money Inline - Header-only money arithmetic
+ * Copyright (c) 2025 OpenPajak Contributors
+ *
+ * Opt-in: including this header makes calls to the simple money
+ * operations below compile inline instead of calling the exported
+ * functions, which from a shared library go through the PLT and keep
+ * loops over money values from being vectorized. Results are identical
+ * to the exported functions, which stay available for bindings and for
+ * taking addresses; write (pph_money_add)(a, b) to call one directly.
+ *
+ * pph_money_mul() and the string functions are not inlined.
+ *
+ * Define PPH_MONEY_INLINE_NO_REDIRECT before including to get only the
+ * *_inline functions.
+ */
+
+#ifndef PPH_MONEY_INLINE_H
+#define PPH_MONEY_INLINE_H
+
+#include "pph_calculator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Unsigned division by 10^3, 10^4 and 10^7 as a multiply by a rounded-up
+   reciprocal. 64-bit compilers do this for constant divisors themselves,
+   but on 32-bit ARM and OpenWatcom a 64-bit '/' is a runtime library
+   call, while the high half of a 64x64 product is four 32x32 multiplies.
+   Dividing out the power of two first (10^4 = 16 * 625) leaves a
+   dividend below 2^60, where these reciprocals are exact. */
+static PPH_INLINE pph_uint64_t pph_mulhi64_inline(pph_uint64_t a, pph_uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    return (pph_uint64_t)(__extension__ (((unsigned __int128)a * b) >> 64));
+#else
+    pph_uint64_t a_lo = a & 0xFFFFFFFFUL, a_hi = a >> 32;
+    pph_uint64_t b_lo = b & 0xFFFFFFFFUL, b_hi = b >> 32;
+    pph_uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo;
+    pph_uint64_t mid = (p0 >> 32) + (p1 & 0xFFFFFFFFUL) + (p2 & 0xFFFFFFFFUL);
+
+    return a_hi * b_hi + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+#endif
+}
+
+static PPH_INLINE pph_uint64_t pph_udiv_1e3_inline(pph_uint64_t n) {
+    return pph_mulhi64_inline(n >> 3, PPH_UINT64_C(0x83126E978D4FDF3C)) >> 6;
+}
+
+static PPH_INLINE pph_uint64_t pph_udiv_1e4_inline(pph_uint64_t n) {
+    return pph_mulhi64_inline(n >> 4, PPH_UINT64_C(0xD1B71758E219652C)) >> 9;
+}
+
+static PPH_INLINE pph_uint64_t pph_udiv_1e7_inline(pph_uint64_t n) {
+    return pph_mulhi64_inline(n >> 7, PPH_UINT64_C(0xD6BF94D5E57A42BD)) >> 16;
+}
+
+static PPH_INLINE pph_money_t pph_money_add_inline(pph_money_t a, pph_money_t b) {
+    pph_money_t result;
+    result.value = a.value + b.value;
+    return result;
+}
+
+static PPH_INLINE pph_money_t pph_money_sub_inline(pph_money_t a, pph_money_t b) {
+    pph_money_t result;
+    result.value = a.value - b.value;
+    return result;
+}
+
+static PPH_INLINE pph_money_t pph_money_neg_inline(pph_money_t a) {
+    pph_money_t result;
+    result.value = -a.value;
+    return result;
+}
+
+static PPH_INLINE pph_money_t pph_money_mul_int_inline(pph_money_t a, pph_int64_t scalar) {
+    pph_money_t result;
+    result.value = a.value * scalar;
+    return result;
+}
+
+static PPH_INLINE pph_money_t pph_money_div_inline(pph_money_t a, pph_int64_t divisor) {
+    pph_money_t result;
+    pph_uint64_t magnitude;
+
+    /* Rescaling by the scale factor avoids the divide; truncates toward
+       zero like '/' */
+    if (divisor == PPH_SCALE_FACTOR) {
+        magnitude = pph_udiv_1e4_inline((a.value < 0) ? (pph_uint64_t)0 - (pph_uint64_t)a.value
+                                                      : (pph_uint64_t)a.value);
+        result.value = (a.value < 0) ? -(pph_int64_t)magnitude : (pph_int64_t)magnitude;
+    } else {
+        result.value = a.value / divisor;
+    }
+    return result;
+}
+
+static PPH_INLINE int pph_money_cmp_inline(pph_money_t a, pph_money_t b) {
+    return (a.value > b.value) - (a.value < b.value);
+}
+
+static PPH_INLINE pph_money_t pph_money_min_inline(pph_money_t a, pph_money_t b) {
+    return (a.value < b.value) ? a : b;
+}
+
+static PPH_INLINE pph_money_t pph_money_max_inline(pph_money_t a, pph_money_t b) {
+    return (a.value > b.value) ? a : b;
+}
+
+static PPH_INLINE pph_money_t pph_money_round_down_thousand_inline(pph_money_t value) {
+    pph_money_t result;
+    result.value = (value.value < 0) ? 0
+                 : (pph_int64_t)pph_udiv_1e7_inline((pph_uint64_t)value.value) * PPH_INT64_C(10000000);
+    return result;
+}
+
+static PPH_INLINE pph_money_t pph_money_floor_inline(pph_money_t value) {
+    pph_money_t result;
+    result.value = (value.value < 0) ? 0 : value.value;
+    return result;
+}
+
+#if !defined(PPH_MONEY_INLINE_NO_REDIRECT)
+
+/* Function-like, so the exported declarations and &pph_money_add are untouched */
+#define pph_money_add(a, b)                  pph_money_add_inline((a), (b))
+#define pph_money_sub(a, b)                  pph_money_sub_inline((a), (b))
+#define pph_money_neg(a)                     pph_money_neg_inline(a)
+#define pph_money_mul_int(a, scalar)         pph_money_mul_int_inline((a), (scalar))
+#define pph_money_div(a, divisor)            pph_money_div_inline((a), (divisor))
+#define pph_money_cmp(a, b)                  pph_money_cmp_inline((a), (b))
+#define pph_money_min(a, b)                  pph_money_min_inline((a), (b))
+#define pph_money_max(a, b)                  pph_money_max_inline((a), (b))
+#define pph_money_round_down_thousand(value) pph_money_round_down_thousand_inline(value)
+#define pph_money_floor(value)               pph_money_floor_inline(value)
+
+#endif /* PPH_MONEY_INLINE_NO_REDIRECT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PPH_MONEY_INLINE_H */
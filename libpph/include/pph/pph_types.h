@@ -90,6 +90,7 @@
         typedef int8_t pph_int8_t;
         typedef uint8_t pph_uint8_t;
         #define PPH_INT64_C(x) (x##LL)
+        #define PPH_UINT64_C(x) (x##ULL)
         #define PPH_INLINE inline
     #else
         /* Last resort: assume long long exists */
@@ -102,6 +103,7 @@
         typedef signed char pph_int8_t;
         typedef unsigned char pph_uint8_t;
         #define PPH_INT64_C(x) (x##LL)
+        #define PPH_UINT64_C(x) (x##ULL)
         #define PPH_INLINE static
     #endif
 #endif
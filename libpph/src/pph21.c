@@ -4,6 +4,7 @@
  */
 
 #include <pph/pph_calculator.h>
+#include <pph/pph_money_inline.h>
 #include "pph_internal.h"
 #include <string.h>
 #include <stdio.h>
@@ -15,6 +16,98 @@ static int clamp_months(int months) {
     return months;
 }
 
+/* ============================================
+   Range Checks
+
+   Every intermediate of a calculation stays within a small multiple of
+   the record's magnitude: twelve months of salary and pension plus the
+   bonuses and zakat. At or below PPH21_SAFE_MAGNITUDE (about Rp 57
+   trillion) nothing can overflow, so only the magnitude itself is
+   computed with checked arithmetic, and batches are first certified a
+   block at a time from the largest amounts they hold.
+   ============================================ */
+
+#define PPH21_CERTIFY_BLOCK 256
+
+static pph_uint64_t money_magnitude(pph_money_t amount) {
+    return (amount.value < 0) ? (pph_uint64_t)0 - (pph_uint64_t)amount.value
+                              : (pph_uint64_t)amount.value;
+}
+
+/* total += |amount| * times */
+static pph_status_t add_magnitude(pph_money_t *total, pph_money_t amount, int times) {
+    pph_money_t term;
+
+    if (amount.value < 0 && pph_money_sub_checked(PPH_ZERO, amount, &amount) != PPH_OK) {
+        return PPH_ERR_OVERFLOW;
+    }
+    if (pph_money_mul_int_checked(amount, times, &term) != PPH_OK) {
+        return PPH_ERR_OVERFLOW;
+    }
+    return pph_money_add_checked(*total, term, total);
+}
+
+static pph_status_t check_record_range(const pph21_input_t *input) {
+    pph_money_t total = PPH_ZERO;
+    pph_status_t status;
+    int i, months = clamp_months(input->months_paid);
+
+    status = add_magnitude(&total, input->bruto_monthly, months);
+    if (status == PPH_OK) {
+        status = add_magnitude(&total, input->pension_contribution, months);
+    }
+    if (status == PPH_OK) {
+        status = add_magnitude(&total, input->zakat_or_donation, 1);
+    }
+    for (i = 0; status == PPH_OK && input->bonuses != NULL && i < input->bonus_count; i++) {
+        status = add_magnitude(&total, input->bonuses[i].amount, 1);
+    }
+
+    if (status != PPH_OK || (pph_uint64_t)total.value > PPH21_SAFE_MAGNITUDE) {
+        pph_set_last_error("Amounts out of range");
+        return PPH_ERR_OVERFLOW;
+    }
+    return PPH_OK;
+}
+
+/* True when no record in the block can overflow: twelve times the largest
+   monthly amounts plus the largest one-off total is in range. Each term
+   is capped first, so the unsigned sums below cannot wrap. */
+static int certify_block(const pph21_input_t *inputs, pph_size_t count) {
+    pph_uint64_t max_monthly = 0, max_once = 0, monthly, once, amount;
+    pph_size_t i;
+    int j;
+
+    for (i = 0; i < count; i++) {
+        const pph21_input_t *input = &inputs[i];
+
+        monthly = money_magnitude(input->bruto_monthly);
+        amount = money_magnitude(input->pension_contribution);
+        once = money_magnitude(input->zakat_or_donation);
+        if (monthly > PPH21_SAFE_MAGNITUDE || amount > PPH21_SAFE_MAGNITUDE ||
+            once > PPH21_SAFE_MAGNITUDE) {
+            return 0;
+        }
+        monthly += amount;
+
+        for (j = 0; input->bonuses != NULL && j < input->bonus_count; j++) {
+            amount = money_magnitude(input->bonuses[j].amount);
+            if (amount > PPH21_SAFE_MAGNITUDE) {
+                return 0;
+            }
+            once += amount;
+            if (once > PPH21_SAFE_MAGNITUDE) {
+                return 0;
+            }
+        }
+
+        max_monthly = (monthly > max_monthly) ? monthly : max_monthly;
+        max_once = (once > max_once) ? once : max_once;
+    }
+
+    return max_monthly * 12 + max_once <= PPH21_SAFE_MAGNITUDE;
+}
+
 /* ============================================
    Pegawai Tetap (Permanent Employee)
    ============================================ */
@@ -22,95 +115,117 @@ static int clamp_months(int months) {
 #define __BONUS_NAME_STR_LEN (256)
 #define __NOTE_STR_LEN (__BONUS_NAME_STR_LEN * 2)
 
-static pph_result_t* calculate_pegawai_tetap(const pph21_input_t *input) {
-    pph_result_t *result;
+/* Numbers of a Pegawai Tetap calculation, shared by the breakdown and
+   the totals-only paths */
+typedef struct {
     int months;
-    pph_money_t bruto_tahun, iuran_tahun, biaya_jabatan, netto_setahun;
+    pph_money_t gaji_tahun, bruto_tahun, iuran_tahun, biaya_jabatan, netto_setahun;
     pph_money_t ptkp, pkp_rounded, pajak_setahun;
-    char note[__NOTE_STR_LEN];
 
-    result = pph_result_create();
-    if (!result) {
-        pph_set_last_error("Memory allocation failed");
-        return NULL;
-    }
+    /* TER scheme only */
+    pph_money_t monthly_income[12];
+    pph_money_t monthly_rate[12];
+    pph_money_t monthly_ter[12];
+    pph_money_t ter_paid, adjustment;
+} pegawai_tetap_calc_t;
+
+/* Annual Pasal 17 tax from bruto_tahun and iuran_tahun already in calc */
+static void compute_annual_tax(pegawai_tetap_calc_t *calc, pph_money_t zakat,
+                               pph_ptkp_status_t ptkp_status) {
+    /* Biaya jabatan: min(5% * bruto, 6 juta) */
+    calc->biaya_jabatan = pph_money_percent(calc->bruto_tahun, 5, 100);
+    calc->biaya_jabatan = pph_money_min(calc->biaya_jabatan, PPH_RUPIAH(6000000));
+
+    calc->netto_setahun = pph_money_sub(
+        pph_money_sub(
+            pph_money_sub(calc->bruto_tahun, calc->biaya_jabatan),
+            calc->iuran_tahun),
+        zakat);
+
+    calc->ptkp = pph_get_ptkp(ptkp_status);
+    calc->pkp_rounded = pph_money_round_down_thousand(
+        pph_money_floor(pph_money_sub(calc->netto_setahun, calc->ptkp)));
+
+    /* Annual progressive tax (Pasal 17) */
+    calc->pajak_setahun = pph_calculate_pasal17(calc->pkp_rounded);
+}
+
+static void compute_pegawai_tetap(const pph21_input_t *input, pegawai_tetap_calc_t *calc) {
+    int i, m, months;
 
     months = clamp_months(input->months_paid);
+    calc->months = months;
 
     /* Annual calculations */
-    bruto_tahun = pph_money_mul_int(input->bruto_monthly, months);
+    calc->gaji_tahun = pph_money_mul_int(input->bruto_monthly, months);
+    calc->bruto_tahun = calc->gaji_tahun;
 
     /* Add all bonuses to annual bruto */
     if (input->bonuses != NULL && input->bonus_count > 0) {
-        int i;
         for (i = 0; i < input->bonus_count; i++) {
-            bruto_tahun = pph_money_add(bruto_tahun, input->bonuses[i].amount);
+            calc->bruto_tahun = pph_money_add(calc->bruto_tahun, input->bonuses[i].amount);
         }
     }
 
-    iuran_tahun = pph_money_mul_int(input->pension_contribution, months);
+    calc->iuran_tahun = pph_money_mul_int(input->pension_contribution, months);
 
-    /* Biaya jabatan: min(5% * bruto, 6 juta) */
-    biaya_jabatan = pph_money_percent(bruto_tahun, 5, 100);
-    biaya_jabatan = pph_money_min(biaya_jabatan, PPH_RUPIAH(6000000));
+    compute_annual_tax(calc, input->zakat_or_donation, input->ptkp_status);
 
-    netto_setahun = pph_money_sub(
-        pph_money_sub(
-            pph_money_sub(bruto_tahun, biaya_jabatan),
-            iuran_tahun),
-        input->zakat_or_donation);
+    calc->ter_paid = PPH_ZERO;
+    calc->adjustment = PPH_ZERO;
+    for (i = 0; i < 12; i++) {
+        calc->monthly_rate[i] = PPH_ZERO;
+        calc->monthly_ter[i] = PPH_ZERO;
+    }
 
-    ptkp = pph_get_ptkp(input->ptkp_status);
-    pkp_rounded = pph_money_round_down_thousand(
-        pph_money_floor(pph_money_sub(netto_setahun, ptkp)));
+    if (input->scheme != PPH21_SCHEME_TER) {
+        return;
+    }
 
-    if (input->scheme == PPH21_SCHEME_TER) {
-        /* TER scheme with month-by-month calculation */
-        pph_money_t monthly_income[12];
-        pph_money_t monthly_ter[12];
-        pph_money_t ter_paid, pajak_setahun, adjustment;
-        int i, m;
-
-        /* Initialize monthly income with base salary */
-        for (i = 0; i < 12; i++) {
-            monthly_income[i] = (i < months) ? input->bruto_monthly : PPH_ZERO;
-        }
+    /* TER scheme: initialize monthly income with base salary */
+    for (i = 0; i < 12; i++) {
+        calc->monthly_income[i] = (i < months) ? input->bruto_monthly : PPH_ZERO;
+    }
 
-        /* Add bonuses to appropriate months */
-        if (input->bonuses != NULL && input->bonus_count > 0) {
-            for (i = 0; i < input->bonus_count; i++) {
-                m = input->bonuses[i].month - 1;  /* Convert to 0-indexed */
-                if (m >= 0 && m < 12 && m < months) {
-                    monthly_income[m] = pph_money_add(monthly_income[m], input->bonuses[i].amount);
-                }
+    /* Add bonuses to appropriate months */
+    if (input->bonuses != NULL && input->bonus_count > 0) {
+        for (i = 0; i < input->bonus_count; i++) {
+            m = input->bonuses[i].month - 1;  /* Convert to 0-indexed */
+            if (m >= 0 && m < 12 && m < months) {
+                calc->monthly_income[m] = pph_money_add(calc->monthly_income[m], input->bonuses[i].amount);
             }
         }
+    }
 
-        /* Calculate TER for each month (months 1-11 only) */
-        ter_paid = PPH_ZERO;
-        for (i = 0; i < 11 && i < months; i++) {
-            pph_money_t ter_rate, month_tax;
-            ter_rate = pph_get_ter_bulanan_rate(input->ter_category, monthly_income[i]);
-            month_tax = pph_money_mul(monthly_income[i], ter_rate);
-            monthly_ter[i] = month_tax;
-            ter_paid = pph_money_add(ter_paid, month_tax);
-        }
+    /* Calculate TER for each month (months 1-11 only) */
+    for (i = 0; i < 11 && i < months; i++) {
+        calc->monthly_rate[i] = pph_get_ter_bulanan_rate(input->ter_category, calc->monthly_income[i]);
+        calc->monthly_ter[i] = pph_money_mul(calc->monthly_income[i], calc->monthly_rate[i]);
+        calc->ter_paid = pph_money_add(calc->ter_paid, calc->monthly_ter[i]);
+    }
+
+    /* Month 12 adjustment */
+    calc->adjustment = pph_money_sub(calc->pajak_setahun, calc->ter_paid);
+}
 
-        /* Annual progressive tax (Pasal 17) */
-        pajak_setahun = pph_calculate_pasal17(pkp_rounded);
+static pph_status_t calculate_pegawai_tetap(const pph21_input_t *input, pph_result_t *result) {
+    pegawai_tetap_calc_t calc;
+    char note[__NOTE_STR_LEN];
+    int i;
 
-        /* Month 12 adjustment */
-        adjustment = pph_money_sub(pajak_setahun, ter_paid);
+    compute_pegawai_tetap(input, &calc);
 
+    if (input->scheme == PPH21_SCHEME_TER) {
         /* Show TER withholding breakdown */
-        pph_result_add_section(result, "Pemotongan TER (Bulan 1-11)");
+        pph_result_add_section(result, PPH_LABEL_SECTION_TER);
 
         /* Group months by income for cleaner display */
         {
             int regular_count = 0;
+            int regular_month = -1;
             pph_money_t regular_total = PPH_ZERO;
 
-            for (i = 0; i < 11 && i < months; i++) {
+            for (i = 0; i < 11 && i < calc.months; i++) {
                 /* Check if this month has bonus */
                 int has_bonus = 0;
                 if (input->bonuses != NULL && input->bonus_count > 0) {
@@ -125,7 +240,6 @@ static pph_result_t* calculate_pegawai_tetap(const pph21_input_t *input) {
 
                 if (has_bonus) {
                     /* Show bonus month separately */
-                    pph_money_t ter_rate = pph_get_ter_bulanan_rate(input->ter_category, monthly_income[i]);
                     char bonus_names[__BONUS_NAME_STR_LEN] = "";
 
                     /* Collect bonus names for this month */
@@ -141,144 +255,417 @@ static pph_result_t* calculate_pegawai_tetap(const pph21_input_t *input) {
                     }
 
                     snprintf(note, sizeof(note), "Bulan %d (%s)", i + 1, bonus_names);
-                    pph_result_add_currency(result, note, monthly_income[i], NULL);
-                    pph_result_add_percent(result, "  Tarif TER", ter_rate, NULL);
-                    pph_result_add_currency(result, "  PPh 21 TER", monthly_ter[i], NULL);
+                    pph_result_add_currency(result, PPH_LABEL_TER_BONUS_MONTH, calc.monthly_income[i], PPH_LABEL_NONE);
+                    pph_result_set_text(result, note, NULL);
+                    pph_result_add_percent(result, PPH_LABEL_TER_RATE, calc.monthly_rate[i], PPH_LABEL_NONE);
+                    pph_result_add_currency(result, PPH_LABEL_TER_TAX, calc.monthly_ter[i], PPH_LABEL_NONE);
                 } else {
                     /* Regular month */
+                    if (regular_month < 0) {
+                        regular_month = i;
+                    }
                     regular_count++;
-                    regular_total = pph_money_add(regular_total, monthly_ter[i]);
+                    regular_total = pph_money_add(regular_total, calc.monthly_ter[i]);
                 }
             }
 
-            /* Show regular months summary */
+            /* Show regular months summary (every regular month has the same rate) */
             if (regular_count > 0) {
-                pph_money_t ter_rate = pph_get_ter_bulanan_rate(input->ter_category, input->bruto_monthly);
-                pph_money_t monthly_ter = pph_money_mul(input->bruto_monthly, ter_rate);
                 snprintf(note, sizeof(note), "%d bulan reguler", regular_count);
-                pph_result_add_currency(result, note, input->bruto_monthly, "per bulan");
-                pph_result_add_percent(result, "  Tarif TER", ter_rate, NULL);
-                pph_result_add_currency(result, "  PPh 21 TER per bulan", monthly_ter, NULL);
-                pph_result_add_currency(result, "  Total PPh 21 TER", regular_total, NULL);
+                pph_result_add_currency(result, PPH_LABEL_TER_REGULAR_MONTHS, input->bruto_monthly,
+                                        PPH_LABEL_NOTE_PER_MONTH);
+                pph_result_set_text(result, note, NULL);
+                pph_result_add_percent(result, PPH_LABEL_TER_RATE, calc.monthly_rate[regular_month], PPH_LABEL_NONE);
+                pph_result_add_currency(result, PPH_LABEL_TER_TAX_PER_MONTH, calc.monthly_ter[regular_month], PPH_LABEL_NONE);
+                pph_result_add_currency(result, PPH_LABEL_TER_TAX_TOTAL, regular_total, PPH_LABEL_NONE);
             }
         }
 
-        pph_result_add_currency(result, "Total TER bulan 1-11", ter_paid, NULL);
+        pph_result_add_currency(result, PPH_LABEL_TER_PAID, calc.ter_paid, PPH_LABEL_NONE);
 
         /* Show annual progressive calculation */
-        pph_result_add_section(result, "Perhitungan Tahunan (Pasal 17)");
-        pph_result_add_currency(result, "Bruto setahun", bruto_tahun, NULL);
-        pph_result_add_currency(result, "Biaya jabatan (5%, maks 6 jt)", biaya_jabatan, NULL);
-        pph_result_add_currency(result, "Netto setahun", netto_setahun, NULL);
-        pph_result_add_currency(result, "PTKP", ptkp, NULL);
-        pph_result_add_currency(result, "PKP (dibulatkan ribuan)", pkp_rounded, NULL);
-        pph_result_add_currency(result, "PPh 21 setahun (progresif)", pajak_setahun, NULL);
+        pph_result_add_section(result, PPH_LABEL_SECTION_ANNUAL);
+        pph_result_add_currency(result, PPH_LABEL_BRUTO_SETAHUN, calc.bruto_tahun, PPH_LABEL_NONE);
+        pph_result_add_currency(result, PPH_LABEL_BIAYA_JABATAN, calc.biaya_jabatan, PPH_LABEL_NONE);
+        pph_result_add_currency(result, PPH_LABEL_NETTO_SETAHUN, calc.netto_setahun, PPH_LABEL_NONE);
+        pph_result_add_currency(result, PPH_LABEL_PTKP, calc.ptkp, PPH_LABEL_NONE);
+        pph_result_add_currency(result, PPH_LABEL_PKP, calc.pkp_rounded, PPH_LABEL_NONE);
+        pph_result_add_currency(result, PPH_LABEL_PPH21_PROGRESSIVE, calc.pajak_setahun, PPH_LABEL_NONE);
 
         /* Show month 12 adjustment */
-        pph_result_add_section(result, "Penyesuaian Bulan 12");
-        pph_result_add_currency(result, "PPh 21 setahun", pajak_setahun, NULL);
-        pph_result_add_currency(result, "TER telah dipotong (bln 1-11)", ter_paid, NULL);
-        pph_result_add_currency(result, "Kurang/(lebih) bayar bulan 12", adjustment, NULL);
-
-        result->total_tax = pajak_setahun;
+        pph_result_add_section(result, PPH_LABEL_SECTION_DECEMBER);
+        pph_result_add_currency(result, PPH_LABEL_PPH21_SETAHUN, calc.pajak_setahun, PPH_LABEL_NONE);
+        pph_result_add_currency(result, PPH_LABEL_TER_DEDUCTED, calc.ter_paid, PPH_LABEL_NONE);
+        pph_result_add_currency(result, PPH_LABEL_DECEMBER_BALANCE, calc.adjustment, PPH_LABEL_NONE);
     } else {
         /* Traditional Pasal 17 scheme */
-        pajak_setahun = pph_calculate_pasal17(pkp_rounded);
-
-        pph_result_add_section(result, "Penghasilan Bruto");
-        pph_result_add_currency(result, "Gaji per bulan", input->bruto_monthly, NULL);
-        snprintf(note, sizeof(note), "%d bulan", months);
-        pph_result_add_currency(result, "Gaji setahun", pph_money_mul_int(input->bruto_monthly, months), note);
+        pph_result_add_section(result, PPH_LABEL_SECTION_BRUTO);
+        pph_result_add_currency(result, PPH_LABEL_GAJI_PER_BULAN, input->bruto_monthly, PPH_LABEL_NONE);
+        snprintf(note, sizeof(note), "%d bulan", calc.months);
+        pph_result_add_currency(result, PPH_LABEL_GAJI_SETAHUN, calc.gaji_tahun, PPH_LABEL_NOTE_MONTHS);
+        pph_result_set_text(result, NULL, note);
         if (input->bonuses != NULL && input->bonus_count > 0) {
-            int i;
             for (i = 0; i < input->bonus_count; i++) {
-                pph_result_add_currency(result, input->bonuses[i].name, input->bonuses[i].amount, NULL);
+                pph_result_add_currency(result, PPH_LABEL_BONUS, input->bonuses[i].amount, PPH_LABEL_NONE);
+                pph_result_set_text(result, input->bonuses[i].name, NULL);
             }
         }
-        pph_result_add_subtotal(result, "Total bruto", bruto_tahun);
+        pph_result_add_subtotal(result, PPH_LABEL_TOTAL_BRUTO, calc.bruto_tahun);
 
-        pph_result_add_section(result, "Pengurang");
-        pph_result_add_currency(result, "Biaya jabatan (5%, maks 6 jt)", biaya_jabatan, NULL);
-        pph_result_add_currency(result, "Iuran pensiun", iuran_tahun, NULL);
+        pph_result_add_section(result, PPH_LABEL_SECTION_DEDUCTIONS);
+        pph_result_add_currency(result, PPH_LABEL_BIAYA_JABATAN, calc.biaya_jabatan, PPH_LABEL_NONE);
+        pph_result_add_currency(result, PPH_LABEL_IURAN_PENSIUN, calc.iuran_tahun, PPH_LABEL_NONE);
         if (input->zakat_or_donation.value > 0) {
-            pph_result_add_currency(result, "Zakat/sumbangan", input->zakat_or_donation, NULL);
+            pph_result_add_currency(result, PPH_LABEL_ZAKAT, input->zakat_or_donation, PPH_LABEL_NONE);
         }
-        pph_result_add_subtotal(result, "Netto setahun", netto_setahun);
+        pph_result_add_subtotal(result, PPH_LABEL_NETTO_SETAHUN, calc.netto_setahun);
 
-        pph_result_add_section(result, "PKP dan Pajak");
-        pph_result_add_currency(result, "PTKP", ptkp, NULL);
-        pph_result_add_currency(result, "PKP (dibulatkan ribuan)", pkp_rounded, NULL);
-        pph_result_add_total(result, "PPh 21 setahun", pajak_setahun);
-
-        result->total_tax = pajak_setahun;
+        pph_result_add_section(result, PPH_LABEL_SECTION_PKP);
+        pph_result_add_currency(result, PPH_LABEL_PTKP, calc.ptkp, PPH_LABEL_NONE);
+        pph_result_add_currency(result, PPH_LABEL_PKP, calc.pkp_rounded, PPH_LABEL_NONE);
+        pph_result_add_total(result, PPH_LABEL_PPH21_SETAHUN, calc.pajak_setahun);
     }
 
-    return result;
+    result->total_tax = calc.pajak_setahun;
+    return PPH_OK;
+}
+
+static void summarize_pegawai_tetap(const pph21_input_t *input, pph21_summary_t *summary) {
+    pegawai_tetap_calc_t calc;
+    int i;
+
+    compute_pegawai_tetap(input, &calc);
+
+    summary->total_tax = calc.pajak_setahun;
+    summary->ter_paid = calc.ter_paid;
+    summary->adjustment = calc.adjustment;
+    for (i = 0; i < 12; i++) {
+        summary->monthly_ter[i] = calc.monthly_ter[i];
+    }
 }
 
 /* ============================================
    Other Subject Types (Simplified)
    ============================================ */
 
-static pph_result_t* calculate_simple(const pph21_input_t *input, const char *subject_name) {
-    pph_result_t *result;
+static pph_money_t compute_simple(const pph21_input_t *input) {
+    /* Simple 5% flat rate for demonstration */
+    return pph_money_percent(input->bruto_monthly, 5, 100);
+}
+
+static pph_status_t calculate_simple(const pph21_input_t *input, pph_label_id_t section,
+                                     pph_result_t *result) {
     pph_money_t tax;
 
+    tax = compute_simple(input);
+
+    pph_result_add_section(result, section);
+    pph_result_add_currency(result, PPH_LABEL_PENGHASILAN_BRUTO, input->bruto_monthly, PPH_LABEL_NONE);
+    pph_result_add_percent(result, PPH_LABEL_TARIF, PPH_MONEY(0, 500), PPH_LABEL_NOTE_FLAT_RATE);
+    pph_result_add_total(result, PPH_LABEL_PPH21, tax);
+
+    result->total_tax = tax;
+    return PPH_OK;
+}
+
+/* ============================================
+   Main Entry Point
+   ============================================ */
+
+/* Dispatch on subject type, writing breakdown and total into result */
+static pph_status_t calculate_into(const pph21_input_t *input, pph_result_t *result) {
+    switch (input->subject_type) {
+        case PPH21_PEGAWAI_TETAP:
+            return calculate_pegawai_tetap(input, result);
+
+        case PPH21_PENSIUNAN:
+            return calculate_simple(input, PPH_LABEL_SECTION_PENSIUNAN, result);
+
+        case PPH21_PEGAWAI_TIDAK_TETAP:
+            return calculate_simple(input, PPH_LABEL_SECTION_TIDAK_TETAP, result);
+
+        case PPH21_BUKAN_PEGAWAI:
+            return calculate_simple(input, PPH_LABEL_SECTION_BUKAN_PEGAWAI, result);
+
+        case PPH21_PESERTA_KEGIATAN:
+            return calculate_simple(input, PPH_LABEL_SECTION_PESERTA_KEGIATAN, result);
+
+        case PPH21_PROGRAM_PENSIUN:
+            return calculate_simple(input, PPH_LABEL_SECTION_PROGRAM_PENSIUN, result);
+
+        case PPH21_MANTAN_PEGAWAI:
+            return calculate_simple(input, PPH_LABEL_SECTION_MANTAN_PEGAWAI, result);
+
+        case PPH21_WPLN:
+            return calculate_simple(input, PPH_LABEL_SECTION_WPLN, result);
+
+        default:
+            pph_set_last_error("Unknown subject type");
+            return PPH_ERR_INVALID_INPUT;
+    }
+}
+
+pph_result_t* pph21_calculate(const pph21_input_t *input) {
+    pph_result_t *result;
+    pph_status_t status;
+
+    if (input == NULL) {
+        pph_set_last_error("Input is NULL");
+        return NULL;
+    }
+
     result = pph_result_create();
     if (!result) {
         pph_set_last_error("Memory allocation failed");
         return NULL;
     }
 
-    /* Simple 5% flat rate for demonstration */
-    tax = pph_money_percent(input->bruto_monthly, 5, 100);
+    status = check_record_range(input);
+    if (status == PPH_OK) {
+        /* Breakdown and totals come from one ruleset */
+        pph_rules_enter();
+        status = calculate_into(input, result);
+        pph_rules_exit();
+    }
 
-    pph_result_add_section(result, subject_name);
-    pph_result_add_currency(result, "Penghasilan bruto", input->bruto_monthly, NULL);
-    pph_result_add_percent(result, "Tarif", PPH_MONEY(0, 500), "5%");
-    pph_result_add_total(result, "PPh 21", tax);
+    if (status != PPH_OK) {
+        pph_result_free(result);
+        return NULL;
+    }
 
-    result->total_tax = tax;
     return result;
 }
 
 /* ============================================
-   Main Entry Point
+   Totals-Only Entry Points
    ============================================ */
 
-pph_result_t* pph21_calculate(const pph21_input_t *input) {
-    if (input == NULL) {
-        pph_set_last_error("Input is NULL");
-        return NULL;
+static void summary_clear(pph21_summary_t *summary) {
+    int i;
+
+    summary->total_tax = PPH_ZERO;
+    summary->ter_paid = PPH_ZERO;
+    summary->adjustment = PPH_ZERO;
+    for (i = 0; i < 12; i++) {
+        summary->monthly_ter[i] = PPH_ZERO;
     }
+}
+
+/* Fill summary for one record; no breakdown, no allocation */
+static pph_status_t summarize_into(const pph21_input_t *input, pph21_summary_t *summary) {
+    summary_clear(summary);
 
     switch (input->subject_type) {
         case PPH21_PEGAWAI_TETAP:
-            return calculate_pegawai_tetap(input);
+            summarize_pegawai_tetap(input, summary);
+            return PPH_OK;
 
         case PPH21_PENSIUNAN:
-            return calculate_simple(input, "Pensiunan");
-
         case PPH21_PEGAWAI_TIDAK_TETAP:
-            return calculate_simple(input, "Pegawai Tidak Tetap");
-
         case PPH21_BUKAN_PEGAWAI:
-            return calculate_simple(input, "Bukan Pegawai");
-
         case PPH21_PESERTA_KEGIATAN:
-            return calculate_simple(input, "Peserta Kegiatan");
-
         case PPH21_PROGRAM_PENSIUN:
-            return calculate_simple(input, "Program Pensiun");
-
         case PPH21_MANTAN_PEGAWAI:
-            return calculate_simple(input, "Mantan Pegawai");
-
         case PPH21_WPLN:
-            return calculate_simple(input, "WPLN (PPh 26)");
+            summary->total_tax = compute_simple(input);
+            return PPH_OK;
 
         default:
             pph_set_last_error("Unknown subject type");
-            return NULL;
+            return PPH_ERR_INVALID_INPUT;
     }
 }
+
+/* summarize_into() after the record's range check */
+static pph_status_t summarize_checked(const pph21_input_t *input, pph21_summary_t *summary) {
+    if (check_record_range(input) != PPH_OK) {
+        summary_clear(summary);
+        return PPH_ERR_OVERFLOW;
+    }
+    return summarize_into(input, summary);
+}
+
+pph_status_t pph21_calculate_summary(const pph21_input_t *input, pph21_summary_t *summary) {
+    if (summary == NULL) {
+        pph_set_last_error("Output is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    if (input == NULL) {
+        summary_clear(summary);
+        summary->status = PPH_ERR_NULL_INPUT;
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    pph_rules_enter();
+    summary->status = summarize_checked(input, summary);
+    pph_rules_exit();
+    return summary->status;
+}
+
+pph_status_t pph21_calculate_batch(const pph21_input_t *inputs,
+                                   pph_size_t count,
+                                   pph21_summary_t *outputs) {
+    pph_status_t first_error = PPH_OK;
+    pph_size_t i, end = 0;
+    int certified = 0;
+
+    if (count == 0) {
+        return PPH_OK;
+    }
+
+    if (inputs == NULL || outputs == NULL) {
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    pph_rules_enter();
+    for (i = 0; i < count; i++) {
+        /* Certified blocks skip the per-record range checks */
+        if (i % PPH21_CERTIFY_BLOCK == 0) {
+            end = (count - i < PPH21_CERTIFY_BLOCK) ? count : i + PPH21_CERTIFY_BLOCK;
+            certified = certify_block(&inputs[i], end - i);
+        }
+
+        outputs[i].status = certified ? summarize_into(&inputs[i], &outputs[i])
+                                      : summarize_checked(&inputs[i], &outputs[i]);
+
+        if (outputs[i].status != PPH_OK && first_error == PPH_OK) {
+            first_error = outputs[i].status;
+        }
+    }
+    pph_rules_exit();
+
+    return first_error;
+}
+
+pph_status_t pph21_calculate_batch_dated(const pph_ruleset_registry_t *registry,
+                                         const pph21_input_t *inputs,
+                                         const long *dates,
+                                         pph_size_t count,
+                                         pph21_summary_t *outputs) {
+    const pph_rules_t *rules = NULL;
+    pph_status_t first_error = PPH_OK;
+    pph_size_t i;
+
+    if (count == 0) {
+        return PPH_OK;
+    }
+
+    if (registry == NULL || inputs == NULL || dates == NULL || outputs == NULL) {
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    for (i = 0; i < count; i++) {
+        /* Records are usually grouped by period; search once per run */
+        if (i == 0 || dates[i] != dates[i - 1]) {
+            rules = pph_ruleset_registry_rules(registry, dates[i]);
+        }
+
+        if (rules == NULL) {
+            summary_clear(&outputs[i]);
+            outputs[i].status = PPH_ERR_INVALID_INPUT;
+            pph_set_last_error("No ruleset in force on the record date");
+        } else {
+            const pph_rules_t *previous = pph_rules_adopt(rules);
+
+            outputs[i].status = summarize_checked(&inputs[i], &outputs[i]);
+            pph_rules_restore(previous);
+        }
+
+        if (outputs[i].status != PPH_OK && first_error == PPH_OK) {
+            first_error = outputs[i].status;
+        }
+    }
+
+    return first_error;
+}
+
+/* ============================================
+   Year-to-Date Monthly Withholding (Pegawai Tetap)
+   ============================================ */
+
+void pph21_ytd_init(pph21_ytd_state_t *state, pph_ptkp_status_t ptkp_status,
+                    pph21_scheme_t scheme, pph21_ter_category_t ter_category) {
+    if (state == NULL) {
+        return;
+    }
+
+    state->months_applied = 0;
+    state->closed = 0;
+    state->ptkp_status = ptkp_status;
+    state->scheme = scheme;
+    state->ter_category = ter_category;
+    state->bruto_ytd = PPH_ZERO;
+    state->pension_ytd = PPH_ZERO;
+    state->zakat_ytd = PPH_ZERO;
+    state->withheld_ytd = PPH_ZERO;
+}
+
+pph_status_t pph21_ytd_apply_month(pph21_ytd_state_t *state,
+                                   const pph21_month_input_t *month,
+                                   pph21_month_result_t *result) {
+    pph_money_t income, bruto_ytd, pension_ytd, zakat_ytd;
+
+    if (state == NULL || month == NULL || result == NULL) {
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    if (state->closed || state->months_applied >= 12) {
+        pph_set_last_error("Tax year already closed");
+        return PPH_ERR_INVALID_INPUT;
+    }
+
+    /* The running totals are a record's magnitude under construction */
+    if (pph_money_add_checked(month->bruto, month->bonus, &income) != PPH_OK ||
+        pph_money_add_checked(state->bruto_ytd, income, &bruto_ytd) != PPH_OK ||
+        pph_money_add_checked(state->pension_ytd, month->pension_contribution, &pension_ytd) != PPH_OK ||
+        pph_money_add_checked(state->zakat_ytd, month->zakat_or_donation, &zakat_ytd) != PPH_OK ||
+        money_magnitude(bruto_ytd) > PPH21_SAFE_MAGNITUDE ||
+        money_magnitude(pension_ytd) > PPH21_SAFE_MAGNITUDE ||
+        money_magnitude(zakat_ytd) > PPH21_SAFE_MAGNITUDE) {
+        pph_set_last_error("Amounts out of range");
+        return PPH_ERR_OVERFLOW;
+    }
+
+    pph_rules_enter();
+    state->months_applied++;
+    state->bruto_ytd = bruto_ytd;
+    state->pension_ytd = pension_ytd;
+    state->zakat_ytd = zakat_ytd;
+
+    result->month = state->months_applied;
+    result->income = income;
+
+    if (state->months_applied < 12 && !month->is_final) {
+        /* Months before the true-up: TER on this month's income only */
+        result->is_true_up = 0;
+        if (state->scheme == PPH21_SCHEME_TER) {
+            result->rate = pph_get_ter_bulanan_rate(state->ter_category, income);
+            result->withholding = pph_money_mul(income, result->rate);
+        } else {
+            result->rate = PPH_ZERO;
+            result->withholding = PPH_ZERO;
+        }
+    } else {
+        /* True-up: annual Pasal 17 on the year so far, less what was withheld */
+        pegawai_tetap_calc_t calc;
+
+        calc.bruto_tahun = state->bruto_ytd;
+        calc.iuran_tahun = state->pension_ytd;
+        compute_annual_tax(&calc, state->zakat_ytd, state->ptkp_status);
+
+        result->is_true_up = 1;
+        result->rate = PPH_ZERO;
+        result->withholding = pph_money_sub(calc.pajak_setahun, state->withheld_ytd);
+        state->closed = 1;
+    }
+
+    state->withheld_ytd = pph_money_add(state->withheld_ytd, result->withholding);
+    result->withheld_ytd = state->withheld_ytd;
+    pph_rules_exit();
+    return PPH_OK;
+}
@@ -0,0 +1,252 @@
+/*
+ * PPH21 Columns - Columnar (struct-of-arrays) PPh 21 batch kernel
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#include <pph/pph_calculator.h>
+#include <pph/pph_money_inline.h>
+#include "pph_internal.h"
+
+/* Records processed per stage; keeps the block scratch small enough for
+   16-bit stacks */
+#define COLUMNS_BLOCK 64
+
+/* Biaya jabatan cap (6 juta) and thousand-rupiah step in money units */
+#define BIAYA_JABATAN_MAX PPH_INT64_C(60000000000)
+#define THOUSAND_RUPIAH PPH_INT64_C(10000000)
+
+/* ============================================
+   TER Bracket Search
+
+   The quantized index built by pph_init() resolves a bracket with one
+   load for practically every income, so a plain loop over the block is
+   all the search needs.
+   ============================================ */
+
+static const pph_ter_table_t* column_ter_table(const pph_rules_t *rules,
+                                               const pph_uint8_t *category, int j) {
+    return pph_ter_monthly_table(rules,
+        category ? (pph21_ter_category_t)category[j] : PPH21_TER_CATEGORY_A);
+}
+
+static void ter_index_block(const pph_rules_t *rules,
+                            const pph_int64_t *income,
+                            const pph_uint8_t *category,
+                            int n, int *index) {
+    int j;
+
+    for (j = 0; j < n; j++) {
+        index[j] = pph_ter_bracket(column_ter_table(rules, category, j), income[j]);
+    }
+}
+
+/* ============================================
+   Range Certification
+
+   The block stages use plain 64-bit arithmetic. A block runs them only
+   when its largest amounts prove, as pph21_calculate_batch() does, that
+   no record can overflow; otherwise every record takes the checked
+   scalar path.
+   ============================================ */
+
+static pph_uint64_t column_magnitude(const pph_int64_t *column, pph_size_t i) {
+    if (column == NULL) {
+        return 0;
+    }
+    return (column[i] < 0) ? (pph_uint64_t)0 - (pph_uint64_t)column[i]
+                           : (pph_uint64_t)column[i];
+}
+
+static int certify_columns_block(const pph21_columns_t *columns, pph_size_t base, int n) {
+    pph_uint64_t max_monthly = 0, max_once = 0, monthly, pension, once;
+    int j;
+
+    for (j = 0; j < n; j++) {
+        pph_size_t i = base + (pph_size_t)j;
+
+        monthly = column_magnitude(columns->bruto_monthly, i);
+        pension = column_magnitude(columns->pension_contribution, i);
+        once = column_magnitude(columns->zakat_or_donation, i);
+        if (monthly > PPH21_SAFE_MAGNITUDE || pension > PPH21_SAFE_MAGNITUDE ||
+            once > PPH21_SAFE_MAGNITUDE) {
+            return 0;
+        }
+        monthly += pension;
+
+        max_monthly = (monthly > max_monthly) ? monthly : max_monthly;
+        max_once = (once > max_once) ? once : max_once;
+    }
+
+    return max_monthly * 12 + max_once <= PPH21_SAFE_MAGNITUDE;
+}
+
+static pph_status_t summarize_record(const pph21_columns_t *columns, pph_size_t i,
+                                     pph21_summary_t *summary) {
+    pph21_input_t input;
+    int has_bonuses = (columns->bonus_start != NULL);
+
+    input.subject_type = PPH21_PEGAWAI_TETAP;
+    input.bruto_monthly.value = columns->bruto_monthly[i];
+    input.months_paid = columns->months_paid ? (int)columns->months_paid[i] : 12;
+    input.pension_contribution.value = columns->pension_contribution ? columns->pension_contribution[i] : 0;
+    input.zakat_or_donation.value = columns->zakat_or_donation ? columns->zakat_or_donation[i] : 0;
+    input.ptkp_status = (pph_ptkp_status_t)columns->ptkp_status[i];
+    input.scheme = columns->scheme ? (pph21_scheme_t)columns->scheme[i] : PPH21_SCHEME_TER;
+    input.ter_category = (pph21_ter_category_t)columns->ter_category[i];
+    input.bonuses = has_bonuses ? columns->bonuses + columns->bonus_start[i] : NULL;
+    input.bonus_count = has_bonuses ? (int)(columns->bonus_start[i + 1] - columns->bonus_start[i]) : 0;
+    input.foreign_tax_rate = PPH_ZERO;
+    input.is_daily_worker = 0;
+
+    return pph21_calculate_summary(&input, summary);
+}
+
+/* Run record i through the checked scalar path and store its results */
+static pph_status_t store_record(const pph21_columns_t *columns, pph_size_t i,
+                                 pph21_column_results_t *results) {
+    pph21_summary_t summary;
+    pph_status_t status = summarize_record(columns, i, &summary);
+
+    results->total_tax[i] = summary.total_tax.value;
+    if (results->ter_paid) results->ter_paid[i] = summary.ter_paid.value;
+    if (results->adjustment) results->adjustment[i] = summary.adjustment.value;
+    if (results->status) results->status[i] = (pph_uint8_t)status;
+    return status;
+}
+
+/* ============================================
+   Columnar Kernel
+   ============================================ */
+
+pph_status_t pph21_calculate_columns(const pph21_columns_t *columns,
+                                     pph21_column_results_t *results) {
+    const pph_rules_t *rules;
+    pph_int64_t ptkp[8];
+    pph_int64_t pkp[COLUMNS_BLOCK];
+    pph_int64_t pasal17[COLUMNS_BLOCK];
+    int months[COLUMNS_BLOCK];
+    int ter_index[COLUMNS_BLOCK];
+    pph_status_t first_error = PPH_OK;
+    pph_size_t base;
+    int j;
+
+    if (columns == NULL || results == NULL) {
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    if (columns->count == 0) {
+        return PPH_OK;
+    }
+
+    if (columns->bruto_monthly == NULL || columns->ptkp_status == NULL ||
+        columns->ter_category == NULL || results->total_tax == NULL ||
+        (columns->bonus_start != NULL && columns->bonuses == NULL)) {
+        pph_set_last_error("Required column is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    rules = pph_rules_enter();
+
+    for (j = 0; j < 8; j++) {
+        ptkp[j] = pph_get_ptkp((pph_ptkp_status_t)j).value;
+    }
+
+    for (base = 0; base < columns->count; base += COLUMNS_BLOCK) {
+        const pph_int64_t *bruto = columns->bruto_monthly + base;
+        int n = (columns->count - base < COLUMNS_BLOCK)
+              ? (int)(columns->count - base) : COLUMNS_BLOCK;
+
+        if (!certify_columns_block(columns, base, n)) {
+            for (j = 0; j < n; j++) {
+                pph_status_t status = store_record(columns, base + (pph_size_t)j, results);
+
+                if (status != PPH_OK && first_error == PPH_OK) {
+                    first_error = status;
+                }
+            }
+            continue;
+        }
+
+        /* Stage 1: annual figures down to rounded PKP */
+        for (j = 0; j < n; j++) {
+            pph_size_t i = base + (pph_size_t)j;
+            pph_int64_t bruto_tahun, biaya_jabatan, netto, taxable;
+            pph_uint8_t status = columns->ptkp_status[i];
+            int m = columns->months_paid ? (int)columns->months_paid[i] : 12;
+
+            if (m < 1) m = 1;
+            if (m > 12) m = 12;
+            months[j] = m;
+
+            bruto_tahun = bruto[j] * m;
+
+            /* Biaya jabatan: min(5% * bruto, 6 juta) */
+            biaya_jabatan = (bruto_tahun * 5) / 100;
+            if (biaya_jabatan > BIAYA_JABATAN_MAX) {
+                biaya_jabatan = BIAYA_JABATAN_MAX;
+            }
+
+            netto = bruto_tahun - biaya_jabatan;
+            if (columns->pension_contribution) {
+                netto -= columns->pension_contribution[i] * m;
+            }
+            if (columns->zakat_or_donation) {
+                netto -= columns->zakat_or_donation[i];
+            }
+
+            taxable = netto - ptkp[(status < 8) ? status : 0];
+            taxable = (taxable < 0) ? 0 : taxable;
+            pkp[j] = (pph_int64_t)pph_udiv_1e7_inline((pph_uint64_t)taxable) * THOUSAND_RUPIAH;
+        }
+
+        /* Stage 2: Pasal 17 tax and TER bracket of the monthly income */
+        pph_calculate_pasal17_block(pkp, n, pasal17);
+        ter_index_block(rules, bruto, columns->ter_category + base, n, ter_index);
+
+        /* Stage 3: TER withholding */
+        for (j = 0; j < n; j++) {
+            pph_size_t i = base + (pph_size_t)j;
+            pph_int64_t tax, ter_paid = 0;
+            int is_ter = (columns->scheme == NULL || columns->scheme[i] == PPH21_SCHEME_TER);
+
+            if (columns->bonus_start != NULL &&
+                columns->bonus_start[i + 1] != columns->bonus_start[i]) {
+                /* Cold path: bonuses change the monthly incomes */
+                pph_status_t status = store_record(columns, i, results);
+
+                if (status != PPH_OK && first_error == PPH_OK) {
+                    first_error = status;
+                }
+                continue;
+            }
+
+            tax = pasal17[j];
+
+            if (is_ter) {
+                const pph_ter_table_t *table = column_ter_table(rules, columns->ter_category + base, j);
+                pph_money_t monthly, month_tax;
+
+                monthly.value = bruto[j];
+                month_tax = pph_money_mul(monthly, pph_ter_rate(table, ter_index[j]));
+
+                /* Without bonuses every TER month withholds the same amount */
+                ter_paid = month_tax.value * ((months[j] < 11) ? months[j] : 11);
+            }
+
+            results->total_tax[i] = tax;
+            if (results->ter_paid) {
+                results->ter_paid[i] = ter_paid;
+            }
+            if (results->adjustment) {
+                results->adjustment[i] = is_ter ? tax - ter_paid : 0;
+            }
+            if (results->status) {
+                results->status[i] = PPH_OK;
+            }
+        }
+    }
+
+    pph_rules_exit();
+    return first_error;
+}
@@ -0,0 +1,536 @@
+/*
+ * PPH21 Curve - PPh 21 as a piecewise function of monthly bruto
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#include <pph/pph_calculator.h>
+#include <pph/pph_money_inline.h>
+#include "pph_internal.h"
+
+/* Biaya jabatan cap (6 juta) and thousand-rupiah step in money units */
+#define BIAYA_JABATAN_MAX PPH_INT64_C(60000000000)
+#define THOUSAND_RUPIAH PPH_INT64_C(10000000)
+
+/* ============================================
+   Exact Pieces of the Calculation
+
+   These mirror compute_pegawai_tetap() for a record without bonuses.
+   Every piece is non-decreasing in bruto, which is what lets the
+   breakpoints be found by bisection.
+   ============================================ */
+
+static pph_int64_t curve_biaya_jabatan(const pph21_curve_t *curve, pph_int64_t bruto) {
+    pph_int64_t biaya = (bruto * curve->months * 5) / 100;
+    return (biaya < BIAYA_JABATAN_MAX) ? biaya : BIAYA_JABATAN_MAX;
+}
+
+/* Rounded PKP; biaya is the biaya jabatan for this bruto */
+static pph_int64_t curve_pkp(const pph21_curve_t *curve, pph_int64_t bruto, pph_int64_t biaya) {
+    pph_int64_t taxable = bruto * curve->months - biaya - curve->fixed_deductions;
+
+    if (taxable < 0) {
+        return 0;
+    }
+    return (pph_int64_t)pph_udiv_1e7_inline((pph_uint64_t)taxable) * THOUSAND_RUPIAH;
+}
+
+/* Smallest bruto in [lo, hi] for which pkp reaches target, or hi + 1 */
+static pph_int64_t bisect_pkp(const pph21_curve_t *curve, pph_int64_t target,
+                              pph_int64_t lo, pph_int64_t hi) {
+    pph_int64_t end = hi + 1;
+
+    while (lo < end) {
+        pph_int64_t mid = lo + (end - lo) / 2;
+
+        if (curve_pkp(curve, mid, curve_biaya_jabatan(curve, mid)) >= target) {
+            end = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+/* Smallest bruto in [lo, hi] at which biaya jabatan hits the cap */
+static pph_int64_t bisect_biaya_cap(const pph21_curve_t *curve, pph_int64_t lo, pph_int64_t hi) {
+    pph_int64_t end = hi + 1;
+
+    while (lo < end) {
+        pph_int64_t mid = lo + (end - lo) / 2;
+
+        if (curve_biaya_jabatan(curve, mid) >= BIAYA_JABATAN_MAX) {
+            end = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+/* ============================================
+   Compilation
+   ============================================ */
+
+/* Returns -1 when the curve has no room for another segment */
+static int add_breakpoint(pph_int64_t *points, int *count, pph_int64_t bruto) {
+    int i, j;
+
+    if (bruto <= 0 || bruto > PPH21_CURVE_BRUTO_MAX) {
+        return 0;
+    }
+
+    /* Insertion keeps the list sorted and unique */
+    for (i = 0; i < *count && points[i] < bruto; i++) {
+    }
+    if (i < *count && points[i] == bruto) {
+        return 0;
+    }
+    if (*count >= PPH21_CURVE_MAX_SEGMENTS - 1) {
+        return -1;
+    }
+    for (j = *count; j > i; j--) {
+        points[j] = points[j - 1];
+    }
+    points[i] = bruto;
+    (*count)++;
+    return 0;
+}
+
+/* Fill a segment from the state of the calculation at its first bruto */
+static void init_segment(const pph_rules_t *rules, const pph21_curve_t *curve,
+                         pph21_curve_segment_t *seg, pph_int64_t bruto) {
+    const pph_pasal17_bracket_t *brackets = rules->brackets;
+    pph_int64_t biaya, pkp;
+    int i;
+
+    biaya = curve_biaya_jabatan(curve, bruto);
+    pkp = curve_pkp(curve, bruto, biaya);
+
+    seg->bruto_start = bruto;
+    seg->biaya_capped = (biaya >= BIAYA_JABATAN_MAX);
+
+    /* Pasal 17 bracket holding pkp */
+    for (i = rules->bracket_count - 1; pkp < brackets[i].start.value; i--) {
+    }
+    seg->layer_start = brackets[i].start.value;
+    seg->layer_base_tax = brackets[i].base_tax.value;
+    seg->layer_rate = brackets[i].rate;
+
+    if (curve->scheme == PPH21_SCHEME_TER) {
+        const pph_ter_table_t *table = pph_ter_monthly_table(rules, curve->ter_category);
+
+        seg->ter_rate = pph_ter_rate(table, pph_ter_bracket(table, bruto));
+    } else {
+        seg->ter_rate = PPH_ZERO;
+    }
+}
+
+pph_status_t pph21_curve_compile(const pph21_profile_t *profile, pph21_curve_t *curve) {
+    pph_int64_t points[PPH21_CURVE_MAX_SEGMENTS];
+    const pph_rules_t *rules;
+    int count = 0, full = 0, i;
+
+    if (profile == NULL || curve == NULL) {
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    /* The curve keeps the rules it was compiled with */
+    rules = pph_rules_enter();
+
+    curve->months = (profile->months_paid < 1) ? 1 : (profile->months_paid > 12) ? 12 : profile->months_paid;
+    curve->ter_months = (curve->months < 11) ? curve->months : 11;
+    curve->scheme = profile->scheme;
+    curve->ter_category = profile->ter_category;
+    curve->fixed_deductions = profile->pension_contribution.value * curve->months
+                            + profile->zakat_or_donation.value
+                            + pph_get_ptkp(profile->ptkp_status).value;
+
+    /* Biaya jabatan reaches its cap */
+    full |= add_breakpoint(points, &count, bisect_biaya_cap(curve, 0, PPH21_CURVE_BRUTO_MAX));
+
+    /* PKP crosses into each Pasal 17 bracket */
+    for (i = 1; i < rules->bracket_count; i++) {
+        full |= add_breakpoint(points, &count, bisect_pkp(curve, rules->brackets[i].start.value,
+                                                          0, PPH21_CURVE_BRUTO_MAX));
+    }
+
+    /* Monthly income moves to the next TER bracket */
+    if (curve->scheme == PPH21_SCHEME_TER) {
+        const pph_ter_table_t *table = pph_ter_monthly_table(rules, curve->ter_category);
+
+        for (i = 0; i < table->count - 1; i++) {
+            full |= add_breakpoint(points, &count,
+                                   (pph_int64_t)table->ceilings[i] * PPH_TER_UNIT + 1);
+        }
+    }
+
+    if (full) {
+        pph_rules_exit();
+        pph_set_last_error("Tax rules need more than PPH21_CURVE_MAX_SEGMENTS segments");
+        return PPH_ERR_INVALID_INPUT;
+    }
+
+    curve->segment_count = count + 1;
+    init_segment(rules, curve, &curve->segments[0], 0);
+    for (i = 0; i < count; i++) {
+        init_segment(rules, curve, &curve->segments[i + 1], points[i]);
+    }
+
+    pph_rules_exit();
+    return PPH_OK;
+}
+
+/* ============================================
+   Evaluation
+   ============================================ */
+
+static const pph21_curve_segment_t* find_segment(const pph21_curve_t *curve, pph_int64_t bruto) {
+    int lo = 0, hi = curve->segment_count - 1;
+
+    /* Last segment whose start is <= bruto */
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+
+        if (curve->segments[mid].bruto_start <= bruto) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return &curve->segments[lo];
+}
+
+static pph_int64_t segment_tax(const pph21_curve_t *curve, const pph21_curve_segment_t *seg,
+                               pph_int64_t bruto) {
+    pph_int64_t biaya, pkp;
+
+    biaya = seg->biaya_capped ? BIAYA_JABATAN_MAX : (bruto * curve->months * 5) / 100;
+    pkp = curve_pkp(curve, bruto, biaya);
+
+    /* Split so the product cannot overflow in the unbounded top bracket */
+    return seg->layer_base_tax + pph_apply_rate(pkp - seg->layer_start, seg->layer_rate.value);
+}
+
+static int curve_in_range(pph_money_t bruto) {
+    return bruto.value >= 0 && bruto.value <= PPH21_CURVE_BRUTO_MAX;
+}
+
+pph_money_t pph21_curve_total_tax(const pph21_curve_t *curve, pph_money_t bruto) {
+    pph_money_t tax;
+
+    if (curve == NULL || !curve_in_range(bruto)) {
+        return PPH_ZERO;
+    }
+
+    tax.value = segment_tax(curve, find_segment(curve, bruto.value), bruto.value);
+    return tax;
+}
+
+pph_status_t pph21_curve_evaluate(const pph21_curve_t *curve, pph_money_t bruto,
+                                  pph21_summary_t *summary) {
+    const pph21_curve_segment_t *seg;
+    pph_money_t month_ter;
+    int i;
+
+    if (curve == NULL || summary == NULL) {
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+    if (!curve_in_range(bruto)) {
+        pph_set_last_error("Bruto outside the range of the curve");
+        summary->status = PPH_ERR_INVALID_INPUT;
+        return PPH_ERR_INVALID_INPUT;
+    }
+
+    seg = find_segment(curve, bruto.value);
+    summary->total_tax.value = segment_tax(curve, seg, bruto.value);
+
+    month_ter = pph_money_mul(bruto, seg->ter_rate);
+    for (i = 0; i < 12; i++) {
+        summary->monthly_ter[i] = (i < curve->ter_months) ? month_ter : PPH_ZERO;
+    }
+
+    if (curve->scheme == PPH21_SCHEME_TER) {
+        summary->ter_paid = pph_money_mul_int(month_ter, curve->ter_months);
+        summary->adjustment = pph_money_sub(summary->total_tax, summary->ter_paid);
+    } else {
+        summary->ter_paid = PPH_ZERO;
+        summary->adjustment = PPH_ZERO;
+    }
+
+    summary->status = PPH_OK;
+    return PPH_OK;
+}
+
+pph_status_t pph21_curve_sweep(const pph21_curve_t *curve, pph_money_t bruto_from,
+                               pph_money_t step, pph_size_t count, pph_money_t *total_tax) {
+    const pph21_curve_segment_t *seg, *last;
+    pph_int64_t bruto;
+    pph_size_t i;
+
+    if (curve == NULL || (total_tax == NULL && count > 0)) {
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+    if (count == 0) {
+        return PPH_OK;
+    }
+    if (step.value < 0 || !curve_in_range(bruto_from) ||
+        (pph_uint64_t)(count - 1) > (pph_uint64_t)((PPH21_CURVE_BRUTO_MAX - bruto_from.value) /
+                                                   (step.value > 0 ? step.value : 1))) {
+        pph_set_last_error("Sweep leaves the range of the curve");
+        return PPH_ERR_INVALID_INPUT;
+    }
+
+    /* Points ascend, so the segment only ever moves forward */
+    seg = find_segment(curve, bruto_from.value);
+    last = &curve->segments[curve->segment_count - 1];
+    bruto = bruto_from.value;
+
+    for (i = 0; i < count; i++) {
+        while (seg < last && seg[1].bruto_start <= bruto) {
+            seg++;
+        }
+        total_tax[i].value = segment_tax(curve, seg, bruto);
+        bruto += step.value;
+    }
+
+    return PPH_OK;
+}
+
+/* ============================================
+   Gross-Up (Net to Bruto)
+
+   Net is the annual bruto less the annual PPh 21. Within one
+   thousand-rupiah step of the rounded PKP the tax is constant, so net
+   rises one-for-one with bruto; from one step to the next bruto rises by
+   at least Rp 1.000 while the tax rises by at most 35% of that. The net
+   at the end of each step is therefore increasing, and the smallest
+   bruto reaching a target lies in the first step whose end reaches it.
+   The linear form of the segment gives that step to within a few steps;
+   the rest is walked exactly.
+   ============================================ */
+
+/* x * k / d for x >= 0 without overflowing the intermediate product */
+static pph_int64_t mul_div(pph_int64_t x, pph_int64_t k, pph_int64_t d) {
+    return (x / d) * k + ((x % d) * k) / d;
+}
+
+static pph_int64_t ceil_div(pph_int64_t x, pph_int64_t d) {
+    return (x <= 0) ? 0 : (x + d - 1) / d;
+}
+
+/* Smallest bruto whose rounded PKP is at least pkp (a whole thousand) */
+static pph_int64_t step_start(const pph21_curve_t *curve, pph_int64_t pkp) {
+    pph_int64_t target, q, annual, bruto, capped_from;
+
+    if (pkp <= 0) {
+        return 0;
+    }
+
+    /* Need bruto * months - biaya >= target */
+    target = pkp + curve->fixed_deductions;
+    capped_from = ceil_div(20 * BIAYA_JABATAN_MAX, curve->months);
+
+    /* Below the cap biaya is floor(annual / 20), so the left side is
+       19 * (annual / 20) + annual % 20 */
+    q = target / 19;
+    annual = (target % 19 == 0 && q > 0) ? 20 * q - 1 : 20 * q + target % 19;
+    bruto = ceil_div(annual, curve->months);
+    if (bruto < capped_from) {
+        return bruto;
+    }
+
+    bruto = ceil_div(target + BIAYA_JABATAN_MAX, curve->months);
+    return (bruto > capped_from) ? bruto : capped_from;
+}
+
+/* Smallest bruto in the step of pkp whose net reaches target, or -1 */
+static pph_int64_t step_solution(const pph21_curve_t *curve, pph_int64_t pkp,
+                                 pph_int64_t target) {
+    const pph21_curve_segment_t *seg;
+    pph_int64_t first, next, tax, bruto;
+
+    first = step_start(curve, pkp);
+    next = step_start(curve, pkp + THOUSAND_RUPIAH);
+
+    /* Tax of the step from the curve's own layers, not the published rules */
+    seg = find_segment(curve, first);
+    tax = seg->layer_base_tax + pph_apply_rate(pkp - seg->layer_start, seg->layer_rate.value);
+
+    bruto = ceil_div(target + tax, curve->months);
+    if (bruto < first) {
+        bruto = first;
+    }
+    return (bruto < next) ? bruto : -1;
+}
+
+/* Linear estimate of the bruto reaching target within a segment */
+static pph_int64_t segment_estimate(const pph21_curve_t *curve, const pph21_curve_segment_t *seg,
+                                    pph_int64_t target) {
+    pph_int64_t rate = seg->layer_rate.value;
+    pph_int64_t rest;
+
+    if (seg->biaya_capped) {
+        /* net = months * bruto * (1 - rate) - base + (cap + F + start) * rate */
+        rest = target + seg->layer_base_tax
+             - mul_div(BIAYA_JABATAN_MAX + curve->fixed_deductions + seg->layer_start,
+                       rate, PPH_SCALE_FACTOR);
+        return (rest <= 0) ? 0 : mul_div(rest, PPH_SCALE_FACTOR,
+                                         curve->months * (PPH_SCALE_FACTOR - rate));
+    }
+
+    /* net = months * bruto * (1 - 0.95 * rate) - base + (F + start) * rate */
+    rest = target + seg->layer_base_tax
+         - mul_div(curve->fixed_deductions + seg->layer_start, rate, PPH_SCALE_FACTOR);
+    return (rest <= 0) ? 0 : mul_div(rest, PPH_INT64_C(1000000),
+                                     curve->months * (PPH_INT64_C(1000000) - 95 * rate));
+}
+
+static pph_int64_t curve_net(const pph21_curve_t *curve, const pph21_curve_segment_t *seg,
+                             pph_int64_t bruto) {
+    return bruto * curve->months - segment_tax(curve, seg, bruto);
+}
+
+pph_status_t pph21_curve_gross_up(const pph21_curve_t *curve, pph_money_t net_monthly,
+                                  pph_money_t *bruto_monthly) {
+    const pph21_curve_segment_t *seg;
+    pph_int64_t target, estimate, end, pkp, bruto;
+    int lo, hi;
+
+    if (curve == NULL || bruto_monthly == NULL) {
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    bruto_monthly->value = 0;
+    if (net_monthly.value <= 0) {
+        return PPH_OK;
+    }
+
+    /* Bounded first, so the yearly target cannot overflow */
+    if (net_monthly.value > PPH21_CURVE_BRUTO_MAX) {
+        pph_set_last_error("Net outside the range of the curve");
+        return PPH_ERR_INVALID_INPUT;
+    }
+
+    target = net_monthly.value * curve->months;
+    seg = &curve->segments[curve->segment_count - 1];
+    if (target > curve_net(curve, seg, PPH21_CURVE_BRUTO_MAX)) {
+        pph_set_last_error("Net outside the range of the curve");
+        return PPH_ERR_INVALID_INPUT;
+    }
+
+    /* Last segment starting below the target; only a starting point for
+       the walk, which settles the exact step */
+    lo = 0;
+    hi = curve->segment_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+
+        if (curve_net(curve, &curve->segments[mid], curve->segments[mid].bruto_start) < target) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    seg = &curve->segments[lo];
+    end = (lo + 1 < curve->segment_count) ? seg[1].bruto_start - 1 : PPH21_CURVE_BRUTO_MAX;
+
+    /* Tax is never negative, so bruto is at least the net */
+    estimate = segment_estimate(curve, seg, target);
+    if (estimate < net_monthly.value) {
+        estimate = net_monthly.value;
+    }
+    if (estimate < seg->bruto_start) {
+        estimate = seg->bruto_start;
+    }
+    if (estimate > end) {
+        estimate = end;
+    }
+
+    /* Walk to the first PKP step that reaches the target */
+    pkp = curve_pkp(curve, estimate, curve_biaya_jabatan(curve, estimate));
+    while ((bruto = step_solution(curve, pkp, target)) < 0) {
+        pkp += THOUSAND_RUPIAH;
+    }
+    while (pkp > 0) {
+        pph_int64_t earlier = step_solution(curve, pkp - THOUSAND_RUPIAH, target);
+
+        if (earlier < 0) {
+            break;
+        }
+        bruto = earlier;
+        pkp -= THOUSAND_RUPIAH;
+    }
+
+    bruto_monthly->value = bruto;
+    return PPH_OK;
+}
+
+pph_status_t pph21_gross_up(const pph21_profile_t *profile, pph_money_t net_monthly,
+                            pph_money_t *bruto_monthly) {
+    pph21_curve_t curve;
+    pph_status_t status;
+
+    if (bruto_monthly == NULL) {
+        pph_set_last_error("Output is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+    bruto_monthly->value = 0;
+
+    status = pph21_curve_compile(profile, &curve);
+    if (status != PPH_OK) {
+        return status;
+    }
+    return pph21_curve_gross_up(&curve, net_monthly, bruto_monthly);
+}
+
+static int same_profile(const pph21_profile_t *a, const pph21_profile_t *b) {
+    return a->ptkp_status == b->ptkp_status &&
+           a->scheme == b->scheme &&
+           a->ter_category == b->ter_category &&
+           a->months_paid == b->months_paid &&
+           a->pension_contribution.value == b->pension_contribution.value &&
+           a->zakat_or_donation.value == b->zakat_or_donation.value;
+}
+
+pph_status_t pph21_gross_up_batch(const pph21_profile_t *profiles,
+                                  const pph_money_t *net_monthly,
+                                  pph_size_t count,
+                                  pph_money_t *bruto_monthly) {
+    pph21_curve_t curve;
+    const pph21_profile_t *compiled = NULL;
+    pph_status_t status, compile_status = PPH_OK, first_error = PPH_OK;
+    pph_size_t i;
+
+    if (count == 0) {
+        return PPH_OK;
+    }
+
+    if (profiles == NULL || net_monthly == NULL || bruto_monthly == NULL) {
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    for (i = 0; i < count; i++) {
+        /* Runs of the same profile share one curve, or one compile error */
+        if (compiled == NULL || !same_profile(compiled, &profiles[i])) {
+            compiled = &profiles[i];
+            compile_status = pph21_curve_compile(compiled, &curve);
+        }
+
+        if (compile_status != PPH_OK) {
+            bruto_monthly[i].value = 0;
+            status = compile_status;
+        } else {
+            status = pph21_curve_gross_up(&curve, net_monthly[i], &bruto_monthly[i]);
+        }
+        if (status != PPH_OK && first_error == PPH_OK) {
+            first_error = status;
+        }
+    }
+
+    return first_error;
+}
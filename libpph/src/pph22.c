@@ -23,10 +23,10 @@ pph_result_t* pph22_calculate(const pph22_input_t *input) {
 
     tax = pph_money_mul(input->dpp, input->rate);
 
-    pph_result_add_section(result, "PPh 22");
-    pph_result_add_currency(result, "DPP", input->dpp, NULL);
-    pph_result_add_percent(result, "Tarif", input->rate, NULL);
-    pph_result_add_total(result, "PPh 22", tax);
+    pph_result_add_section(result, PPH_LABEL_PPH22);
+    pph_result_add_currency(result, PPH_LABEL_DPP, input->dpp, PPH_LABEL_NONE);
+    pph_result_add_percent(result, PPH_LABEL_TARIF, input->rate, PPH_LABEL_NONE);
+    pph_result_add_total(result, PPH_LABEL_PPH22, tax);
 
     result->total_tax = tax;
     return result;
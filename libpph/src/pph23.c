@@ -23,10 +23,10 @@ pph_result_t* pph23_calculate(const pph23_input_t *input) {
 
     tax = pph_money_mul(input->bruto, input->rate);
 
-    pph_result_add_section(result, "PPh 23");
-    pph_result_add_currency(result, "Penghasilan bruto", input->bruto, NULL);
-    pph_result_add_percent(result, "Tarif", input->rate, NULL);
-    pph_result_add_total(result, "PPh 23", tax);
+    pph_result_add_section(result, PPH_LABEL_PPH23);
+    pph_result_add_currency(result, PPH_LABEL_PENGHASILAN_BRUTO, input->bruto, PPH_LABEL_NONE);
+    pph_result_add_percent(result, PPH_LABEL_TARIF, input->rate, PPH_LABEL_NONE);
+    pph_result_add_total(result, PPH_LABEL_PPH23, tax);
 
     result->total_tax = tax;
     return result;
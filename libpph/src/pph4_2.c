@@ -23,10 +23,10 @@ pph_result_t* pph4_2_calculate(const pph4_2_input_t *input) {
 
     tax = pph_money_mul(input->bruto, input->rate);
 
-    pph_result_add_section(result, "PPh Final Pasal 4(2)");
-    pph_result_add_currency(result, "Penghasilan bruto", input->bruto, NULL);
-    pph_result_add_percent(result, "Tarif", input->rate, NULL);
-    pph_result_add_total(result, "PPh Final Pasal 4(2)", tax);
+    pph_result_add_section(result, PPH_LABEL_PPH4_2);
+    pph_result_add_currency(result, PPH_LABEL_PENGHASILAN_BRUTO, input->bruto, PPH_LABEL_NONE);
+    pph_result_add_percent(result, PPH_LABEL_TARIF, input->rate, PPH_LABEL_NONE);
+    pph_result_add_total(result, PPH_LABEL_PPH4_2, tax);
 
     result->total_tax = tax;
     return result;
@@ -5,6 +5,7 @@
 
 #include <pph/pph_calculator.h>
 #include "pph_internal.h"
+#include "pph_thread.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -12,6 +13,9 @@
 /* Initial capacity for breakdown array */
 #define INITIAL_BREAKDOWN_CAPACITY 64
 
+/* Initial size of the string pool, allocated on first dynamic text */
+#define INITIAL_STRINGS_CAPACITY 256
+
 /* ============================================
    Custom Allocator Support
    ============================================ */
@@ -89,6 +93,9 @@ pph_result_t* pph_result_create(void) {
     result->total_tax = PPH_ZERO;
     result->breakdown_count = 0;
     result->breakdown_capacity = INITIAL_BREAKDOWN_CAPACITY;
+    result->strings = NULL;
+    result->strings_size = 0;
+    result->strings_capacity = 0;
 
     result->breakdown = (pph_breakdown_row_t*)pph_malloc(
         sizeof(pph_breakdown_row_t) * result->breakdown_capacity);
@@ -110,9 +117,114 @@ void pph_result_free(pph_result_t *result) {
         pph_free(result->breakdown);
     }
 
+    pph_free(result->strings);
     pph_free(result);
 }
 
+/* ============================================
+   Labels
+   ============================================ */
+
+/* Indexed by pph_label_id_t */
+static const char * const label_texts[] = {
+    "",
+
+    "Pemotongan TER (Bulan 1-11)",
+    "Perhitungan Tahunan (Pasal 17)",
+    "Penyesuaian Bulan 12",
+    "Penghasilan Bruto",
+    "Pengurang",
+    "PKP dan Pajak",
+    "Pensiunan",
+    "Pegawai Tidak Tetap",
+    "Bukan Pegawai",
+    "Peserta Kegiatan",
+    "Program Pensiun",
+    "Mantan Pegawai",
+    "WPLN (PPh 26)",
+
+    "Bulan bonus",
+    "Bulan reguler",
+    "  Tarif TER",
+    "  PPh 21 TER",
+    "  PPh 21 TER per bulan",
+    "  Total PPh 21 TER",
+    "Total TER bulan 1-11",
+
+    "Gaji per bulan",
+    "Gaji setahun",
+    "Bonus",
+    "Total bruto",
+    "Bruto setahun",
+    "Biaya jabatan (5%, maks 6 jt)",
+    "Iuran pensiun",
+    "Zakat/sumbangan",
+    "Netto setahun",
+    "PTKP",
+    "PKP (dibulatkan ribuan)",
+    "PPh 21 setahun (progresif)",
+    "PPh 21 setahun",
+    "TER telah dipotong (bln 1-11)",
+    "Kurang/(lebih) bayar bulan 12",
+
+    "Penghasilan bruto",
+    "DPP",
+    "Tarif",
+    "PPh 21",
+    "PPh 22",
+    "PPh 23",
+    "PPh Final Pasal 4(2)",
+    "PPN",
+    "Tarif PPN",
+    "PPnBM",
+    "Tarif PPnBM",
+    "PPN dan PPnBM",
+    "Total PPN + PPnBM",
+
+    "per bulan",
+    "bulan",
+    "5%"
+};
+
+/* Fails to compile when the table and the enum drift apart */
+typedef char label_table_matches_enum[
+    (sizeof(label_texts) / sizeof(label_texts[0]) == PPH_LABEL_COUNT) ? 1 : -1];
+
+const char* pph_label_text(pph_label_id_t label) {
+    if ((int)label < 0 || label >= PPH_LABEL_COUNT) {
+        return "";
+    }
+    return label_texts[label];
+}
+
+static const char* row_text(const pph_result_t *result, pph_label_id_t label,
+                            pph_uint32_t text) {
+    if (text != 0) {
+        return result->strings + (text - 1);
+    }
+    return pph_label_text(label);
+}
+
+const char* pph_result_row_label(const pph_result_t *result, pph_size_t index) {
+    const pph_breakdown_row_t *row;
+
+    if (result == NULL || index >= result->breakdown_count) {
+        return "";
+    }
+    row = &result->breakdown[index];
+    return row_text(result, row->label, row->label_text);
+}
+
+const char* pph_result_row_note(const pph_result_t *result, pph_size_t index) {
+    const pph_breakdown_row_t *row;
+
+    if (result == NULL || index >= result->breakdown_count) {
+        return "";
+    }
+    row = &result->breakdown[index];
+    return row_text(result, row->note, row->note_text);
+}
+
 /* ============================================
    Breakdown Row Management
    ============================================ */
@@ -141,11 +253,43 @@ static int pph_result_ensure_capacity(pph_result_t *result) {
     return 1;  /* Success */
 }
 
+/* Copy text into the string pool; returns its reference (offset + 1) or
+   0 when the pool cannot grow */
+static pph_uint32_t pph_result_intern(pph_result_t *result, const char *text) {
+    pph_size_t len = (pph_size_t)strlen(text) + 1;
+    pph_size_t offset;
+
+    if (result->strings_size + len > result->strings_capacity) {
+        pph_size_t new_capacity = result->strings_capacity ? result->strings_capacity * 2 : INITIAL_STRINGS_CAPACITY;
+        char *new_strings;
+
+        while (new_capacity < result->strings_size + len) {
+            new_capacity *= 2;
+        }
+        if (new_capacity > 0xFFFFFFFFUL) {
+            return 0;
+        }
+
+        new_strings = (char*)pph_realloc(result->strings, new_capacity);
+        if (new_strings == NULL) {
+            return 0;
+        }
+        result->strings = new_strings;
+        result->strings_capacity = new_capacity;
+    }
+
+    offset = result->strings_size;
+    memcpy(result->strings + offset, text, (size_t)len);
+    result->strings_size += len;
+
+    return (pph_uint32_t)(offset + 1);
+}
+
 int pph_result_add_row(pph_result_t *result,
-                       const char *label,
+                       pph_label_id_t label,
                        pph_money_t value,
                        pph_value_type_t value_type,
-                       const char *note,
+                       pph_label_id_t note,
                        pph_breakdown_variant_t variant) {
     pph_breakdown_row_t *row;
 
@@ -158,20 +302,12 @@ int pph_result_add_row(pph_result_t *result,
     }
 
     row = &result->breakdown[result->breakdown_count];
-
-    /* Copy label */
-    strncpy(row->label, label ? label : "", sizeof(row->label) - 1);
-    row->label[sizeof(row->label) - 1] = '\0';
-
-    /* Set value */
     row->value = value;
+    row->label = label;
+    row->note = note;
+    row->label_text = 0;
+    row->note_text = 0;
     row->value_type = value_type;
-
-    /* Copy note */
-    strncpy(row->note, note ? note : "", sizeof(row->note) - 1);
-    row->note[sizeof(row->note) - 1] = '\0';
-
-    /* Set variant */
     row->variant = variant;
 
     result->breakdown_count++;
@@ -179,38 +315,65 @@ int pph_result_add_row(pph_result_t *result,
     return 1;  /* Success */
 }
 
-int pph_result_add_section(pph_result_t *result, const char *label) {
-    return pph_result_add_row(result, label, PPH_ZERO, PPH_VALUE_TEXT, NULL, PPH_BREAKDOWN_SECTION);
+int pph_result_set_text(pph_result_t *result, const char *label, const char *note) {
+    pph_breakdown_row_t *row;
+    pph_uint32_t label_text = 0, note_text = 0;
+
+    if (result == NULL || result->breakdown_count == 0) {
+        return 0;
+    }
+
+    if (label != NULL && (label_text = pph_result_intern(result, label)) == 0) {
+        return 0;
+    }
+    if (note != NULL && (note_text = pph_result_intern(result, note)) == 0) {
+        return 0;
+    }
+
+    row = &result->breakdown[result->breakdown_count - 1];
+    if (label != NULL) {
+        row->label_text = label_text;
+    }
+    if (note != NULL) {
+        row->note_text = note_text;
+    }
+
+    return 1;  /* Success */
+}
+
+int pph_result_add_section(pph_result_t *result, pph_label_id_t label) {
+    return pph_result_add_row(result, label, PPH_ZERO, PPH_VALUE_TEXT, PPH_LABEL_NONE, PPH_BREAKDOWN_SECTION);
 }
 
-int pph_result_add_currency(pph_result_t *result, const char *label, pph_money_t value, const char *note) {
+int pph_result_add_currency(pph_result_t *result, pph_label_id_t label, pph_money_t value, pph_label_id_t note) {
     return pph_result_add_row(result, label, value, PPH_VALUE_CURRENCY, note, PPH_BREAKDOWN_NORMAL);
 }
 
-int pph_result_add_percent(pph_result_t *result, const char *label, pph_money_t percent, const char *note) {
+int pph_result_add_percent(pph_result_t *result, pph_label_id_t label, pph_money_t percent, pph_label_id_t note) {
     return pph_result_add_row(result, label, percent, PPH_VALUE_PERCENT, note, PPH_BREAKDOWN_NORMAL);
 }
 
-int pph_result_add_subtotal(pph_result_t *result, const char *label, pph_money_t value) {
-    return pph_result_add_row(result, label, value, PPH_VALUE_CURRENCY, NULL, PPH_BREAKDOWN_SUBTOTAL);
+int pph_result_add_subtotal(pph_result_t *result, pph_label_id_t label, pph_money_t value) {
+    return pph_result_add_row(result, label, value, PPH_VALUE_CURRENCY, PPH_LABEL_NONE, PPH_BREAKDOWN_SUBTOTAL);
 }
 
-int pph_result_add_total(pph_result_t *result, const char *label, pph_money_t value) {
-    return pph_result_add_row(result, label, value, PPH_VALUE_CURRENCY, NULL, PPH_BREAKDOWN_TOTAL);
+int pph_result_add_total(pph_result_t *result, pph_label_id_t label, pph_money_t value) {
+    return pph_result_add_row(result, label, value, PPH_VALUE_CURRENCY, PPH_LABEL_NONE, PPH_BREAKDOWN_TOTAL);
 }
 
 int pph_result_add_spacer(pph_result_t *result) {
-    return pph_result_add_row(result, "", PPH_ZERO, PPH_VALUE_TEXT, NULL, PPH_BREAKDOWN_SPACER);
+    return pph_result_add_row(result, PPH_LABEL_NONE, PPH_ZERO, PPH_VALUE_TEXT, PPH_LABEL_NONE, PPH_BREAKDOWN_SPACER);
 }
 
 /* ============================================
    Library Initialization
    ============================================ */
 
-static const char *last_error = NULL;
+/* Per thread, so parallel batches don't race on error reporting */
+static PPH_THREAD_LOCAL const char *last_error = NULL;
 
 void pph_init(void) {
-    /* Currently no initialization needed */
+    pph_init_ter_index();
     last_error = NULL;
 }
 
@@ -4,247 +4,185 @@
  */
 
 #include <pph/pph_calculator.h>
+#include "pph_internal.h"
+#include "pph_thread.h"
 
 /* ============================================
    PTKP Table (Penghasilan Tidak Kena Pajak)
    ============================================ */
 
-static const pph_money_t PPH_PTKP_TABLE[8] = {
-    PPH_RUPIAH_STATIC(54000000),  /* TK/0: 54,000,000 */
-    PPH_RUPIAH_STATIC(58500000),  /* TK/1: 58,500,000 */
-    PPH_RUPIAH_STATIC(63000000),  /* TK/2: 63,000,000 */
-    PPH_RUPIAH_STATIC(67500000),  /* TK/3: 67,500,000 */
-    PPH_RUPIAH_STATIC(58500000),  /* K/0: 58,500,000 */
-    PPH_RUPIAH_STATIC(63000000),  /* K/1: 63,000,000 */
-    PPH_RUPIAH_STATIC(67500000),  /* K/2: 67,500,000 */
-    PPH_RUPIAH_STATIC(72000000)   /* K/3: 72,000,000 */
+/* Thousands of rupiah */
+static const pph_uint32_t PPH_PTKP_TABLE[8] = {
+    54000,  /* TK/0: 54,000,000 */
+    58500,  /* TK/1: 58,500,000 */
+    63000,  /* TK/2: 63,000,000 */
+    67500,  /* TK/3: 67,500,000 */
+    58500,  /* K/0: 58,500,000 */
+    63000,  /* K/1: 63,000,000 */
+    67500,  /* K/2: 67,500,000 */
+    72000   /* K/3: 72,000,000 */
 };
 
 pph_money_t pph_get_ptkp(pph_ptkp_status_t status) {
+    const pph_rules_t *rules = pph_rules_enter();
+    pph_money_t ptkp;
+
     if (status < 0 || status > 7) {
-        return PPH_PTKP_TABLE[0];  /* Default to TK/0 */
+        status = PPH_PTKP_TK0;  /* Default to TK/0 */
     }
-    return PPH_PTKP_TABLE[status];
+    ptkp.value = (pph_int64_t)rules->ptkp[status] * PPH_INT64_C(10000000);
+
+    pph_rules_exit();
+    return ptkp;
 }
 
 /* ============================================
    Pasal 17 Progressive Tax Layers
    ============================================ */
 
-typedef struct {
-    pph_money_t limit;
-    pph_money_t rate;  /* Stored as fraction (0.05 = 500/10000) */
-} pasal17_layer_t;
-
-#define PASAL17_LAYER_COUNT 5
-
-static const pasal17_layer_t PPH_PASAL17_LAYERS[PASAL17_LAYER_COUNT] = {
-    { PPH_RUPIAH_STATIC(60000000),    PPH_MONEY_STATIC(0, 500) },   /* 5% = 0.0500 */
-    { PPH_RUPIAH_STATIC(190000000),   PPH_MONEY_STATIC(0, 1500) },  /* 15% = 0.1500 */
-    { PPH_RUPIAH_STATIC(250000000),   PPH_MONEY_STATIC(0, 2500) },  /* 25% = 0.2500 */
-    { PPH_RUPIAH_STATIC(4500000000),  PPH_MONEY_STATIC(0, 3000) },  /* 30% = 0.3000 */
-    { PPH_RUPIAH_STATIC(2147483647),  PPH_MONEY_STATIC(0, 3500) }   /* 35% = 0.3500, use max int as infinity */
+#define PASAL17_BRACKET_COUNT 5
+
+/* Each bracket carries the tax already due on all layers below it, so the
+   tax is one bracket search, one multiply and one add. The top bracket
+   is unbounded. */
+static const pph_pasal17_bracket_t PPH_PASAL17_BRACKETS[PASAL17_BRACKET_COUNT] = {
+    { PPH_RUPIAH_STATIC(0),          PPH_RUPIAH_STATIC(0),          PPH_MONEY_STATIC(0, 500) },   /* 5% */
+    { PPH_RUPIAH_STATIC(60000000),   PPH_RUPIAH_STATIC(3000000),    PPH_MONEY_STATIC(0, 1500) },  /* 15% */
+    { PPH_RUPIAH_STATIC(250000000),  PPH_RUPIAH_STATIC(31500000),   PPH_MONEY_STATIC(0, 2500) },  /* 25% */
+    { PPH_RUPIAH_STATIC(500000000),  PPH_RUPIAH_STATIC(94000000),   PPH_MONEY_STATIC(0, 3000) },  /* 30% */
+    { PPH_RUPIAH_STATIC(5000000000), PPH_RUPIAH_STATIC(1444000000), PPH_MONEY_STATIC(0, 3500) }   /* 35% */
 };
 
 pph_money_t pph_calculate_pasal17(pph_money_t pkp) {
-    pph_money_t tax = PPH_ZERO;
-    pph_money_t remaining = pkp;
+    const pph_rules_t *rules;
+    const pph_pasal17_bracket_t *bracket;
+    pph_money_t tax;
     int i;
 
-    for (i = 0; i < PASAL17_LAYER_COUNT; i++) {
-        pph_money_t taxable, layer_tax;
+    if (pkp.value <= 0) {
+        return PPH_ZERO;
+    }
 
-        if (remaining.value <= 0) {
-            break;
-        }
+    rules = pph_rules_enter();
+    for (i = rules->bracket_count - 1; pkp.value < rules->brackets[i].start.value; i--) {
+    }
+    bracket = &rules->brackets[i];
+
+    tax.value = bracket->base_tax.value +
+                pph_apply_rate(pkp.value - bracket->start.value, bracket->rate.value);
 
-        taxable = pph_money_min(remaining, PPH_PASAL17_LAYERS[i].limit);
-        layer_tax = pph_money_mul(taxable, PPH_PASAL17_LAYERS[i].rate);
+    pph_rules_exit();
+    return tax;
+}
 
-        tax = pph_money_add(tax, layer_tax);
-        remaining = pph_money_sub(remaining, taxable);
+void pph_calculate_pasal17_block(const pph_int64_t *pkp, int count, pph_int64_t *tax) {
+    const pph_rules_t *rules = pph_rules_enter();
+    const pph_pasal17_bracket_t *b = rules->brackets;
+    int j, k;
+
+    for (j = 0; j < count; j++) {
+        pph_int64_t value = (pkp[j] > 0) ? pkp[j] : 0;
+        int i = 0;
+
+        /* Counting instead of searching keeps the loop free of
+           data-dependent branches */
+        for (k = 1; k < rules->bracket_count; k++) {
+            i += (value >= b[k].start.value);
+        }
+
+        tax[j] = b[i].base_tax.value +
+                 pph_apply_rate(value - b[i].start.value, b[i].rate.value);
     }
 
-    return tax;
+    pph_rules_exit();
 }
 
 /* ============================================
    TER Bulanan (Monthly) Tables
+
+   Stored as parallel ceiling/rate columns so the ceilings of a category
+   are contiguous and can be compared several at a time. Ceilings are in
+   thousands of rupiah and rates in basis points (the money scale of a
+   rate), so all three categories take under 800 bytes. Each ceiling
+   column is padded to a multiple of PPH_TER_PAD with PPH_TER_CEILING_PAD,
+   which no income key exceeds; the top bracket uses the same value.
    ============================================ */
 
-typedef struct {
-    pph_money_t ceiling;
-    pph_money_t rate;
-} ter_entry_t;
+#define TER_TOP_CEILING PPH_TER_CEILING_PAD
+#define TER_PAD_CEILING PPH_TER_CEILING_PAD
 
 #define TER_BULANAN_A_COUNT 44
 #define TER_BULANAN_B_COUNT 40
 #define TER_BULANAN_C_COUNT 41
 
-static const ter_entry_t TER_BULANAN_A[TER_BULANAN_A_COUNT] = {
-    { PPH_RUPIAH_STATIC(5400000), PPH_MONEY_STATIC(0, 0) },
-    { PPH_RUPIAH_STATIC(5650000), PPH_MONEY_STATIC(0, 25) },
-    { PPH_RUPIAH_STATIC(5950000), PPH_MONEY_STATIC(0, 50) },
-    { PPH_RUPIAH_STATIC(6300000), PPH_MONEY_STATIC(0, 75) },
-    { PPH_RUPIAH_STATIC(6750000), PPH_MONEY_STATIC(0, 100) },
-    { PPH_RUPIAH_STATIC(7500000), PPH_MONEY_STATIC(0, 125) },
-    { PPH_RUPIAH_STATIC(8550000), PPH_MONEY_STATIC(0, 150) },
-    { PPH_RUPIAH_STATIC(9650000), PPH_MONEY_STATIC(0, 175) },
-    { PPH_RUPIAH_STATIC(10050000), PPH_MONEY_STATIC(0, 200) },
-    { PPH_RUPIAH_STATIC(10350000), PPH_MONEY_STATIC(0, 225) },
-    { PPH_RUPIAH_STATIC(10700000), PPH_MONEY_STATIC(0, 250) },
-    { PPH_RUPIAH_STATIC(11050000), PPH_MONEY_STATIC(0, 300) },
-    { PPH_RUPIAH_STATIC(11600000), PPH_MONEY_STATIC(0, 350) },
-    { PPH_RUPIAH_STATIC(12500000), PPH_MONEY_STATIC(0, 400) },
-    { PPH_RUPIAH_STATIC(13750000), PPH_MONEY_STATIC(0, 500) },
-    { PPH_RUPIAH_STATIC(15100000), PPH_MONEY_STATIC(0, 600) },
-    { PPH_RUPIAH_STATIC(16950000), PPH_MONEY_STATIC(0, 700) },
-    { PPH_RUPIAH_STATIC(19750000), PPH_MONEY_STATIC(0, 800) },
-    { PPH_RUPIAH_STATIC(24150000), PPH_MONEY_STATIC(0, 900) },
-    { PPH_RUPIAH_STATIC(26450000), PPH_MONEY_STATIC(0, 1000) },
-    { PPH_RUPIAH_STATIC(28000000), PPH_MONEY_STATIC(0, 1100) },
-    { PPH_RUPIAH_STATIC(30050000), PPH_MONEY_STATIC(0, 1200) },
-    { PPH_RUPIAH_STATIC(32400000), PPH_MONEY_STATIC(0, 1300) },
-    { PPH_RUPIAH_STATIC(35400000), PPH_MONEY_STATIC(0, 1400) },
-    { PPH_RUPIAH_STATIC(39100000), PPH_MONEY_STATIC(0, 1500) },
-    { PPH_RUPIAH_STATIC(43850000), PPH_MONEY_STATIC(0, 1600) },
-    { PPH_RUPIAH_STATIC(47800000), PPH_MONEY_STATIC(0, 1700) },
-    { PPH_RUPIAH_STATIC(51400000), PPH_MONEY_STATIC(0, 1800) },
-    { PPH_RUPIAH_STATIC(56300000), PPH_MONEY_STATIC(0, 1900) },
-    { PPH_RUPIAH_STATIC(62200000), PPH_MONEY_STATIC(0, 2000) },
-    { PPH_RUPIAH_STATIC(68600000), PPH_MONEY_STATIC(0, 2100) },
-    { PPH_RUPIAH_STATIC(77500000), PPH_MONEY_STATIC(0, 2200) },
-    { PPH_RUPIAH_STATIC(89000000), PPH_MONEY_STATIC(0, 2300) },
-    { PPH_RUPIAH_STATIC(103000000), PPH_MONEY_STATIC(0, 2400) },
-    { PPH_RUPIAH_STATIC(125000000), PPH_MONEY_STATIC(0, 2500) },
-    { PPH_RUPIAH_STATIC(157000000), PPH_MONEY_STATIC(0, 2600) },
-    { PPH_RUPIAH_STATIC(206000000), PPH_MONEY_STATIC(0, 2700) },
-    { PPH_RUPIAH_STATIC(337000000), PPH_MONEY_STATIC(0, 2800) },
-    { PPH_RUPIAH_STATIC(454000000), PPH_MONEY_STATIC(0, 2900) },
-    { PPH_RUPIAH_STATIC(550000000), PPH_MONEY_STATIC(0, 3000) },
-    { PPH_RUPIAH_STATIC(695000000), PPH_MONEY_STATIC(0, 3100) },
-    { PPH_RUPIAH_STATIC(910000000), PPH_MONEY_STATIC(0, 3200) },
-    { PPH_RUPIAH_STATIC(1400000000), PPH_MONEY_STATIC(0, 3300) },
-    { PPH_RUPIAH_STATIC(2147483647), PPH_MONEY_STATIC(0, 3400) }  /* Infinity */
+static const pph_uint32_t TER_BULANAN_A_CEILINGS[PPH_TER_PADDED(TER_BULANAN_A_COUNT)] = {
+    5400, 5650, 5950, 6300, 6750, 7500, 8550, 9650,
+    10050, 10350, 10700, 11050, 11600, 12500, 13750, 15100,
+    16950, 19750, 24150, 26450, 28000, 30050, 32400, 35400,
+    39100, 43850, 47800, 51400, 56300, 62200, 68600, 77500,
+    89000, 103000, 125000, 157000, 206000, 337000, 454000, 550000,
+    695000, 910000, 1400000, TER_TOP_CEILING,
+    TER_PAD_CEILING, TER_PAD_CEILING, TER_PAD_CEILING, TER_PAD_CEILING
 };
 
-static const ter_entry_t TER_BULANAN_B[TER_BULANAN_B_COUNT] = {
-    { PPH_RUPIAH_STATIC(6200000), PPH_MONEY_STATIC(0, 0) },
-    { PPH_RUPIAH_STATIC(6500000), PPH_MONEY_STATIC(0, 25) },
-    { PPH_RUPIAH_STATIC(6850000), PPH_MONEY_STATIC(0, 50) },
-    { PPH_RUPIAH_STATIC(7300000), PPH_MONEY_STATIC(0, 75) },
-    { PPH_RUPIAH_STATIC(9200000), PPH_MONEY_STATIC(0, 100) },
-    { PPH_RUPIAH_STATIC(10750000), PPH_MONEY_STATIC(0, 150) },
-    { PPH_RUPIAH_STATIC(11250000), PPH_MONEY_STATIC(0, 200) },
-    { PPH_RUPIAH_STATIC(11600000), PPH_MONEY_STATIC(0, 250) },
-    { PPH_RUPIAH_STATIC(12600000), PPH_MONEY_STATIC(0, 300) },
-    { PPH_RUPIAH_STATIC(13600000), PPH_MONEY_STATIC(0, 400) },
-    { PPH_RUPIAH_STATIC(14950000), PPH_MONEY_STATIC(0, 500) },
-    { PPH_RUPIAH_STATIC(16400000), PPH_MONEY_STATIC(0, 600) },
-    { PPH_RUPIAH_STATIC(18450000), PPH_MONEY_STATIC(0, 700) },
-    { PPH_RUPIAH_STATIC(21850000), PPH_MONEY_STATIC(0, 800) },
-    { PPH_RUPIAH_STATIC(26000000), PPH_MONEY_STATIC(0, 900) },
-    { PPH_RUPIAH_STATIC(27700000), PPH_MONEY_STATIC(0, 1000) },
-    { PPH_RUPIAH_STATIC(29350000), PPH_MONEY_STATIC(0, 1100) },
-    { PPH_RUPIAH_STATIC(31450000), PPH_MONEY_STATIC(0, 1200) },
-    { PPH_RUPIAH_STATIC(33950000), PPH_MONEY_STATIC(0, 1300) },
-    { PPH_RUPIAH_STATIC(37100000), PPH_MONEY_STATIC(0, 1400) },
-    { PPH_RUPIAH_STATIC(41100000), PPH_MONEY_STATIC(0, 1500) },
-    { PPH_RUPIAH_STATIC(45800000), PPH_MONEY_STATIC(0, 1600) },
-    { PPH_RUPIAH_STATIC(49500000), PPH_MONEY_STATIC(0, 1700) },
-    { PPH_RUPIAH_STATIC(53800000), PPH_MONEY_STATIC(0, 1800) },
-    { PPH_RUPIAH_STATIC(58500000), PPH_MONEY_STATIC(0, 1900) },
-    { PPH_RUPIAH_STATIC(64000000), PPH_MONEY_STATIC(0, 2000) },
-    { PPH_RUPIAH_STATIC(71000000), PPH_MONEY_STATIC(0, 2100) },
-    { PPH_RUPIAH_STATIC(80000000), PPH_MONEY_STATIC(0, 2200) },
-    { PPH_RUPIAH_STATIC(93000000), PPH_MONEY_STATIC(0, 2300) },
-    { PPH_RUPIAH_STATIC(109000000), PPH_MONEY_STATIC(0, 2400) },
-    { PPH_RUPIAH_STATIC(129000000), PPH_MONEY_STATIC(0, 2500) },
-    { PPH_RUPIAH_STATIC(163000000), PPH_MONEY_STATIC(0, 2600) },
-    { PPH_RUPIAH_STATIC(211000000), PPH_MONEY_STATIC(0, 2700) },
-    { PPH_RUPIAH_STATIC(374000000), PPH_MONEY_STATIC(0, 2800) },
-    { PPH_RUPIAH_STATIC(459000000), PPH_MONEY_STATIC(0, 2900) },
-    { PPH_RUPIAH_STATIC(555000000), PPH_MONEY_STATIC(0, 3000) },
-    { PPH_RUPIAH_STATIC(704000000), PPH_MONEY_STATIC(0, 3100) },
-    { PPH_RUPIAH_STATIC(957000000), PPH_MONEY_STATIC(0, 3200) },
-    { PPH_RUPIAH_STATIC(1405000000), PPH_MONEY_STATIC(0, 3300) },
-    { PPH_RUPIAH_STATIC(2147483647), PPH_MONEY_STATIC(0, 3400) }
+static const pph_uint16_t TER_BULANAN_A_RATES[TER_BULANAN_A_COUNT] = {
+    0, 25, 50, 75, 100, 125, 150, 175, 200, 225, 250,
+    300, 350, 400, 500, 600, 700, 800, 900, 1000, 1100, 1200,
+    1300, 1400, 1500, 1600, 1700, 1800, 1900, 2000, 2100, 2200, 2300,
+    2400, 2500, 2600, 2700, 2800, 2900, 3000, 3100, 3200, 3300, 3400
 };
 
-static const ter_entry_t TER_BULANAN_C[TER_BULANAN_C_COUNT] = {
-    { PPH_RUPIAH_STATIC(6600000), PPH_MONEY_STATIC(0, 0) },
-    { PPH_RUPIAH_STATIC(6950000), PPH_MONEY_STATIC(0, 25) },
-    { PPH_RUPIAH_STATIC(7350000), PPH_MONEY_STATIC(0, 50) },
-    { PPH_RUPIAH_STATIC(7800000), PPH_MONEY_STATIC(0, 75) },
-    { PPH_RUPIAH_STATIC(8850000), PPH_MONEY_STATIC(0, 100) },
-    { PPH_RUPIAH_STATIC(9800000), PPH_MONEY_STATIC(0, 125) },
-    { PPH_RUPIAH_STATIC(10950000), PPH_MONEY_STATIC(0, 150) },
-    { PPH_RUPIAH_STATIC(11200000), PPH_MONEY_STATIC(0, 175) },
-    { PPH_RUPIAH_STATIC(12050000), PPH_MONEY_STATIC(0, 200) },
-    { PPH_RUPIAH_STATIC(12950000), PPH_MONEY_STATIC(0, 300) },
-    { PPH_RUPIAH_STATIC(14150000), PPH_MONEY_STATIC(0, 400) },
-    { PPH_RUPIAH_STATIC(15550000), PPH_MONEY_STATIC(0, 500) },
-    { PPH_RUPIAH_STATIC(17050000), PPH_MONEY_STATIC(0, 600) },
-    { PPH_RUPIAH_STATIC(19500000), PPH_MONEY_STATIC(0, 700) },
-    { PPH_RUPIAH_STATIC(22700000), PPH_MONEY_STATIC(0, 800) },
-    { PPH_RUPIAH_STATIC(26600000), PPH_MONEY_STATIC(0, 900) },
-    { PPH_RUPIAH_STATIC(28100000), PPH_MONEY_STATIC(0, 1000) },
-    { PPH_RUPIAH_STATIC(30100000), PPH_MONEY_STATIC(0, 1100) },
-    { PPH_RUPIAH_STATIC(32600000), PPH_MONEY_STATIC(0, 1200) },
-    { PPH_RUPIAH_STATIC(35400000), PPH_MONEY_STATIC(0, 1300) },
-    { PPH_RUPIAH_STATIC(38900000), PPH_MONEY_STATIC(0, 1400) },
-    { PPH_RUPIAH_STATIC(43000000), PPH_MONEY_STATIC(0, 1500) },
-    { PPH_RUPIAH_STATIC(47400000), PPH_MONEY_STATIC(0, 1600) },
-    { PPH_RUPIAH_STATIC(51200000), PPH_MONEY_STATIC(0, 1700) },
-    { PPH_RUPIAH_STATIC(55800000), PPH_MONEY_STATIC(0, 1800) },
-    { PPH_RUPIAH_STATIC(60400000), PPH_MONEY_STATIC(0, 1900) },
-    { PPH_RUPIAH_STATIC(66700000), PPH_MONEY_STATIC(0, 2000) },
-    { PPH_RUPIAH_STATIC(74500000), PPH_MONEY_STATIC(0, 2100) },
-    { PPH_RUPIAH_STATIC(83200000), PPH_MONEY_STATIC(0, 2200) },
-    { PPH_RUPIAH_STATIC(95600000), PPH_MONEY_STATIC(0, 2300) },
-    { PPH_RUPIAH_STATIC(110000000), PPH_MONEY_STATIC(0, 2400) },
-    { PPH_RUPIAH_STATIC(134000000), PPH_MONEY_STATIC(0, 2500) },
-    { PPH_RUPIAH_STATIC(169000000), PPH_MONEY_STATIC(0, 2600) },
-    { PPH_RUPIAH_STATIC(221000000), PPH_MONEY_STATIC(0, 2700) },
-    { PPH_RUPIAH_STATIC(390000000), PPH_MONEY_STATIC(0, 2800) },
-    { PPH_RUPIAH_STATIC(463000000), PPH_MONEY_STATIC(0, 2900) },
-    { PPH_RUPIAH_STATIC(561000000), PPH_MONEY_STATIC(0, 3000) },
-    { PPH_RUPIAH_STATIC(709000000), PPH_MONEY_STATIC(0, 3100) },
-    { PPH_RUPIAH_STATIC(965000000), PPH_MONEY_STATIC(0, 3200) },
-    { PPH_RUPIAH_STATIC(1419000000), PPH_MONEY_STATIC(0, 3300) },
-    { PPH_RUPIAH_STATIC(2147483647), PPH_MONEY_STATIC(0, 3400) }
+static const pph_uint32_t TER_BULANAN_B_CEILINGS[PPH_TER_PADDED(TER_BULANAN_B_COUNT)] = {
+    6200, 6500, 6850, 7300, 9200, 10750, 11250, 11600,
+    12600, 13600, 14950, 16400, 18450, 21850, 26000, 27700,
+    29350, 31450, 33950, 37100, 41100, 45800, 49500, 53800,
+    58500, 64000, 71000, 80000, 93000, 109000, 129000, 163000,
+    211000, 374000, 459000, 555000, 704000, 957000, 1405000, TER_TOP_CEILING
 };
 
-pph_money_t pph_get_ter_bulanan_rate(pph21_ter_category_t category, pph_money_t bruto_monthly) {
-    const ter_entry_t *table;
-    int count, i;
-    pph_money_t fallback_rate;
+static const pph_uint16_t TER_BULANAN_B_RATES[TER_BULANAN_B_COUNT] = {
+    0, 25, 50, 75, 100, 150, 200, 250, 300, 400, 500,
+    600, 700, 800, 900, 1000, 1100, 1200, 1300, 1400, 1500, 1600,
+    1700, 1800, 1900, 2000, 2100, 2200, 2300, 2400, 2500, 2600, 2700,
+    2800, 2900, 3000, 3100, 3200, 3300, 3400
+};
 
+static const pph_uint32_t TER_BULANAN_C_CEILINGS[PPH_TER_PADDED(TER_BULANAN_C_COUNT)] = {
+    6600, 6950, 7350, 7800, 8850, 9800, 10950, 11200,
+    12050, 12950, 14150, 15550, 17050, 19500, 22700, 26600,
+    28100, 30100, 32600, 35400, 38900, 43000, 47400, 51200,
+    55800, 60400, 66700, 74500, 83200, 95600, 110000, 134000,
+    169000, 221000, 390000, 463000, 561000, 709000, 965000, 1419000,
+    TER_TOP_CEILING, TER_PAD_CEILING, TER_PAD_CEILING, TER_PAD_CEILING,
+    TER_PAD_CEILING, TER_PAD_CEILING, TER_PAD_CEILING, TER_PAD_CEILING
+};
+
+static const pph_uint16_t TER_BULANAN_C_RATES[TER_BULANAN_C_COUNT] = {
+    0, 25, 50, 75, 100, 125, 150, 175, 200, 300, 400,
+    500, 600, 700, 800, 900, 1000, 1100, 1200, 1300, 1400, 1500,
+    1600, 1700, 1800, 1900, 2000, 2100, 2200, 2300, 2400, 2500, 2600,
+    2700, 2800, 2900, 3000, 3100, 3200, 3300, 3400
+};
+
+const pph_ter_table_t* pph_ter_monthly_table(const pph_rules_t *rules,
+                                             pph21_ter_category_t category) {
     switch (category) {
         case PPH21_TER_CATEGORY_B:
-            table = TER_BULANAN_B;
-            count = TER_BULANAN_B_COUNT;
-            break;
+            return &rules->ter_monthly[1];
         case PPH21_TER_CATEGORY_C:
-            table = TER_BULANAN_C;
-            count = TER_BULANAN_C_COUNT;
-            break;
+            return &rules->ter_monthly[2];
         case PPH21_TER_CATEGORY_A:
         default:
-            table = TER_BULANAN_A;
-            count = TER_BULANAN_A_COUNT;
-            break;
+            return &rules->ter_monthly[0];
     }
+}
 
-    fallback_rate = table[count - 1].rate;
-
-    for (i = 0; i < count; i++) {
-        if (pph_money_cmp(bruto_monthly, table[i].ceiling) <= 0) {
-            return table[i].rate;
-        }
-    }
+pph_money_t pph_get_ter_bulanan_rate(pph21_ter_category_t category, pph_money_t bruto_monthly) {
+    const pph_ter_table_t *table = pph_ter_monthly_table(pph_rules_enter(), category);
+    pph_money_t rate = pph_ter_rate(table, pph_ter_bracket(table, bruto_monthly.value));
 
-    return fallback_rate;
+    pph_rules_exit();
+    return rate;
 }
 
 /* ============================================
@@ -253,46 +191,166 @@ pph_money_t pph_get_ter_bulanan_rate(pph21_ter_category_t category, pph_money_t
 
 #define TER_HARIAN_COUNT 3
 
-static const ter_entry_t TER_HARIAN_A[TER_HARIAN_COUNT] = {
-    { PPH_RUPIAH_STATIC(750000), PPH_MONEY_STATIC(0, 25) },
-    { PPH_RUPIAH_STATIC(2500000), PPH_MONEY_STATIC(0, 150) },
-    { PPH_RUPIAH_STATIC(2147483647), PPH_MONEY_STATIC(0, 200) }
+static const pph_uint32_t TER_HARIAN_CEILINGS[PPH_TER_PADDED(TER_HARIAN_COUNT)] = {
+    750, 2500, TER_TOP_CEILING, TER_PAD_CEILING,
+    TER_PAD_CEILING, TER_PAD_CEILING, TER_PAD_CEILING, TER_PAD_CEILING
 };
 
-static const ter_entry_t TER_HARIAN_B[TER_HARIAN_COUNT] = {
-    { PPH_RUPIAH_STATIC(750000), PPH_MONEY_STATIC(0, 25) },
-    { PPH_RUPIAH_STATIC(2500000), PPH_MONEY_STATIC(0, 125) },
-    { PPH_RUPIAH_STATIC(2147483647), PPH_MONEY_STATIC(0, 175) }
-};
-
-static const ter_entry_t TER_HARIAN_C[TER_HARIAN_COUNT] = {
-    { PPH_RUPIAH_STATIC(750000), PPH_MONEY_STATIC(0, 25) },
-    { PPH_RUPIAH_STATIC(2500000), PPH_MONEY_STATIC(0, 100) },
-    { PPH_RUPIAH_STATIC(2147483647), PPH_MONEY_STATIC(0, 150) }
-};
+static const pph_uint16_t TER_HARIAN_A_RATES[TER_HARIAN_COUNT] = { 25, 150, 200 };
+static const pph_uint16_t TER_HARIAN_B_RATES[TER_HARIAN_COUNT] = { 25, 125, 175 };
+static const pph_uint16_t TER_HARIAN_C_RATES[TER_HARIAN_COUNT] = { 25, 100, 150 };
 
 pph_money_t pph_get_ter_harian_rate(pph21_ter_category_t category, pph_money_t bruto) {
-    const ter_entry_t *table;
-    int i;
+    const pph_rules_t *rules = pph_rules_enter();
+    const pph_ter_table_t *table;
+    pph_money_t rate;
 
     switch (category) {
         case PPH21_TER_CATEGORY_B:
-            table = TER_HARIAN_B;
+            table = &rules->ter_daily[1];
             break;
         case PPH21_TER_CATEGORY_C:
-            table = TER_HARIAN_C;
+            table = &rules->ter_daily[2];
             break;
         case PPH21_TER_CATEGORY_A:
         default:
-            table = TER_HARIAN_A;
+            table = &rules->ter_daily[0];
             break;
     }
 
-    for (i = 0; i < TER_HARIAN_COUNT; i++) {
-        if (pph_money_cmp(bruto, table[i].ceiling) <= 0) {
-            return table[i].rate;
+    rate = pph_ter_rate(table, pph_ter_bracket(table, bruto.value));
+    pph_rules_exit();
+    return rate;
+}
+
+/* ============================================
+   Built-in Rules
+   ============================================ */
+
+static pph_uint8_t BUILTIN_TER_INDEX[PPH_TER_INDEX_BYTES];
+
+/* The tables as compiled in, without indexes (lookups scan) */
+static const pph_rules_t BUILTIN_RULES = {
+    PPH_PTKP_TABLE,
+    PPH_PASAL17_BRACKETS,
+    PASAL17_BRACKET_COUNT,
+    {
+        { TER_BULANAN_A_CEILINGS, TER_BULANAN_A_RATES, TER_BULANAN_A_COUNT, NULL, 0 },
+        { TER_BULANAN_B_CEILINGS, TER_BULANAN_B_RATES, TER_BULANAN_B_COUNT, NULL, 0 },
+        { TER_BULANAN_C_CEILINGS, TER_BULANAN_C_RATES, TER_BULANAN_C_COUNT, NULL, 0 }
+    },
+    {
+        { TER_HARIAN_CEILINGS, TER_HARIAN_A_RATES, TER_HARIAN_COUNT, NULL, 0 },
+        { TER_HARIAN_CEILINGS, TER_HARIAN_B_RATES, TER_HARIAN_COUNT, NULL, 0 },
+        { TER_HARIAN_CEILINGS, TER_HARIAN_C_RATES, TER_HARIAN_COUNT, NULL, 0 }
+    }
+};
+
+/* The first pph_init() builds an indexed copy and publishes it like a
+   loaded ruleset, so a thread already calculating sees either the plain
+   tables or the complete index, never a half-built one */
+static pph_rules_t BUILTIN_INDEXED_RULES;
+static void *volatile builtin_indexed = NULL;
+static volatile long builtin_index_claimed = 0;
+
+const pph_rules_t* pph_builtin_rules(void) {
+    const pph_rules_t *rules = (const pph_rules_t*)pph_atomic_load_ptr(&builtin_indexed);
+
+    return rules ? rules : &BUILTIN_RULES;
+}
+
+void pph_init_ter_index(void) {
+    if (!pph_atomic_cas_long(&builtin_index_claimed, 0, 1)) {
+        return;
+    }
+
+    BUILTIN_INDEXED_RULES = BUILTIN_RULES;
+    pph_rules_build_index(&BUILTIN_INDEXED_RULES, BUILTIN_TER_INDEX);
+    (void)pph_atomic_exchange_ptr(&builtin_indexed, (void*)&BUILTIN_INDEXED_RULES);
+}
+
+/* ============================================
+   Quantized TER Bracket Index
+
+   Every TER ceiling below the top bracket is a whole multiple of
+   PPH_TER_QUANTUM (Rp 50.000), so the bracket is constant across each
+   quantum and a bucket number indexes it directly. Buckets cover the
+   dense low end of each table; above them only a few wide brackets
+   remain and are scanned. Tables without an index (the built-in ones
+   before pph_init(), or any whose ceilings break the rule) are scanned
+   from the start.
+   ============================================ */
+
+/* Leaves the table unindexed when a covered ceiling is not a multiple
+   of the quantum */
+static void build_ter_index(pph_ter_table_t *table, pph_uint8_t *index, int buckets) {
+    pph_uint32_t limit = (pph_uint32_t)buckets * PPH_TER_QUANTUM;
+    pph_uint32_t k;
+    int i;
+
+    for (i = 0; i < table->count - 1 && table->ceilings[i] <= limit; i++) {
+        if (table->ceilings[i] % PPH_TER_QUANTUM != 0) {
+            return;
+        }
+    }
+
+    /* Bucket k holds keys in (k * quantum, (k + 1) * quantum] */
+    i = 0;
+    for (k = 0; k < (pph_uint32_t)buckets; k++) {
+        while (i < table->count - 1 && table->ceilings[i] < (k + 1) * PPH_TER_QUANTUM) {
+            i++;
         }
+        index[k] = (pph_uint8_t)i;
     }
 
-    return table[TER_HARIAN_COUNT - 1].rate;
+    table->quantized = index;
+    table->quantized_count = buckets;
+}
+
+void pph_rules_build_index(pph_rules_t *rules, pph_uint8_t *storage) {
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        build_ter_index(&rules->ter_monthly[i], storage, PPH_TER_MONTHLY_BUCKETS);
+        storage += PPH_TER_MONTHLY_BUCKETS;
+    }
+    for (i = 0; i < 3; i++) {
+        build_ter_index(&rules->ter_daily[i], storage, PPH_TER_DAILY_BUCKETS);
+        storage += PPH_TER_DAILY_BUCKETS;
+    }
+}
+
+pph_money_t pph_ter_rate(const pph_ter_table_t *table, int bracket) {
+    pph_money_t rate;
+
+    rate.value = PPH_TER_RATE(table, bracket);
+    return rate;
+}
+
+/* Bracket from the quantized index alone, or -1 if the income is above
+   the index or it is not built */
+static int ter_quantized_bracket(const pph_ter_table_t *table, pph_int64_t income) {
+    pph_uint32_t key = PPH_TER_KEY(income);
+
+    if (key > (pph_uint32_t)table->quantized_count * PPH_TER_QUANTUM) {
+        return -1;
+    }
+    return (key == 0) ? 0 : table->quantized[(key - 1) / PPH_TER_QUANTUM];
+}
+
+int pph_ter_bracket(const pph_ter_table_t *table, pph_int64_t income) {
+    pph_uint32_t key;
+    int i = ter_quantized_bracket(table, income);
+
+    if (i >= 0) {
+        return i;
+    }
+
+    /* High tail: continue from the last bucket's bracket */
+    key = PPH_TER_KEY(income);
+    i = (table->quantized_count > 0) ? table->quantized[table->quantized_count - 1] : 0;
+    while (i < table->count - 1 && key > table->ceilings[i]) {
+        i++;
+    }
+    return i;
 }
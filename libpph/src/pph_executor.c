@@ -0,0 +1,438 @@
+/*
+ * PPH Executor - Thread pool for parallel batch calculation
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#include <pph/pph_calculator.h>
+#include <pph/pph_money_inline.h>
+#include "pph_internal.h"
+#include "pph_thread.h"
+
+/* Upper bound on pool size; more threads than this never pays off for
+   a memory-bound payroll run */
+#define EXECUTOR_MAX_THREADS 256
+
+/* Records per task for batch jobs: small enough that the tail of a run
+   balances, large enough that deque traffic stays negligible */
+#define EXECUTOR_TASK_MIN 32
+#define EXECUTOR_TASKS_PER_WORKER 32
+
+/* Per-worker slot. The deque holds the worker's remaining tasks as the
+   range [head, tail): the owner takes from the head, thieves take from
+   the tail, so an owner keeps walking its records in order while idle
+   workers drain the far end. Partial results are written only by the
+   slot's worker and reduced without atomics; the padding keeps
+   neighbouring slots off the same cache line. */
+typedef struct {
+    pph_mutex_t lock;
+    pph_size_t head;
+    pph_size_t tail;
+
+    pph21_batch_totals_t totals;
+    pph_status_t first_error;
+    pph_size_t first_error_index;
+    char pad[64];
+} executor_slot_t;
+
+typedef struct {
+    pph_executor_t *executor;
+    int index;
+    pph_thread_start_t start;
+} executor_worker_t;
+
+struct pph_executor {
+    int thread_count;               /* Workers including the calling thread */
+    int started;                    /* Background threads actually running */
+    int slot_count;                 /* Slots allocated (requested thread count) */
+    pph_thread_t *threads;
+    executor_worker_t *workers;
+    executor_slot_t *slots;
+
+    pph_mutex_t run_lock;           /* One job at a time per executor */
+    pph_mutex_t lock;
+    pph_cond_t work_ready;
+    pph_cond_t work_done;
+    unsigned long generation;
+    int pending;
+    int shutdown;
+
+    pph_task_fn task;
+    void *task_ctx;
+};
+
+/* ============================================
+   Work Stealing
+   ============================================ */
+
+/* Take the next task from the worker's own deque */
+static int executor_pop(executor_slot_t *slot, pph_size_t *task) {
+    int found = 0;
+
+    pph_mutex_lock(&slot->lock);
+    if (slot->head < slot->tail) {
+        *task = slot->head++;
+        found = 1;
+    }
+    pph_mutex_unlock(&slot->lock);
+    return found;
+}
+
+/* Take the last task from another worker's deque */
+static int executor_steal(executor_slot_t *slot, pph_size_t *task) {
+    int found = 0;
+
+    pph_mutex_lock(&slot->lock);
+    if (slot->head < slot->tail) {
+        *task = --slot->tail;
+        found = 1;
+    }
+    pph_mutex_unlock(&slot->lock);
+    return found;
+}
+
+/* Run tasks until every deque is empty. No task is ever pushed once a
+   job has started, so one full pass over the victims that finds nothing
+   means the job is finished for this worker. */
+static void executor_work(pph_executor_t *executor, int worker) {
+    int count = executor->thread_count;
+    pph_size_t task;
+    int victim, stolen, i;
+
+    for (;;) {
+        while (executor_pop(&executor->slots[worker], &task)) {
+            executor->task(executor->task_ctx, worker, task);
+        }
+
+        stolen = 0;
+        for (i = 1; i < count && !stolen; i++) {
+            victim = (worker + i) % count;
+            if (executor_steal(&executor->slots[victim], &task)) {
+                executor->task(executor->task_ctx, worker, task);
+                stolen = 1;
+            }
+        }
+        if (!stolen) {
+            return;
+        }
+    }
+}
+
+/* ============================================
+   Worker Loop
+   ============================================ */
+
+static void executor_worker_main(void *arg) {
+    executor_worker_t *worker = (executor_worker_t*)arg;
+    pph_executor_t *executor = worker->executor;
+    unsigned long seen = 0;
+
+    for (;;) {
+        pph_mutex_lock(&executor->lock);
+        while (!executor->shutdown && executor->generation == seen) {
+            pph_cond_wait(&executor->work_ready, &executor->lock);
+        }
+        if (executor->shutdown) {
+            pph_mutex_unlock(&executor->lock);
+            return;
+        }
+        seen = executor->generation;
+        pph_mutex_unlock(&executor->lock);
+
+        executor_work(executor, worker->index);
+
+        pph_mutex_lock(&executor->lock);
+        if (--executor->pending == 0) {
+            pph_cond_broadcast(&executor->work_done);
+        }
+        pph_mutex_unlock(&executor->lock);
+    }
+}
+
+/* Run task_count tasks on the pool; the calling thread acts as worker 0.
+   Tasks start out dealt in contiguous runs, one run per worker. */
+static void executor_run(pph_executor_t *executor, pph_task_fn task,
+                         void *ctx, pph_size_t task_count) {
+    pph_size_t workers;
+    int i;
+
+    pph_mutex_lock(&executor->run_lock);
+
+    workers = (pph_size_t)executor->thread_count;
+    for (i = 0; i < executor->thread_count; i++) {
+        executor_slot_t *slot = &executor->slots[i];
+
+        pph_mutex_lock(&slot->lock);
+        slot->head = task_count / workers * (pph_size_t)i +
+                     (((pph_size_t)i < task_count % workers) ? (pph_size_t)i : task_count % workers);
+        slot->tail = slot->head + task_count / workers +
+                     (((pph_size_t)i < task_count % workers) ? 1 : 0);
+        pph_mutex_unlock(&slot->lock);
+    }
+
+    executor->task = task;
+    executor->task_ctx = ctx;
+
+    if (executor->thread_count > 1) {
+        pph_mutex_lock(&executor->lock);
+        executor->pending = executor->thread_count - 1;
+        executor->generation++;
+        pph_cond_broadcast(&executor->work_ready);
+        pph_mutex_unlock(&executor->lock);
+    }
+
+    executor_work(executor, 0);
+
+    if (executor->thread_count > 1) {
+        pph_mutex_lock(&executor->lock);
+        while (executor->pending > 0) {
+            pph_cond_wait(&executor->work_done, &executor->lock);
+        }
+        pph_mutex_unlock(&executor->lock);
+    }
+
+    pph_mutex_unlock(&executor->run_lock);
+}
+
+/* ============================================
+   Executor Lifetime
+   ============================================ */
+
+static void executor_stop_threads(pph_executor_t *executor) {
+    int i;
+
+    pph_mutex_lock(&executor->lock);
+    executor->shutdown = 1;
+    pph_cond_broadcast(&executor->work_ready);
+    pph_mutex_unlock(&executor->lock);
+
+    for (i = 0; i < executor->started; i++) {
+        pph_thread_join(executor->threads[i]);
+    }
+    executor->started = 0;
+}
+
+pph_executor_t* pph_executor_create(int thread_count) {
+    pph_executor_t *executor;
+    int i;
+
+    if (thread_count <= 0) {
+        thread_count = pph_cpu_count();
+    }
+    if (thread_count > EXECUTOR_MAX_THREADS) {
+        thread_count = EXECUTOR_MAX_THREADS;
+    }
+#if !defined(PPH_HAVE_THREADS)
+    thread_count = 1;
+#endif
+
+    executor = (pph_executor_t*)pph_malloc(sizeof(pph_executor_t));
+    if (executor == NULL) {
+        pph_set_last_error("Memory allocation failed");
+        return NULL;
+    }
+
+    executor->thread_count = thread_count;
+    executor->slot_count = thread_count;
+    executor->started = 0;
+    executor->generation = 0;
+    executor->pending = 0;
+    executor->shutdown = 0;
+    executor->task = NULL;
+    executor->task_ctx = NULL;
+
+    executor->threads = (pph_thread_t*)pph_malloc(sizeof(pph_thread_t) * (pph_size_t)thread_count);
+    executor->workers = (executor_worker_t*)pph_malloc(sizeof(executor_worker_t) * (pph_size_t)thread_count);
+    executor->slots = (executor_slot_t*)pph_malloc(sizeof(executor_slot_t) * (pph_size_t)thread_count);
+
+    if (executor->threads == NULL || executor->workers == NULL || executor->slots == NULL) {
+        pph_free(executor->threads);
+        pph_free(executor->workers);
+        pph_free(executor->slots);
+        pph_free(executor);
+        pph_set_last_error("Memory allocation failed");
+        return NULL;
+    }
+
+    pph_mutex_init(&executor->run_lock);
+    pph_mutex_init(&executor->lock);
+    pph_cond_init(&executor->work_ready);
+    pph_cond_init(&executor->work_done);
+    for (i = 0; i < thread_count; i++) {
+        pph_mutex_init(&executor->slots[i].lock);
+    }
+
+    /* Worker 0 is the calling thread; start the others */
+    for (i = 1; i < thread_count; i++) {
+        executor_worker_t *worker = &executor->workers[i];
+
+        worker->executor = executor;
+        worker->index = i;
+        worker->start.fn = executor_worker_main;
+        worker->start.arg = worker;
+
+        if (pph_thread_create(&executor->threads[executor->started], &worker->start) != 0) {
+            break;
+        }
+        executor->started++;
+    }
+
+    /* Fewer threads than asked for: run with what started */
+    executor->thread_count = executor->started + 1;
+
+    return executor;
+}
+
+void pph_executor_free(pph_executor_t *executor) {
+    int i;
+
+    if (executor == NULL) {
+        return;
+    }
+
+    executor_stop_threads(executor);
+
+    /* Slot locks were created for the requested size, not the started one */
+    for (i = 0; i < executor->slot_count; i++) {
+        pph_mutex_destroy(&executor->slots[i].lock);
+    }
+
+    pph_cond_destroy(&executor->work_done);
+    pph_cond_destroy(&executor->work_ready);
+    pph_mutex_destroy(&executor->lock);
+    pph_mutex_destroy(&executor->run_lock);
+
+    pph_free(executor->threads);
+    pph_free(executor->workers);
+    pph_free(executor->slots);
+    pph_free(executor);
+}
+
+int pph_executor_thread_count(const pph_executor_t *executor) {
+    return (executor != NULL) ? executor->thread_count : 0;
+}
+
+void pph_executor_run(pph_executor_t *executor, pph_task_fn task,
+                      void *ctx, pph_size_t task_count) {
+    if (executor == NULL || task == NULL || task_count == 0) {
+        return;
+    }
+    executor_run(executor, task, ctx, task_count);
+}
+
+/* ============================================
+   Parallel PPh21 Batch
+   ============================================ */
+
+typedef struct {
+    const pph21_input_t *inputs;
+    pph21_summary_t *outputs;
+    pph_size_t count;
+    pph_size_t task_size;
+    executor_slot_t *slots;
+    const pph_rules_t *rules;  /* Pinned by the calling thread */
+} pph21_batch_job_t;
+
+static void totals_clear(pph21_batch_totals_t *totals) {
+    totals->total_tax = PPH_ZERO;
+    totals->ter_paid = PPH_ZERO;
+    totals->adjustment = PPH_ZERO;
+    totals->failed = 0;
+}
+
+static void pph21_batch_task(void *ctx, int worker, pph_size_t task) {
+    pph21_batch_job_t *job = (pph21_batch_job_t*)ctx;
+    executor_slot_t *slot = &job->slots[worker];
+    pph_size_t begin = task * job->task_size;
+    pph_size_t end = begin + job->task_size;
+    const pph_rules_t *previous;
+    pph_size_t i;
+
+    if (end > job->count) {
+        end = job->count;
+    }
+
+    /* Every record lands in its own index whichever worker runs it */
+    previous = pph_rules_adopt(job->rules);
+    pph21_calculate_batch(job->inputs + begin, end - begin, job->outputs + begin);
+    pph_rules_restore(previous);
+
+    for (i = begin; i < end; i++) {
+        const pph21_summary_t *out = &job->outputs[i];
+
+        if (out->status != PPH_OK) {
+            if (slot->totals.failed++ == 0 || i < slot->first_error_index) {
+                slot->first_error = out->status;
+                slot->first_error_index = i;
+            }
+            continue;
+        }
+        slot->totals.total_tax = pph_money_add(slot->totals.total_tax, out->total_tax);
+        slot->totals.ter_paid = pph_money_add(slot->totals.ter_paid, out->ter_paid);
+        slot->totals.adjustment = pph_money_add(slot->totals.adjustment, out->adjustment);
+    }
+}
+
+pph_status_t pph21_calculate_batch_parallel(pph_executor_t *executor,
+                                            const pph21_input_t *inputs,
+                                            pph_size_t count,
+                                            pph21_summary_t *outputs,
+                                            pph21_batch_totals_t *totals) {
+    pph21_batch_job_t job;
+    pph_status_t first_error = PPH_OK;
+    pph_size_t first_error_index = 0;
+    int i;
+
+    if (totals != NULL) {
+        totals_clear(totals);
+    }
+
+    if (count == 0) {
+        return PPH_OK;
+    }
+
+    if (executor == NULL || inputs == NULL || outputs == NULL) {
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    job.inputs = inputs;
+    job.outputs = outputs;
+    job.count = count;
+    job.slots = executor->slots;
+    job.task_size = count / ((pph_size_t)executor->thread_count * EXECUTOR_TASKS_PER_WORKER);
+    if (job.task_size < EXECUTOR_TASK_MIN) {
+        job.task_size = EXECUTOR_TASK_MIN;
+    }
+
+    for (i = 0; i < executor->thread_count; i++) {
+        totals_clear(&executor->slots[i].totals);
+        executor->slots[i].first_error = PPH_OK;
+        executor->slots[i].first_error_index = 0;
+    }
+
+    /* The whole batch runs on one ruleset, even if another is published */
+    job.rules = pph_rules_enter();
+    executor_run(executor, pph21_batch_task, &job,
+                 (count + job.task_size - 1) / job.task_size);
+    pph_rules_exit();
+
+    /* Stolen tasks leave errors out of order across slots; the status
+       returned is that of the lowest failing index */
+    for (i = 0; i < executor->thread_count; i++) {
+        const executor_slot_t *slot = &executor->slots[i];
+
+        if (slot->totals.failed > 0 &&
+            (first_error == PPH_OK || slot->first_error_index < first_error_index)) {
+            first_error = slot->first_error;
+            first_error_index = slot->first_error_index;
+        }
+        if (totals != NULL) {
+            totals->total_tax = pph_money_add(totals->total_tax, slot->totals.total_tax);
+            totals->ter_paid = pph_money_add(totals->ter_paid, slot->totals.ter_paid);
+            totals->adjustment = pph_money_add(totals->adjustment, slot->totals.adjustment);
+            totals->failed += slot->totals.failed;
+        }
+    }
+
+    return first_error;
+}
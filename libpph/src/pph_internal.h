@@ -12,6 +12,7 @@
 #define PPH_INTERNAL_H
 
 #include <pph/pph_calculator.h>
+#include <pph/pph_money_inline.h>
 #include <stddef.h>  /* for size_t */
 
 #ifdef __cplusplus
@@ -31,53 +32,64 @@ pph_result_t* pph_result_create(void);
 /**
  * Add a section header to breakdown
  * @param result Result structure
- * @param label Section label text
- * @return 0 on success, -1 on error
+ * @param label Section label ID
+ * @return 1 on success, 0 on error
  */
-int pph_result_add_section(pph_result_t *result, const char *label);
+int pph_result_add_section(pph_result_t *result, pph_label_id_t label);
 
 /**
  * Add a currency value row to breakdown
  * @param result Result structure
- * @param label Row label text
+ * @param label Row label ID
  * @param value Money value to display
- * @param note Optional note text (can be NULL)
- * @return 0 on success, -1 on error
+ * @param note Note ID (PPH_LABEL_NONE for none)
+ * @return 1 on success, 0 on error
  */
-int pph_result_add_currency(pph_result_t *result, const char *label,
-                             pph_money_t value, const char *note);
+int pph_result_add_currency(pph_result_t *result, pph_label_id_t label,
+                             pph_money_t value, pph_label_id_t note);
 
 /**
  * Add a percentage value row to breakdown
  * @param result Result structure
- * @param label Row label text
+ * @param label Row label ID
  * @param percent Percentage value (as money, e.g., 0.0500 for 5%)
- * @param note Optional note text (can be NULL)
- * @return 0 on success, -1 on error
+ * @param note Note ID (PPH_LABEL_NONE for none)
+ * @return 1 on success, 0 on error
  */
-int pph_result_add_percent(pph_result_t *result, const char *label,
-                            pph_money_t percent, const char *note);
+int pph_result_add_percent(pph_result_t *result, pph_label_id_t label,
+                            pph_money_t percent, pph_label_id_t note);
 
 /**
  * Add a subtotal row to breakdown
  * @param result Result structure
- * @param label Subtotal label text
+ * @param label Subtotal label ID
  * @param value Money value to display
- * @return 0 on success, -1 on error
+ * @return 1 on success, 0 on error
  */
-int pph_result_add_subtotal(pph_result_t *result, const char *label,
+int pph_result_add_subtotal(pph_result_t *result, pph_label_id_t label,
                              pph_money_t value);
 
 /**
  * Add a total row to breakdown
  * @param result Result structure
- * @param label Total label text
+ * @param label Total label ID
  * @param value Money value to display
- * @return 0 on success, -1 on error
+ * @return 1 on success, 0 on error
  */
-int pph_result_add_total(pph_result_t *result, const char *label,
+int pph_result_add_total(pph_result_t *result, pph_label_id_t label,
                           pph_money_t value);
 
+/**
+ * Give the last added row dynamic label and/or note text, copied into
+ * the result's string pool; the row keeps its IDs
+ * @param result Result structure
+ * @param label Label text, or NULL to keep the static text
+ * @param note Note text, or NULL to keep the static text
+ * @return 1 on success, 0 on error (the row keeps its static text)
+ */
+int pph_result_set_text(pph_result_t *result, const char *label,
+                        const char *note);
+
 /* ============================================
    Error Handling (pph_breakdown.c)
    ============================================ */
@@ -106,6 +118,29 @@ pph_money_t pph_get_ptkp(pph_ptkp_status_t status);
  */
 pph_money_t pph_calculate_pasal17(pph_money_t pkp);
 
+/**
+ * Calculate Pasal 17 tax for a block of PKP values (money units)
+ * Same results as pph_calculate_pasal17(), without branches per value.
+ */
+void pph_calculate_pasal17_block(const pph_int64_t *pkp, int count, pph_int64_t *tax);
+
+/* One Pasal 17 bracket: where it starts, the tax due at that point and
+   the marginal rate above it */
+typedef struct {
+    pph_money_t start;
+    pph_money_t base_tax;
+    pph_money_t rate;  /* Stored as fraction (0.05 = 500/10000) */
+} pph_pasal17_bracket_t;
+
+/* floor(amount * rate / 10000) without forming the full product; amount
+   and rate must be non-negative */
+static PPH_INLINE pph_int64_t pph_apply_rate(pph_int64_t amount, pph_int64_t rate) {
+    pph_uint64_t whole = pph_udiv_1e4_inline((pph_uint64_t)amount);
+    pph_uint64_t rest = (pph_uint64_t)amount - whole * PPH_SCALE_FACTOR;
+
+    return (pph_int64_t)(whole * (pph_uint64_t)rate + pph_udiv_1e4_inline(rest * (pph_uint64_t)rate));
+}
+
 /**
  * Get TER (Tarif Efektif Rata-rata) monthly withholding rate
  * @param category TER category (A, B, or C)
@@ -115,6 +150,136 @@ pph_money_t pph_calculate_pasal17(pph_money_t pkp);
 pph_money_t pph_get_ter_bulanan_rate(pph21_ter_category_t category,
                                       pph_money_t bruto_monthly);
 
+/**
+ * Monthly TER table for one category, as parallel columns
+ * ceilings[] is in thousands of rupiah, ascending and padded to
+ * PPH_TER_PADDED(count) entries with PPH_TER_CEILING_PAD so it can be
+ * scanned in fixed-width groups. Values stay below 2^31, so signed
+ * 32-bit vector compares work. rates[] is in basis points, which is the
+ * money scale of a rate. An income falls in the first bracket whose
+ * ceiling is >= its key, PPH_TER_KEY(income).
+ */
+#define PPH_TER_PAD 8
+#define PPH_TER_PADDED(count) ((((count) + PPH_TER_PAD - 1) / PPH_TER_PAD) * PPH_TER_PAD)
+#define PPH_TER_CEILING_PAD 0x7FFFFFFFUL
+
+/* Rp 1.000 in money units, and the income whose key saturates */
+#define PPH_TER_UNIT PPH_INT64_C(10000000)
+#define PPH_TER_KEY_MAX (PPH_INT64_C(0x7FFFFFFF) * PPH_TER_UNIT)
+
+/* Income in money units rounded up to whole thousands of rupiah */
+#define PPH_TER_KEY(income) \
+    ((pph_uint32_t)(((income) <= 0) ? 0 : ((income) >= PPH_TER_KEY_MAX) ? PPH_TER_CEILING_PAD : \
+                    pph_udiv_1e7_inline((pph_uint64_t)((income) - 1)) + 1))
+
+#define PPH_TER_QUANTUM 50  /* Rp 50.000, in ceiling units */
+
+typedef struct {
+    const pph_uint32_t *ceilings;  /* Thousands of rupiah, padded */
+    const pph_uint16_t *rates;     /* Basis points, count entries */
+    int count;
+    const pph_uint8_t *quantized;  /* Bracket per PPH_TER_QUANTUM of key */
+    int quantized_count;           /* Buckets in quantized[] */
+} pph_ter_table_t;
+
+/* Widen a bracket's rate to money */
+#define PPH_TER_RATE(table, bracket) ((pph_int64_t)(table)->rates[bracket])
+
+/**
+ * Get a bracket's rate as money
+ */
+pph_money_t pph_ter_rate(const pph_ter_table_t *table, int bracket);
+
+/**
+ * Get the bracket of an income in a TER table
+ * Same result as scanning for the first ceiling >= income, in constant
+ * time for incomes covered by the quantized index.
+ */
+int pph_ter_bracket(const pph_ter_table_t *table, pph_int64_t income);
+
+/**
+ * Build the quantized bracket indexes of the built-in tables (pph_init)
+ */
+void pph_init_ter_index(void);
+
+/* Largest yearly magnitude of a PPh 21 record (twelve months of salary
+   and pension plus bonuses and zakat) that cannot overflow; see the
+   range checks in pph21.c */
+#define PPH21_SAFE_MAGNITUDE ((pph_uint64_t)PPH_INT64_C(0x7FFFFFFFFFFFFFFF) / 16)
+
+/* ============================================
+   Rules
+
+   The tables of one tax ruleset, either compiled in or loaded from a
+   ruleset file. A calculation pins the published rules with
+   pph_rules_enter() and uses that one set throughout, even if a new
+   ruleset is published meanwhile; pointers into the rules are valid only
+   until the matching pph_rules_exit(). The table getters above pin for
+   themselves, so nested use inside a pinned calculation is cheap.
+   ============================================ */
+
+#define PPH_TER_MONTHLY_BUCKETS 2048  /* Up to Rp 102,4 juta */
+#define PPH_TER_DAILY_BUCKETS 64      /* Up to Rp 3,2 juta */
+#define PPH_TER_INDEX_BYTES (3 * PPH_TER_MONTHLY_BUCKETS + 3 * PPH_TER_DAILY_BUCKETS)
+
+typedef struct {
+    const pph_uint32_t *ptkp;                /* 8 entries, thousands of rupiah */
+    const pph_pasal17_bracket_t *brackets;   /* Ascending, first starts at 0 */
+    int bracket_count;
+    pph_ter_table_t ter_monthly[3];          /* By pph21_ter_category_t */
+    pph_ter_table_t ter_daily[3];
+} pph_rules_t;
+
+/**
+ * Pin the published rules for the calling thread (nestable)
+ * Lock-free; see pph_ruleset.c.
+ * @return Rules (never NULL), valid until the matching pph_rules_exit()
+ */
+const pph_rules_t* pph_rules_enter(void);
+
+/**
+ * Release the pin taken by pph_rules_enter()
+ */
+void pph_rules_exit(void);
+
+/**
+ * Use rules kept alive by someone else until pph_rules_restore()
+ * For workers of a calculation whose caller holds the pin throughout, and
+ * for rules owned by a registry. Overrides any rules pinned already.
+ * @return Rules to hand back to pph_rules_restore()
+ */
+const pph_rules_t* pph_rules_adopt(const pph_rules_t *rules);
+
+/**
+ * End pph_rules_adopt(), going back to the rules it returned
+ */
+void pph_rules_restore(const pph_rules_t *previous);
+
+/**
+ * Get the rules a registry has in force on a date (YYYYMMDD)
+ * @return Rules owned by the registry, or NULL if none is in force
+ */
+const pph_rules_t* pph_ruleset_registry_rules(const pph_ruleset_registry_t *registry, long date);
+
+/**
+ * Get the compiled-in rules
+ */
+const pph_rules_t* pph_builtin_rules(void);
+
+/**
+ * Build the quantized TER indexes of a set of rules
+ * @param storage PPH_TER_INDEX_BYTES bytes that live as long as the rules
+ */
+void pph_rules_build_index(pph_rules_t *rules, pph_uint8_t *storage);
+
+/**
+ * Get the monthly TER table for a category
+ * @param category TER category (A, B, or C); unknown values map to A
+ * @return Table (never NULL)
+ */
+const pph_ter_table_t* pph_ter_monthly_table(const pph_rules_t *rules,
+                                             pph21_ter_category_t category);
+
 /**
  * Get TER (Tarif Efektif Rata-rata) daily withholding rate
  * @param category TER category (A, B, or C)
@@ -4,12 +4,17 @@
  */
 
 #include <pph/pph_calculator.h>
-#include <stdio.h>
+#define PPH_MONEY_INLINE_NO_REDIRECT
+#include <pph/pph_money_inline.h>
 #include <stdlib.h>
 #include <string.h>
 
 /* ============================================
-   64-bit Multiplication Helper (Portable)
+   64-bit Multiplication Helpers
+
+   The full 64x64 -> 128-bit product uses the compiler's native 128-bit
+   type where there is one (GCC and Clang on 64-bit targets: one or two
+   multiply instructions), else four 32-bit partial products.
    ============================================ */
 
 typedef struct {
@@ -17,6 +22,26 @@ typedef struct {
     pph_uint64_t hi;
 } pph_uint128_t;
 
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 pph_native_uint128_t;
+    #define PPH_HAVE_INT128 1
+#endif
+
+#define PPH_INT64_MAX_U ((((pph_uint64_t)1) << 63) - 1)
+
+#if defined(PPH_HAVE_INT128)
+
+static pph_uint128_t pph_mul64x64(pph_uint64_t a, pph_uint64_t b) {
+    pph_native_uint128_t product = (pph_native_uint128_t)a * b;
+    pph_uint128_t result;
+
+    result.lo = (pph_uint64_t)product;
+    result.hi = (pph_uint64_t)(product >> 64);
+    return result;
+}
+
+#else
+
 /* Portable 64x64 -> 128-bit multiplication (works on 32-bit platforms) */
 static pph_uint128_t pph_mul64x64(pph_uint64_t a, pph_uint64_t b) {
     pph_uint64_t a_lo, a_hi, b_lo, b_hi;
@@ -45,6 +70,24 @@ static pph_uint128_t pph_mul64x64(pph_uint64_t a, pph_uint64_t b) {
     return result;
 }
 
+#endif
+
+/* 128-bit by 32-bit division in 32-bit steps: each step divides a value
+   below divisor * 2^32, which fits in 64 bits. Sets *overflow when the
+   quotient does not fit in 64 bits. */
+static pph_uint64_t pph_div128_small(pph_uint128_t n, pph_uint32_t divisor, int *overflow) {
+    pph_uint64_t rem, q1, q0;
+
+    *overflow = (n.hi >= divisor);
+
+    rem = n.hi % divisor;
+    q1 = ((rem << 32) | (n.lo >> 32)) / divisor;
+    rem = ((rem << 32) | (n.lo >> 32)) % divisor;
+    q0 = ((rem << 32) | (n.lo & 0xFFFFFFFFULL)) / divisor;
+
+    return (q1 << 32) | q0;
+}
+
 /* ============================================
    Basic Arithmetic Operations
    ============================================ */
@@ -72,26 +115,40 @@ pph_money_t pph_money_neg(pph_money_t a) {
    ============================================ */
 
 pph_money_t pph_money_mul(pph_money_t a, pph_money_t b) {
-    int negative;
-    pph_uint64_t abs_a, abs_b;
+    int negative, overflow;
+    pph_uint64_t abs_a, abs_b, limit;
     pph_uint128_t product;
     pph_uint64_t result_u64;
     pph_money_t result;
 
-    /* Handle sign */
+    /* Handle sign (unsigned negation is exact for the most negative value) */
     negative = (a.value < 0) ^ (b.value < 0);
-    abs_a = (a.value < 0) ? (pph_uint64_t)(-a.value) : (pph_uint64_t)a.value;
-    abs_b = (b.value < 0) ? (pph_uint64_t)(-b.value) : (pph_uint64_t)b.value;
+    abs_a = (a.value < 0) ? 0 - (pph_uint64_t)a.value : (pph_uint64_t)a.value;
+    abs_b = (b.value < 0) ? 0 - (pph_uint64_t)b.value : (pph_uint64_t)b.value;
 
     /* Multiply and scale down */
     product = pph_mul64x64(abs_a, abs_b);
 
-    /* Divide by scale factor (10000) */
-    /* Shift down by dividing: result = (hi * 2^64 + lo) / 10000 */
-    /* Simplified: assume product.hi is small enough */
-    result_u64 = (product.lo / PPH_SCALE_FACTOR);
+    /* Divide by scale factor (10000); the high word is zero for all but
+       very large amounts, and then the divide is a reciprocal multiply */
+    if (product.hi == 0) {
+        result_u64 = pph_udiv_1e4_inline(product.lo);
+        overflow = 0;
+    } else {
+        result_u64 = pph_div128_small(product, (pph_uint32_t)PPH_SCALE_FACTOR, &overflow);
+    }
+
+    /* Saturate instead of wrapping when the result is out of range */
+    limit = negative ? PPH_INT64_MAX_U + 1 : PPH_INT64_MAX_U;
+    if (overflow || result_u64 > limit) {
+        result_u64 = limit;
+    }
 
-    result.value = negative ? -(pph_int64_t)result_u64 : (pph_int64_t)result_u64;
+    if (!negative || result_u64 == 0) {
+        result.value = (pph_int64_t)result_u64;
+    } else {
+        result.value = -(pph_int64_t)(result_u64 - 1) - 1;
+    }
     return result;
 }
 
@@ -109,9 +166,114 @@ pph_money_t pph_money_percent(pph_money_t amount, pph_int64_t num, pph_int64_t d
 }
 
 pph_money_t pph_money_div(pph_money_t a, pph_int64_t divisor) {
-    pph_money_t result;
-    result.value = a.value / divisor;
-    return result;
+    return pph_money_div_inline(a, divisor);
+}
+
+/* ============================================
+   Checked Operations
+
+   Compilers with overflow builtins turn each check into the flag test
+   of the operation itself; elsewhere the operands are range-checked
+   first. On overflow *out is left untouched.
+   ============================================ */
+
+#if defined(__GNUC__) && __GNUC__ >= 5
+    #define PPH_HAVE_OVERFLOW_BUILTINS 1
+#elif defined(__has_builtin)
+    #if __has_builtin(__builtin_add_overflow)
+        #define PPH_HAVE_OVERFLOW_BUILTINS 1
+    #endif
+#endif
+
+#define PPH_INT64_MAX ((pph_int64_t)PPH_INT64_MAX_U)
+#define PPH_INT64_MIN (-PPH_INT64_MAX - 1)
+
+static int pph_add_overflows(pph_int64_t a, pph_int64_t b, pph_int64_t *sum) {
+#if defined(PPH_HAVE_OVERFLOW_BUILTINS)
+    return __builtin_add_overflow(a, b, sum);
+#else
+    if ((b > 0 && a > PPH_INT64_MAX - b) || (b < 0 && a < PPH_INT64_MIN - b)) {
+        return 1;
+    }
+    *sum = a + b;
+    return 0;
+#endif
+}
+
+static int pph_sub_overflows(pph_int64_t a, pph_int64_t b, pph_int64_t *diff) {
+#if defined(PPH_HAVE_OVERFLOW_BUILTINS)
+    return __builtin_sub_overflow(a, b, diff);
+#else
+    if ((b < 0 && a > PPH_INT64_MAX + b) || (b > 0 && a < PPH_INT64_MIN + b)) {
+        return 1;
+    }
+    *diff = a - b;
+    return 0;
+#endif
+}
+
+static int pph_mul_overflows(pph_int64_t a, pph_int64_t b, pph_int64_t *product) {
+#if defined(PPH_HAVE_OVERFLOW_BUILTINS)
+    return __builtin_mul_overflow(a, b, product);
+#else
+    if (a > 0) {
+        if ((b > 0 && a > PPH_INT64_MAX / b) || (b < 0 && b < PPH_INT64_MIN / a)) {
+            return 1;
+        }
+    } else if (a < 0) {
+        if ((b > 0 && a < PPH_INT64_MIN / b) || (b < 0 && b < PPH_INT64_MAX / a)) {
+            return 1;
+        }
+    }
+    *product = a * b;
+    return 0;
+#endif
+}
+
+pph_status_t pph_money_add_checked(pph_money_t a, pph_money_t b, pph_money_t *out) {
+    pph_int64_t value;
+
+    if (pph_add_overflows(a.value, b.value, &value)) {
+        return PPH_ERR_OVERFLOW;
+    }
+    out->value = value;
+    return PPH_OK;
+}
+
+pph_status_t pph_money_sub_checked(pph_money_t a, pph_money_t b, pph_money_t *out) {
+    pph_int64_t value;
+
+    if (pph_sub_overflows(a.value, b.value, &value)) {
+        return PPH_ERR_OVERFLOW;
+    }
+    out->value = value;
+    return PPH_OK;
+}
+
+pph_status_t pph_money_mul_int_checked(pph_money_t a, pph_int64_t scalar, pph_money_t *out) {
+    pph_int64_t value;
+
+    if (pph_mul_overflows(a.value, scalar, &value)) {
+        return PPH_ERR_OVERFLOW;
+    }
+    out->value = value;
+    return PPH_OK;
+}
+
+pph_status_t pph_money_percent_checked(pph_money_t amount, pph_int64_t num, pph_int64_t den,
+                                       pph_money_t *out) {
+    pph_int64_t product;
+
+    if (den == 0) {
+        return PPH_ERR_INVALID_INPUT;
+    }
+    /* The product must fit, as in pph_money_percent; so must MIN / -1 */
+    if (pph_mul_overflows(amount.value, num, &product) ||
+        (product == PPH_INT64_MIN && den == -1)) {
+        return PPH_ERR_OVERFLOW;
+    }
+    out->value = product / den;
+    return PPH_OK;
 }
 
 /* ============================================
@@ -137,18 +299,8 @@ pph_money_t pph_money_max(pph_money_t a, pph_money_t b) {
    ============================================ */
 
 pph_money_t pph_money_round_down_thousand(pph_money_t value) {
-    pph_money_t result;
-    pph_int64_t thousands;
-
-    if (value.value < 0) {
-        return PPH_ZERO;
-    } else {
-        /* Divide by 1000 (in internal units: 1000 * 10000 = 10000000) */
-        thousands = value.value / PPH_INT64_C(10000000);
-        result.value = thousands * PPH_INT64_C(10000000);
-    }
-
-    return result;
+    /* Negative values round to zero */
+    return pph_money_round_down_thousand_inline(value);
 }
 
 pph_money_t pph_money_floor(pph_money_t value) {
@@ -161,97 +313,158 @@ pph_money_t pph_money_floor(pph_money_t value) {
    String Conversion
    ============================================ */
 
-char* pph_money_to_string(pph_money_t money, char *buffer, pph_size_t size) {
-    pph_int64_t whole, frac;
-
-    if (buffer == NULL || size < 24) {
-        return NULL;
+/* "00" .. "99": two digits per division by 100 */
+static const char pph_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* Formats right to left ending at end and returns the first character.
+   thousands is 0 for no grouping. At most PPH_MONEY_FORMAT_MAX - 1 bytes. */
+static char* pph_format_backward(pph_money_t money, char thousands, char decimal, char *end) {
+    pph_uint64_t magnitude, whole, rest;
+    unsigned int frac, group;
+    char *p = end;
+
+    /* Unsigned negation is exact for the most negative value */
+    magnitude = (money.value < 0) ? (pph_uint64_t)0 - (pph_uint64_t)money.value
+                                  : (pph_uint64_t)money.value;
+    whole = pph_udiv_1e4_inline(magnitude);
+    frac = (unsigned int)(magnitude - whole * PPH_SCALE_FACTOR);
+
+    p -= 4;
+    memcpy(p, pph_digit_pairs + 2 * (frac / 100), 2);
+    memcpy(p + 2, pph_digit_pairs + 2 * (frac % 100), 2);
+    *--p = decimal;
+
+    while (whole >= 1000) {
+        rest = pph_udiv_1e3_inline(whole);
+        group = (unsigned int)(whole - rest * 1000);
+        whole = rest;
+        p -= 3;
+        p[0] = (char)('0' + group / 100);
+        memcpy(p + 1, pph_digit_pairs + 2 * (group % 100), 2);
+        if (thousands != '\0') {
+            *--p = thousands;
+        }
     }
 
-    whole = money.value / PPH_SCALE_FACTOR;
-    frac = money.value % PPH_SCALE_FACTOR;
-
-    if (frac < 0) {
-        frac = -frac;
+    group = (unsigned int)whole;
+    if (group >= 100) {
+        p -= 3;
+        p[0] = (char)('0' + group / 100);
+        memcpy(p + 1, pph_digit_pairs + 2 * (group % 100), 2);
+    } else if (group >= 10) {
+        p -= 2;
+        memcpy(p, pph_digit_pairs + 2 * group, 2);
+    } else {
+        *--p = (char)('0' + group);
     }
 
-    #if defined(__WATCOMC__) || defined(_MSC_VER)
-        snprintf(buffer, size, "%I64d.%04I64d", whole, frac);
-    #else
-        snprintf(buffer, size, "%lld.%04lld", (long long)whole, (long long)frac);
-    #endif
-
-    return buffer;
+    if (money.value < 0) {
+        *--p = '-';
+    }
+    return p;
 }
 
-char* pph_money_to_string_formatted(pph_money_t money, char *buffer, pph_size_t size) {
-    pph_int64_t whole, frac;
-    char temp[64];
-    char *p, *q;
-    int i, len, count;
-    int negative;
-
-    if (buffer == NULL || size < 32) {
-        return NULL;
+static void pph_format_separators(pph_money_format_t style, char *thousands, char *decimal) {
+    switch (style) {
+        case PPH_MONEY_FORMAT_ID:
+            *thousands = '.';
+            *decimal = ',';
+            break;
+        case PPH_MONEY_FORMAT_EN:
+            *thousands = ',';
+            *decimal = '.';
+            break;
+        case PPH_MONEY_FORMAT_PLAIN:
+        default:
+            *thousands = '\0';
+            *decimal = '.';
+            break;
     }
+}
 
-    whole = money.value / PPH_SCALE_FACTOR;
-    frac = money.value % PPH_SCALE_FACTOR;
+pph_size_t pph_money_format(pph_money_t money, pph_money_format_t style,
+                            char *buffer, pph_size_t size) {
+    char temp[PPH_MONEY_FORMAT_MAX];
+    char thousands, decimal;
+    char *start;
+    pph_size_t len;
 
-    negative = (whole < 0);
-    if (negative) {
-        whole = -whole;
+    if (buffer == NULL) {
+        return 0;
     }
-    if (frac < 0) {
-        frac = -frac;
+
+    pph_format_separators(style, &thousands, &decimal);
+    start = pph_format_backward(money, thousands, decimal, temp + sizeof(temp));
+    len = (pph_size_t)(temp + sizeof(temp) - start);
+    if (len >= size) {
+        return 0;
     }
 
-    /* Format whole part with thousands separator */
-    #if defined(__WATCOMC__) || defined(_MSC_VER)
-        snprintf(temp, sizeof(temp), "%I64d", whole);
-    #else
-        snprintf(temp, sizeof(temp), "%lld", (long long)whole);
-    #endif
+    memcpy(buffer, start, len);
+    buffer[len] = '\0';
+    return len;
+}
 
-    len = (int)strlen(temp);
-    p = temp + len - 1;
-    q = buffer;
+pph_size_t pph_money_format_column(const pph_money_t *values, pph_size_t count,
+                                   pph_money_format_t style, char terminator,
+                                   char *buffer, pph_size_t size, pph_size_t *written) {
+    char temp[PPH_MONEY_FORMAT_MAX];
+    char thousands, decimal;
+    char *start;
+    pph_size_t i, len, used = 0;
 
-    if (negative) {
-        *q++ = '-';
+    if (written != NULL) {
+        *written = 0;
+    }
+    if (values == NULL || buffer == NULL) {
+        return 0;
     }
 
-    count = 0;
-    for (i = len - 1; i >= 0; i--) {
-        if (count == 3) {
-            *q++ = ',';
-            count = 0;
-        }
-        *q++ = *p--;
-        count++;
-    }
-
-    /* Reverse the digits */
-    {
-        char *start = negative ? buffer + 1 : buffer;
-        char *end = q - 1;
-        char tmp_char;
-        while (start < end) {
-            tmp_char = *start;
-            *start = *end;
-            *end = tmp_char;
-            start++;
-            end--;
+    /* Each value is built at the end of temp with its terminator, then
+       copied once; stop at the first value that does not fit whole */
+    pph_format_separators(style, &thousands, &decimal);
+    temp[sizeof(temp) - 1] = terminator;
+    for (i = 0; i < count; i++) {
+        start = pph_format_backward(values[i], thousands, decimal, temp + sizeof(temp) - 1);
+        len = (pph_size_t)(temp + sizeof(temp) - start);
+        if (len > size - used) {
+            break;
         }
+        memcpy(buffer + used, start, len);
+        used += len;
     }
 
-    /* Add decimal part */
-    #if defined(__WATCOMC__) || defined(_MSC_VER)
-        snprintf(q, size - (pph_size_t)(q - buffer), ".%04I64d", frac);
-    #else
-        snprintf(q, size - (pph_size_t)(q - buffer), ".%04lld", (long long)frac);
-    #endif
+    if (written != NULL) {
+        *written = used;
+    }
+    return i;
+}
+
+char* pph_money_to_string(pph_money_t money, char *buffer, pph_size_t size) {
+    if (buffer == NULL || size < 24) {
+        return NULL;
+    }
 
+    pph_money_format(money, PPH_MONEY_FORMAT_PLAIN, buffer, size);
+    return buffer;
+}
+
+char* pph_money_to_string_formatted(pph_money_t money, char *buffer, pph_size_t size) {
+    if (buffer == NULL || size < 32) {
+        return NULL;
+    }
+
+    pph_money_format(money, PPH_MONEY_FORMAT_EN, buffer, size);
     return buffer;
 }
 
@@ -269,11 +482,23 @@ char* pph_percent_to_string(pph_money_t percent, char *buffer, pph_size_t size)
     return NULL;
 }
 
+/* Parsers take an explicit length so they can read straight out of
+   mapped files and other buffers without a NUL terminator; the
+   NUL-terminated forms are thin wrappers. */
+
 pph_money_t pph_money_from_string(const char *str) {
+    if (str == NULL) {
+        return PPH_ZERO;
+    }
+    return pph_money_from_string_n(str, strlen(str));
+}
+
+pph_money_t pph_money_from_string_n(const char *str, pph_size_t len) {
     pph_money_t result;
     pph_int64_t whole = 0, frac = 0;
     int negative = 0;
     const char *p = str;
+    const char *end = str + len;
 
     result = PPH_ZERO;
 
@@ -282,29 +507,29 @@ pph_money_t pph_money_from_string(const char *str) {
     }
 
     /* Skip whitespace */
-    while (*p == ' ' || *p == '\t') {
+    while (p < end && (*p == ' ' || *p == '\t')) {
         p++;
     }
 
     /* Check sign */
-    if (*p == '-') {
+    if (p < end && *p == '-') {
         negative = 1;
         p++;
-    } else if (*p == '+') {
+    } else if (p < end && *p == '+') {
         p++;
     }
 
     /* Parse whole part */
-    while (*p >= '0' && *p <= '9') {
+    while (p < end && *p >= '0' && *p <= '9') {
         whole = whole * 10 + (*p - '0');
         p++;
     }
 
     /* Parse decimal part */
-    if (*p == '.') {
+    if (p < end && *p == '.') {
         int count = 0;
         p++;
-        while (*p >= '0' && *p <= '9' && count < 4) {
+        while (p < end && *p >= '0' && *p <= '9' && count < 4) {
             frac = frac * 10 + (*p - '0');
             p++;
             count++;
@@ -325,10 +550,18 @@ pph_money_t pph_money_from_string(const char *str) {
 }
 
 pph_money_t pph_money_from_string_id(const char *str) {
+    if (str == NULL) {
+        return PPH_ZERO;
+    }
+    return pph_money_from_string_id_n(str, strlen(str));
+}
+
+pph_money_t pph_money_from_string_id_n(const char *str, pph_size_t len) {
     pph_money_t result;
     pph_int64_t whole = 0, frac = 0;
     int negative = 0;
     const char *p = str;
+    const char *end = str + len;
 
     result = PPH_ZERO;
 
@@ -337,20 +570,20 @@ pph_money_t pph_money_from_string_id(const char *str) {
     }
 
     /* Skip whitespace */
-    while (*p == ' ' || *p == '\t') {
+    while (p < end && (*p == ' ' || *p == '\t')) {
         p++;
     }
 
     /* Check sign */
-    if (*p == '-') {
+    if (p < end && *p == '-') {
         negative = 1;
         p++;
-    } else if (*p == '+') {
+    } else if (p < end && *p == '+') {
         p++;
     }
 
     /* Parse whole part, skip thousands separators (dots) */
-    while (*p != '\0') {
+    while (p < end && *p != '\0') {
         if (*p >= '0' && *p <= '9') {
             whole = whole * 10 + (*p - '0');
             p++;
@@ -367,10 +600,10 @@ pph_money_t pph_money_from_string_id(const char *str) {
     }
 
     /* Parse decimal part (after comma) */
-    if (*p == ',') {
+    if (p < end && *p == ',') {
         int count = 0;
         p++;
-        while (*p >= '0' && *p <= '9' && count < 4) {
+        while (p < end && *p >= '0' && *p <= '9' && count < 4) {
             frac = frac * 10 + (*p - '0');
             p++;
             count++;
@@ -0,0 +1,281 @@
+/*
+ * PPH Money Arrays - Money primitives over arrays of values
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#include <pph/pph_calculator.h>
+#include "pph_internal.h"
+
+/* x86 SIMD paths are compiled per function and selected at run time, so
+   the library itself does not need to be built with -mavx2. Advanced SIMD
+   is part of the AArch64 base architecture, so NEON needs no check. */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__)) && !defined(__EMSCRIPTEN__)
+    #define PPH_ARRAY_X86 1
+    #include <immintrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+    #define PPH_ARRAY_NEON 1
+    #include <arm_neon.h>
+#endif
+
+/* ============================================
+   Operations
+
+   Every operation is out = trunc(value * k / d) with d > 0, optionally
+   clamped at zero and scaled back by d. The vector paths work in double
+   precision, which is exact while |value * k| < 2^51: the quotient is
+   estimated, truncated and corrected by one using the exact remainder.
+   Elements past that bound take the scalar path, which matches the
+   single-value functions for every input.
+   ============================================ */
+
+#define ARRAY_EXACT_LIMIT ((PPH_INT64_C(1) << 51) - 1)
+
+typedef enum {
+    ARRAY_MUL = 0,
+    ARRAY_PERCENT,
+    ARRAY_ROUND_DOWN_THOUSAND
+} array_kind_t;
+
+typedef struct {
+    array_kind_t kind;
+    pph_int64_t k;          /* Multiplier */
+    pph_int64_t d;          /* Divisor, > 0 */
+    pph_int64_t limit;      /* Largest |value| for the vector path, -1 for none */
+    pph_money_t rate;       /* ARRAY_MUL */
+    pph_int64_t num, den;   /* ARRAY_PERCENT, as given */
+} array_op_t;
+
+typedef void (*array_kernel_fn)(const array_op_t *op, const pph_int64_t *values,
+                                pph_int64_t *out, pph_size_t count);
+
+static pph_int64_t abs64_or_max(pph_int64_t x) {
+    return (x >= 0) ? x : (x == -PPH_INT64_C(0x7FFFFFFFFFFFFFFF) - 1) ? PPH_INT64_C(0x7FFFFFFFFFFFFFFF) : -x;
+}
+
+static void array_op_finish(array_op_t *op) {
+    pph_int64_t k = abs64_or_max(op->k);
+
+    if (op->d <= 0 || op->d > ARRAY_EXACT_LIMIT || k > ARRAY_EXACT_LIMIT) {
+        op->limit = -1;
+    } else {
+        op->limit = (k == 0) ? ARRAY_EXACT_LIMIT : ARRAY_EXACT_LIMIT / k;
+    }
+}
+
+static pph_int64_t array_element(const array_op_t *op, pph_int64_t value) {
+    pph_money_t money;
+
+    switch (op->kind) {
+        case ARRAY_MUL:
+            money.value = value;
+            return pph_money_mul(money, op->rate).value;
+        case ARRAY_PERCENT:
+            return (value * op->num) / op->den;
+        case ARRAY_ROUND_DOWN_THOUSAND:
+        default:
+            money.value = value;
+            return pph_money_round_down_thousand_inline(money).value;
+    }
+}
+
+static void array_kernel_scalar(const array_op_t *op, const pph_int64_t *values,
+                                pph_int64_t *out, pph_size_t count) {
+    pph_size_t i;
+
+    for (i = 0; i < count; i++) {
+        out[i] = array_element(op, values[i]);
+    }
+}
+
+#if defined(PPH_ARRAY_X86)
+
+/* 1.5 * 2^52: adding it to a double in (-2^51, 2^51) leaves the integer
+   part in the low mantissa bits, which converts to and from int64 */
+#define ARRAY_MAGIC 6755399441055744.0
+
+__attribute__((target("avx2")))
+static void array_kernel_avx2(const array_op_t *op, const pph_int64_t *values,
+                              pph_int64_t *out, pph_size_t count) {
+    const __m256d magic = _mm256_set1_pd(ARRAY_MAGIC);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d k = _mm256_set1_pd((double)op->k);
+    const __m256d d = _mm256_set1_pd((double)op->d);
+    const __m256d inv = _mm256_set1_pd(1.0 / (double)op->d);
+    const __m256i hi = _mm256_set1_epi64x(op->limit);
+    const __m256i lo = _mm256_set1_epi64x(-op->limit);
+    pph_size_t i = 0;
+
+    for (; op->limit >= 0 && i + 4 <= count; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        __m256d p, a, n, rem;
+
+        if (!_mm256_testz_si256(_mm256_or_si256(_mm256_cmpgt_epi64(x, hi),
+                                                _mm256_cmpgt_epi64(lo, x)),
+                                _mm256_set1_epi64x(-1))) {
+            array_kernel_scalar(op, values + i, out + i, 4);
+            continue;
+        }
+        if (op->kind == ARRAY_ROUND_DOWN_THOUSAND) {
+            x = _mm256_andnot_si256(_mm256_cmpgt_epi64(_mm256_setzero_si256(), x), x);
+        }
+
+        p = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(x, _mm256_castpd_si256(magic))),
+                          magic);
+        p = _mm256_mul_pd(p, k);
+        a = _mm256_andnot_pd(sign, p);
+
+        /* Estimate, then correct by one using the exact remainder */
+        n = _mm256_round_pd(_mm256_mul_pd(a, inv), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        rem = _mm256_sub_pd(a, _mm256_mul_pd(n, d));
+        n = _mm256_sub_pd(n, _mm256_and_pd(_mm256_cmp_pd(rem, zero, _CMP_LT_OQ), one));
+        n = _mm256_add_pd(n, _mm256_and_pd(_mm256_cmp_pd(rem, d, _CMP_GE_OQ), one));
+
+        if (op->kind == ARRAY_ROUND_DOWN_THOUSAND) {
+            n = _mm256_mul_pd(n, d);
+        }
+        n = _mm256_or_pd(n, _mm256_and_pd(p, sign));
+
+        _mm256_storeu_si256((__m256i*)(out + i),
+                            _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(n, magic)),
+                                             _mm256_castpd_si256(magic)));
+    }
+
+    array_kernel_scalar(op, values + i, out + i, count - i);
+}
+
+#endif /* PPH_ARRAY_X86 */
+
+#if defined(PPH_ARRAY_NEON)
+
+static void array_kernel_neon(const array_op_t *op, const pph_int64_t *values,
+                              pph_int64_t *out, pph_size_t count) {
+    const float64x2_t one = vdupq_n_f64(1.0);
+    const float64x2_t zero = vdupq_n_f64(0.0);
+    const float64x2_t k = vdupq_n_f64((double)op->k);
+    const float64x2_t d = vdupq_n_f64((double)op->d);
+    const float64x2_t inv = vdupq_n_f64(1.0 / (double)op->d);
+    const int64x2_t limit = vdupq_n_s64(op->limit);
+    pph_size_t i = 0;
+
+    for (; op->limit >= 0 && i + 2 <= count; i += 2) {
+        int64x2_t x = vld1q_s64(values + i);
+        float64x2_t p, a, n, rem;
+
+        /* Saturating abs keeps INT64_MIN above the limit */
+        if (vminvq_u32(vreinterpretq_u32_u64(vcleq_s64(vqabsq_s64(x), limit))) == 0) {
+            array_kernel_scalar(op, values + i, out + i, 2);
+            continue;
+        }
+        if (op->kind == ARRAY_ROUND_DOWN_THOUSAND) {
+            x = vmaxq_s64(x, vdupq_n_s64(0));
+        }
+
+        p = vmulq_f64(vcvtq_f64_s64(x), k);
+        a = vabsq_f64(p);
+
+        n = vrndq_f64(vmulq_f64(a, inv));
+        rem = vsubq_f64(a, vmulq_f64(n, d));
+        n = vbslq_f64(vcltq_f64(rem, zero), vsubq_f64(n, one), n);
+        n = vbslq_f64(vcgeq_f64(rem, d), vaddq_f64(n, one), n);
+
+        if (op->kind == ARRAY_ROUND_DOWN_THOUSAND) {
+            n = vmulq_f64(n, d);
+        }
+        n = vbslq_f64(vcltq_f64(p, zero), vnegq_f64(n), n);
+
+        vst1q_s64(out + i, vcvtq_s64_f64(n));
+    }
+
+    array_kernel_scalar(op, values + i, out + i, count - i);
+}
+
+#endif /* PPH_ARRAY_NEON */
+
+static array_kernel_fn select_array_kernel(void) {
+#if defined(PPH_ARRAY_X86)
+    if (__builtin_cpu_supports("avx2")) {
+        return array_kernel_avx2;
+    }
+#elif defined(PPH_ARRAY_NEON)
+    return array_kernel_neon;
+#endif
+    return array_kernel_scalar;
+}
+
+static pph_status_t array_run(const array_op_t *op, const pph_money_t *values,
+                              pph_money_t *out, pph_size_t count) {
+    if (count == 0) {
+        return PPH_OK;
+    }
+    if (values == NULL || out == NULL) {
+        pph_set_last_error("Input is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+
+    /* pph_money_t is a lone int64, so the arrays are plain int64 columns */
+    select_array_kernel()(op, &values[0].value, &out[0].value, count);
+    return PPH_OK;
+}
+
+/* ============================================
+   Public Entry Points
+   ============================================ */
+
+pph_status_t pph_money_mul_array(const pph_money_t *values, pph_money_t rate,
+                                 pph_money_t *out, pph_size_t count) {
+    array_op_t op;
+
+    op.kind = ARRAY_MUL;
+    op.k = rate.value;
+    op.d = PPH_SCALE_FACTOR;
+    op.rate = rate;
+    op.num = op.den = 0;
+    array_op_finish(&op);
+    return array_run(&op, values, out, count);
+}
+
+pph_status_t pph_money_percent_array(const pph_money_t *values, pph_int64_t num, pph_int64_t den,
+                                     pph_money_t *out, pph_size_t count) {
+    array_op_t op;
+
+    if (den == 0) {
+        pph_set_last_error("Division by zero");
+        return PPH_ERR_INVALID_INPUT;
+    }
+
+    /* A negative divisor moves its sign to the multiplier, which has no
+       positive form when either operand is INT64_MIN */
+    if (den < 0 && (num == -PPH_INT64_C(0x7FFFFFFFFFFFFFFF) - 1 ||
+                    den == -PPH_INT64_C(0x7FFFFFFFFFFFFFFF) - 1)) {
+        pph_set_last_error("Percentage operand out of range");
+        return PPH_ERR_INVALID_INPUT;
+    }
+
+    op.kind = ARRAY_PERCENT;
+    op.k = (den < 0) ? -num : num;
+    op.d = (den < 0) ? -den : den;
+    op.rate = PPH_ZERO;
+    op.num = num;
+    op.den = den;
+    array_op_finish(&op);
+    if (num == -PPH_INT64_C(0x7FFFFFFFFFFFFFFF) - 1) {
+        op.limit = -1;
+    }
+    return array_run(&op, values, out, count);
+}
+
+pph_status_t pph_money_round_down_thousand_array(const pph_money_t *values, pph_money_t *out,
+                                                 pph_size_t count) {
+    array_op_t op;
+
+    op.kind = ARRAY_ROUND_DOWN_THOUSAND;
+    op.k = 1;
+    op.d = PPH_INT64_C(10000000);
+    op.rate = PPH_ZERO;
+    op.num = op.den = 0;
+    array_op_finish(&op);
+    return array_run(&op, values, out, count);
+}
@@ -0,0 +1,330 @@
+/*
+ * PPH Money Parser - Validating, length-bounded amount parser
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#include <pph/pph_calculator.h>
+#include "pph_internal.h"
+
+/* As in the column kernels: x86 paths are compiled per function and
+   selected at run time; AArch64 always has NEON. */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__)) && !defined(__EMSCRIPTEN__)
+    #define PPH_PARSE_X86 1
+    #include <immintrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+    #define PPH_PARSE_NEON 1
+    #include <arm_neon.h>
+#endif
+
+/* Largest whole part that still fits pph_money_t */
+#define PARSE_WHOLE_MAX PPH_UINT64_C(922337203685477)
+
+static const pph_uint64_t pow10_table[17] = {
+    PPH_UINT64_C(1), PPH_UINT64_C(10), PPH_UINT64_C(100), PPH_UINT64_C(1000),
+    PPH_UINT64_C(10000), PPH_UINT64_C(100000), PPH_UINT64_C(1000000),
+    PPH_UINT64_C(10000000), PPH_UINT64_C(100000000), PPH_UINT64_C(1000000000),
+    PPH_UINT64_C(10000000000), PPH_UINT64_C(100000000000),
+    PPH_UINT64_C(1000000000000), PPH_UINT64_C(10000000000000),
+    PPH_UINT64_C(100000000000000), PPH_UINT64_C(1000000000000000),
+    PPH_UINT64_C(10000000000000000)
+};
+
+/* ============================================
+   16-Byte Scanners
+
+   A scanner looks at exactly 16 bytes and returns the length of the
+   leading run of digits and group separators. It stores the value of the
+   run's digits (separators removed), their count and a bitmask of the
+   separator positions; the caller validates the grouping.
+   ============================================ */
+
+typedef int (*scan16_fn)(const char *p, char group, pph_uint64_t *value,
+                         int *digits, unsigned int *seps);
+
+#if defined(PPH_PARSE_X86) || defined(PPH_PARSE_NEON)
+
+/* Shuffle indices that move the first n bytes to the end of the vector:
+   loaded from offset n, the first 16 - n lanes select zero */
+static const unsigned char align_table[32] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+};
+
+static const unsigned char lane_index[16] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+};
+
+#endif
+
+#if defined(PPH_PARSE_X86)
+
+__attribute__((target("sse4.2")))
+static int scan16_sse(const char *p, char group, pph_uint64_t *value,
+                      int *digits, unsigned int *seps) {
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i index = _mm_loadu_si128((const __m128i*)lane_index);
+    __m128i x = _mm_loadu_si128((const __m128i*)p);
+    __m128i v = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(v, nine), v);
+    __m128i is_sep = (group != '\0') ? _mm_cmpeq_epi8(x, _mm_set1_epi8(group))
+                                     : _mm_setzero_si128();
+    unsigned int dmask = (unsigned int)_mm_movemask_epi8(is_digit);
+    unsigned int smask = (unsigned int)_mm_movemask_epi8(is_sep);
+    unsigned int rest;
+    int run, n, q;
+
+    run = __builtin_ctz((~(dmask | smask) & 0xFFFFu) | 0x10000u);
+    smask &= (1u << run) - 1;
+    n = run - __builtin_popcount(smask);
+
+    /* Drop separators from the highest down so lower positions hold */
+    for (rest = smask; rest != 0; rest &= ~(1u << q)) {
+        q = 31 - __builtin_clz(rest);
+        v = _mm_blendv_epi8(v, _mm_srli_si128(v, 1),
+                            _mm_cmpgt_epi8(index, _mm_set1_epi8((char)(q - 1))));
+    }
+
+    /* Right-align the n digits, then 16 digits -> two 8-digit halves */
+    v = _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i*)(align_table + n)));
+    v = _mm_maddubs_epi16(v, _mm_set1_epi16(0x010A));
+    v = _mm_madd_epi16(v, _mm_set1_epi32(0x00010064));
+    v = _mm_packus_epi32(v, v);
+    v = _mm_madd_epi16(v, _mm_set1_epi32(0x00012710));
+
+    *value = (pph_uint64_t)(pph_uint32_t)_mm_cvtsi128_si32(v) * PPH_UINT64_C(100000000) +
+             (pph_uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(v, 4));
+    *digits = n;
+    *seps = smask;
+    return run;
+}
+
+#endif /* PPH_PARSE_X86 */
+
+#if defined(PPH_PARSE_NEON)
+
+static const unsigned char lane_bit[16] = {
+    1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+};
+
+static unsigned int neon_movemask(uint8x16_t mask) {
+    uint8x16_t bits = vandq_u8(mask, vld1q_u8(lane_bit));
+    return (unsigned int)vaddv_u8(vget_low_u8(bits)) |
+           ((unsigned int)vaddv_u8(vget_high_u8(bits)) << 8);
+}
+
+static int scan16_neon(const char *p, char group, pph_uint64_t *value,
+                       int *digits, unsigned int *seps) {
+    static const unsigned char w10[16] = { 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1 };
+    static const unsigned short w100[8] = { 100, 1, 100, 1, 100, 1, 100, 1 };
+    static const unsigned int w10000[4] = { 10000, 1, 10000, 1 };
+    const uint8x16_t index = vld1q_u8(lane_index);
+    uint8x16_t x = vld1q_u8((const unsigned char*)p);
+    uint8x16_t v = vsubq_u8(x, vdupq_n_u8('0'));
+    unsigned int dmask = neon_movemask(vcleq_u8(v, vdupq_n_u8(9)));
+    unsigned int smask = (group != '\0')
+                       ? neon_movemask(vceqq_u8(x, vdupq_n_u8((unsigned char)group))) : 0;
+    unsigned int rest;
+    uint16x8_t pairs;
+    uint32x4_t quads;
+    uint64x2_t halves;
+    int run, n, q;
+
+    run = __builtin_ctz((~(dmask | smask) & 0xFFFFu) | 0x10000u);
+    smask &= (1u << run) - 1;
+    n = run - __builtin_popcount(smask);
+
+    for (rest = smask; rest != 0; rest &= ~(1u << q)) {
+        q = 31 - __builtin_clz(rest);
+        v = vbslq_u8(vcgeq_u8(index, vdupq_n_u8((unsigned char)q)),
+                     vextq_u8(v, vdupq_n_u8(0), 1), v);
+    }
+
+    /* Out-of-range table indices select zero */
+    v = vqtbl1q_u8(v, vld1q_u8(align_table + n));
+    pairs = vpaddlq_u8(vmulq_u8(v, vld1q_u8(w10)));
+    quads = vpaddlq_u16(vmulq_u16(pairs, vld1q_u16(w100)));
+    halves = vpaddlq_u32(vmulq_u32(quads, vld1q_u32(w10000)));
+
+    *value = vgetq_lane_u64(halves, 0) * PPH_UINT64_C(100000000) + vgetq_lane_u64(halves, 1);
+    *digits = n;
+    *seps = smask;
+    return run;
+}
+
+#endif /* PPH_PARSE_NEON */
+
+static scan16_fn select_scan16(void) {
+#if defined(PPH_PARSE_X86)
+    if (__builtin_cpu_supports("sse4.2")) {
+        return scan16_sse;
+    }
+#elif defined(PPH_PARSE_NEON)
+    return scan16_neon;
+#endif
+    return NULL;
+}
+
+/* ============================================
+   Parser
+   ============================================ */
+
+typedef struct {
+    int digits;         /* Whole digits so far */
+    int since_sep;      /* Digits since the last group separator */
+    int grouped;        /* A group separator has been seen */
+} parse_groups_t;
+
+/* Groups after the first separator hold exactly three digits, the
+   leading group one to three */
+static int accept_separator(parse_groups_t *g) {
+    if (g->digits == 0 || (g->grouped ? g->since_sep != 3 : g->since_sep > 3)) {
+        return -1;
+    }
+    g->since_sep = 0;
+    g->grouped = 1;
+    return 0;
+}
+
+static int is_blank_char(char c) {
+    return c == ' ' || c == '\t';
+}
+
+pph_status_t pph_money_parse(const char *str, pph_size_t len, pph_money_format_t style,
+                             pph_money_t *out, pph_size_t *consumed) {
+    const char *p = str;
+    const char *end;
+    char group, decimal;
+    scan16_fn scan16 = select_scan16();
+    parse_groups_t groups, saved;
+    pph_uint64_t whole = 0, frac = 0, chunk, magnitude;
+    unsigned int seps;
+    int negative = 0, frac_digits = 0;
+    int run, n, q, prev, bad;
+    pph_status_t status = PPH_OK;
+
+    if (consumed != NULL) {
+        *consumed = 0;
+    }
+    if (str == NULL || out == NULL) {
+        return PPH_ERR_NULL_INPUT;
+    }
+    out->value = 0;
+    end = str + len;
+
+    switch (style) {
+        case PPH_MONEY_FORMAT_EN: group = ','; decimal = '.'; break;
+        case PPH_MONEY_FORMAT_ID: group = '.'; decimal = ','; break;
+        default:                  group = '\0'; decimal = '.'; break;
+    }
+
+    while (p < end && is_blank_char(*p)) {
+        p++;
+    }
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    /* Whole part: 16 bytes per step while they last, then bytewise */
+    groups.digits = groups.since_sep = groups.grouped = 0;
+    while (status == PPH_OK) {
+        if (scan16 != NULL && end - p >= 16) {
+            run = scan16(p, group, &chunk, &n, &seps);
+            saved = groups;
+            bad = 0;
+
+            for (prev = -1, q = 0; q < run && !bad; q++) {
+                if ((seps & (1u << q)) != 0) {
+                    groups.digits += q - prev - 1;
+                    groups.since_sep += q - prev - 1;
+                    bad = accept_separator(&groups);
+                    prev = q;
+                }
+            }
+            groups.digits += run - prev - 1;
+            groups.since_sep += run - prev - 1;
+
+            if (!bad && n > 0) {
+                bad = (chunk > PARSE_WHOLE_MAX ||
+                       whole > (PARSE_WHOLE_MAX - chunk) / pow10_table[n]);
+            }
+            if (bad) {
+                /* Rescan bytewise to report the exact error and offset */
+                groups = saved;
+                scan16 = NULL;
+                continue;
+            }
+
+            if (n > 0) {
+                whole = whole * pow10_table[n] + chunk;
+            }
+            p += run;
+            if (run < 16) {
+                break;
+            }
+        } else if (p < end && *p >= '0' && *p <= '9') {
+            if (whole > (PARSE_WHOLE_MAX - (pph_uint64_t)(*p - '0')) / 10) {
+                status = PPH_ERR_OVERFLOW;
+                break;
+            }
+            whole = whole * 10 + (pph_uint64_t)(*p - '0');
+            groups.digits++;
+            groups.since_sep++;
+            p++;
+        } else if (p < end && group != '\0' && *p == group) {
+            if (accept_separator(&groups) != 0) {
+                status = PPH_ERR_SYNTAX;
+                break;
+            }
+            p++;
+        } else {
+            break;
+        }
+    }
+
+    if (status == PPH_OK && (groups.digits == 0 || (groups.grouped && groups.since_sep != 3))) {
+        status = PPH_ERR_SYNTAX;
+    }
+
+    /* Up to four decimals; more would be silently rounded, so refuse */
+    if (status == PPH_OK && p < end && *p == decimal) {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (frac_digits == PPH_DECIMAL_PLACES) {
+                status = PPH_ERR_SYNTAX;
+                break;
+            }
+            frac = frac * 10 + (pph_uint64_t)(*p - '0');
+            frac_digits++;
+            p++;
+        }
+        if (status == PPH_OK && frac_digits == 0) {
+            status = PPH_ERR_SYNTAX;
+        }
+        frac *= pow10_table[PPH_DECIMAL_PLACES - frac_digits];
+    }
+
+    if (status == PPH_OK) {
+        magnitude = whole * (pph_uint64_t)PPH_SCALE_FACTOR + frac;
+        if (magnitude > PPH_UINT64_C(0x7FFFFFFFFFFFFFFF) + (pph_uint64_t)negative) {
+            status = PPH_ERR_OVERFLOW;
+        } else if (negative && magnitude != 0) {
+            out->value = -(pph_int64_t)(magnitude - 1) - 1;
+        } else {
+            out->value = (pph_int64_t)magnitude;
+        }
+    }
+
+    if (status == PPH_OK) {
+        while (p < end && is_blank_char(*p)) {
+            p++;
+        }
+    }
+
+    if (consumed != NULL) {
+        *consumed = (pph_size_t)(p - str);
+    }
+    return status;
+}
@@ -0,0 +1,821 @@
+/*
+ * PPH Ruleset - Tax tables loaded at run time
+ * Copyright (c) 2025 OpenPajak Contributors
+ *
+ * A ruleset file is a header, a section directory and the sections, each
+ * section starting on an 8-byte boundary:
+ *
+ *   header        ruleset_header_t (64 bytes)
+ *   directory     ruleset_section_t[section_count]
+ *   PTKP          pph_uint32_t[8]          thousands of rupiah, by status
+ *   PASAL17       {start, base_tax, rate}  pph_int64_t each, count brackets
+ *   TER_MONTHLY   ceilings, then rates     one section per category
+ *   TER_DAILY     ceilings, then rates     one section per category
+ *
+ * A TER section holds pph_uint32_t ceilings[PPH_TER_PADDED(count)] in
+ * thousands of rupiah, padded with PPH_TER_CEILING_PAD, followed by
+ * pph_uint16_t rates[count] in basis points. The tables are used in place,
+ * so the file stays mapped for the life of the ruleset. Values are in the
+ * byte order of the machine that wrote the file; a file from the other
+ * byte order is rejected.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    /* mmap() is hidden in strict C90 mode */
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <pph/pph_calculator.h>
+#include "pph_internal.h"
+#include "pph_thread.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #define RULESET_MAP_WIN32 1
+#elif defined(__unix__) || defined(__unix) || defined(__APPLE__)
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define RULESET_MAP_POSIX 1
+#endif
+
+#define RULESET_MAGIC "PPHR"
+#define RULESET_VERSION 1
+#define RULESET_BYTE_ORDER 0x01020304UL
+#define RULESET_LABEL_SIZE 32
+#define RULESET_MAX_SECTIONS 16
+#define RULESET_MAX_BRACKETS 16
+
+#define RULESET_PTKP 0x01
+#define RULESET_PASAL17 0x02
+#define RULESET_TER_MONTHLY 0x10  /* | pph21_ter_category_t */
+#define RULESET_TER_DAILY 0x20
+
+typedef struct {
+    char magic[4];
+    pph_uint16_t version;
+    pph_uint16_t header_size;
+    pph_uint32_t byte_order;
+    pph_uint32_t section_count;
+    pph_uint64_t file_size;
+    char label[RULESET_LABEL_SIZE];
+    pph_uint64_t reserved;
+} ruleset_header_t;
+
+typedef struct {
+    pph_uint32_t kind;
+    pph_uint32_t count;
+    pph_uint64_t offset;
+} ruleset_section_t;
+
+struct pph_ruleset {
+    pph_rules_t rules;
+    char label[RULESET_LABEL_SIZE + 1];
+    const char *data;
+    pph_size_t size;
+    void *handle;                     /* Win32 mapping handle */
+    int mapped;                       /* Else data is a pph_malloc() copy */
+    long retire_epoch;
+    struct pph_ruleset *next;         /* Retired list */
+    pph_uint8_t index[PPH_TER_INDEX_BYTES];
+};
+
+/* ============================================
+   File Mapping
+   ============================================ */
+
+static int read_whole_file(const char *path, pph_ruleset_t *ruleset) {
+    FILE *file = fopen(path, "rb");
+    char *data;
+    long size;
+
+    if (file == NULL) {
+        return -1;
+    }
+    if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) <= 0 ||
+        fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return -1;
+    }
+
+    data = (char*)pph_malloc((pph_size_t)size);
+    if (data == NULL || fread(data, 1, (pph_size_t)size, file) != (pph_size_t)size) {
+        pph_free(data);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+
+    ruleset->data = data;
+    ruleset->size = (pph_size_t)size;
+    ruleset->mapped = 0;
+    return 0;
+}
+
+#if defined(RULESET_MAP_POSIX)
+
+static int map_ruleset_file(const char *path, pph_ruleset_t *ruleset) {
+    struct stat st;
+    void *data;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (pph_uint64_t)st.st_size > (pph_uint64_t)(~(pph_size_t)0)) {
+        close(fd);
+        return -1;
+    }
+
+    data = mmap(NULL, (pph_size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        /* Some file systems cannot be mapped */
+        return read_whole_file(path, ruleset);
+    }
+
+    ruleset->data = (const char*)data;
+    ruleset->size = (pph_size_t)st.st_size;
+    ruleset->mapped = 1;
+    return 0;
+}
+
+static void unmap_ruleset_file(pph_ruleset_t *ruleset) {
+    munmap((void*)ruleset->data, ruleset->size);
+}
+
+#elif defined(RULESET_MAP_WIN32)
+
+static int map_ruleset_file(const char *path, pph_ruleset_t *ruleset) {
+    HANDLE handle, mapping;
+    LARGE_INTEGER size;
+    void *data;
+
+    handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart <= 0 ||
+        (pph_uint64_t)size.QuadPart > (pph_uint64_t)(~(pph_size_t)0)) {
+        CloseHandle(handle);
+        return -1;
+    }
+
+    mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+    if (mapping == NULL) {
+        return -1;
+    }
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        CloseHandle(mapping);
+        return -1;
+    }
+
+    ruleset->data = (const char*)data;
+    ruleset->size = (pph_size_t)size.QuadPart;
+    ruleset->handle = mapping;
+    ruleset->mapped = 1;
+    return 0;
+}
+
+static void unmap_ruleset_file(pph_ruleset_t *ruleset) {
+    UnmapViewOfFile(ruleset->data);
+    CloseHandle((HANDLE)ruleset->handle);
+}
+
+#else
+
+static int map_ruleset_file(const char *path, pph_ruleset_t *ruleset) {
+    return read_whole_file(path, ruleset);
+}
+
+static void unmap_ruleset_file(pph_ruleset_t *ruleset) {
+    (void)ruleset;
+}
+
+#endif
+
+static void release_ruleset(pph_ruleset_t *ruleset) {
+    if (ruleset->mapped) {
+        unmap_ruleset_file(ruleset);
+    } else {
+        pph_free((void*)ruleset->data);
+    }
+    pph_free(ruleset);
+}
+
+/* ============================================
+   Validation
+   ============================================ */
+
+static const char* parse_ter_table(const pph_ruleset_t *ruleset, const ruleset_section_t *section,
+                                   pph_ter_table_t *table) {
+    const pph_uint32_t *ceilings;
+    const pph_uint16_t *rates;
+    pph_uint32_t count = section->count;
+    pph_uint32_t i;
+
+    if (count < 1 || count > 255 ||
+        section->offset > ruleset->size ||
+        (pph_uint64_t)PPH_TER_PADDED(count) * 4 + count * 2 > ruleset->size - section->offset) {
+        return "Ruleset TER section is truncated";
+    }
+
+    ceilings = (const pph_uint32_t*)(ruleset->data + section->offset);
+    rates = (const pph_uint16_t*)(ceilings + PPH_TER_PADDED(count));
+
+    for (i = 0; i < (pph_uint32_t)PPH_TER_PADDED(count); i++) {
+        if (ceilings[i] > PPH_TER_CEILING_PAD ||
+            (i > 0 && i < count && ceilings[i] <= ceilings[i - 1]) ||
+            (i >= count - 1 && ceilings[i] != PPH_TER_CEILING_PAD)) {
+            return "Ruleset TER ceilings must ascend and end with the padding value";
+        }
+        if (i < count && rates[i] > PPH_SCALE_FACTOR) {
+            return "Ruleset TER rate is above 100%";
+        }
+    }
+
+    table->ceilings = ceilings;
+    table->rates = rates;
+    table->count = (int)count;
+    table->quantized = NULL;
+    table->quantized_count = 0;
+    return NULL;
+}
+
+static const char* parse_pasal17(const pph_ruleset_t *ruleset, const ruleset_section_t *section,
+                                 pph_rules_t *rules) {
+    const pph_pasal17_bracket_t *brackets;
+    pph_uint32_t count = section->count;
+    pph_uint32_t i;
+
+    if (count < 1 || count > RULESET_MAX_BRACKETS ||
+        section->offset > ruleset->size ||
+        (pph_uint64_t)count * sizeof(pph_pasal17_bracket_t) > ruleset->size - section->offset) {
+        return "Ruleset Pasal 17 section is truncated";
+    }
+
+    brackets = (const pph_pasal17_bracket_t*)(ruleset->data + section->offset);
+    if (brackets[0].start.value != 0 || brackets[0].base_tax.value != 0) {
+        return "Ruleset Pasal 17 brackets must start at zero";
+    }
+
+    /* Rates up to 100% keep every base tax below its start, so bounding
+       the starts bounds all tax arithmetic */
+    for (i = 0; i < count; i++) {
+        if (brackets[i].rate.value < 0 || brackets[i].rate.value > PPH_SCALE_FACTOR) {
+            return "Ruleset Pasal 17 rate is out of range";
+        }
+        if (i == 0) {
+            continue;
+        }
+        if (brackets[i].start.value <= brackets[i - 1].start.value ||
+            brackets[i].start.value > PPH_INT64_C(0x3FFFFFFFFFFFFFFF)) {
+            return "Ruleset Pasal 17 brackets must ascend";
+        }
+        if (brackets[i].base_tax.value != brackets[i - 1].base_tax.value +
+            pph_apply_rate(brackets[i].start.value - brackets[i - 1].start.value,
+                           brackets[i - 1].rate.value)) {
+            return "Ruleset Pasal 17 base tax does not match the layers below it";
+        }
+    }
+
+    rules->brackets = brackets;
+    rules->bracket_count = (int)count;
+    return NULL;
+}
+
+static const char* parse_ruleset(pph_ruleset_t *ruleset) {
+    const ruleset_header_t *header = (const ruleset_header_t*)ruleset->data;
+    const ruleset_section_t *sections;
+    pph_rules_t *rules = &ruleset->rules;
+    unsigned int seen = 0;
+    const char *error;
+    pph_uint32_t i;
+
+    if (ruleset->size < sizeof(ruleset_header_t) ||
+        memcmp(header->magic, RULESET_MAGIC, 4) != 0) {
+        return "Not a ruleset file";
+    }
+    if (header->byte_order != RULESET_BYTE_ORDER) {
+        return "Ruleset file has the wrong byte order";
+    }
+    if (header->version != RULESET_VERSION || header->header_size != sizeof(ruleset_header_t)) {
+        return "Unsupported ruleset file version";
+    }
+    if (header->file_size != ruleset->size || header->section_count > RULESET_MAX_SECTIONS ||
+        sizeof(ruleset_header_t) + header->section_count * sizeof(ruleset_section_t) > ruleset->size) {
+        return "Ruleset file is truncated";
+    }
+
+    memcpy(ruleset->label, header->label, RULESET_LABEL_SIZE);
+    ruleset->label[RULESET_LABEL_SIZE] = '\0';
+
+    sections = (const ruleset_section_t*)(ruleset->data + sizeof(ruleset_header_t));
+    for (i = 0; i < header->section_count; i++) {
+        const ruleset_section_t *section = &sections[i];
+        unsigned int bit;
+
+        if (section->offset % 8 != 0 ||
+            section->offset < sizeof(ruleset_header_t) +
+                              header->section_count * sizeof(ruleset_section_t)) {
+            return "Ruleset section is misplaced";
+        }
+
+        switch (section->kind) {
+            case RULESET_PTKP:
+                bit = 0;
+                if (section->count != 8 || section->offset > ruleset->size ||
+                    8 * sizeof(pph_uint32_t) > ruleset->size - section->offset) {
+                    return "Ruleset PTKP section is truncated";
+                }
+                rules->ptkp = (const pph_uint32_t*)(ruleset->data + section->offset);
+                error = NULL;
+                break;
+            case RULESET_PASAL17:
+                bit = 1;
+                error = parse_pasal17(ruleset, section, rules);
+                break;
+            case RULESET_TER_MONTHLY | PPH21_TER_CATEGORY_A:
+            case RULESET_TER_MONTHLY | PPH21_TER_CATEGORY_B:
+            case RULESET_TER_MONTHLY | PPH21_TER_CATEGORY_C:
+                bit = 2 + (section->kind & 0x0F);
+                error = parse_ter_table(ruleset, section, &rules->ter_monthly[section->kind & 0x0F]);
+                break;
+            case RULESET_TER_DAILY | PPH21_TER_CATEGORY_A:
+            case RULESET_TER_DAILY | PPH21_TER_CATEGORY_B:
+            case RULESET_TER_DAILY | PPH21_TER_CATEGORY_C:
+                bit = 5 + (section->kind & 0x0F);
+                error = parse_ter_table(ruleset, section, &rules->ter_daily[section->kind & 0x0F]);
+                break;
+            default:
+                return "Unknown ruleset section";
+        }
+
+        if (error != NULL) {
+            return error;
+        }
+        if (seen & (1u << bit)) {
+            return "Duplicate ruleset section";
+        }
+        seen |= 1u << bit;
+    }
+
+    if (seen != 0xFFu) {
+        return "Ruleset file is missing a section";
+    }
+    return NULL;
+}
+
+/* ============================================
+   Loading and Writing
+   ============================================ */
+
+pph_ruleset_t* pph_ruleset_load(const char *path) {
+    pph_ruleset_t *ruleset;
+    const char *error;
+
+    if (path == NULL) {
+        pph_set_last_error("Ruleset path is NULL");
+        return NULL;
+    }
+
+    ruleset = (pph_ruleset_t*)pph_malloc(sizeof(pph_ruleset_t));
+    if (ruleset == NULL) {
+        pph_set_last_error("Out of memory");
+        return NULL;
+    }
+    memset(ruleset, 0, sizeof(pph_ruleset_t));
+
+    if (map_ruleset_file(path, ruleset) != 0) {
+        pph_free(ruleset);
+        pph_set_last_error("Cannot read ruleset file");
+        return NULL;
+    }
+
+    error = parse_ruleset(ruleset);
+    if (error != NULL) {
+        release_ruleset(ruleset);
+        pph_set_last_error(error);
+        return NULL;
+    }
+
+    pph_rules_build_index(&ruleset->rules, ruleset->index);
+    return ruleset;
+}
+
+void pph_ruleset_free(pph_ruleset_t *ruleset) {
+    if (ruleset != NULL) {
+        release_ruleset(ruleset);
+    }
+}
+
+const char* pph_ruleset_label(const pph_ruleset_t *ruleset) {
+    return ruleset ? ruleset->label : "built-in";
+}
+
+static int write_padded(FILE *file, const void *data, pph_size_t size, pph_uint64_t *offset) {
+    static const char zeros[8] = { 0 };
+    pph_size_t pad = (pph_size_t)((8 - (*offset + size) % 8) % 8);
+
+    if (fwrite(data, 1, size, file) != size || fwrite(zeros, 1, pad, file) != pad) {
+        return -1;
+    }
+    *offset += size + pad;
+    return 0;
+}
+
+static pph_uint64_t ter_section_size(const pph_ter_table_t *table) {
+    pph_uint64_t size = (pph_uint64_t)PPH_TER_PADDED(table->count) * 4 + table->count * 2;
+
+    return (size + 7) / 8 * 8;
+}
+
+pph_status_t pph_ruleset_write(const pph_ruleset_t *ruleset, const char *label,
+                               const char *path) {
+    const pph_rules_t *rules = ruleset ? &ruleset->rules : pph_builtin_rules();
+    const pph_ter_table_t *tables[6];
+    ruleset_header_t header;
+    ruleset_section_t sections[8];
+    pph_uint64_t offset;
+    pph_size_t label_length;
+    FILE *file;
+    int i, failed;
+
+    if (path == NULL) {
+        pph_set_last_error("Ruleset path is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+    if (label == NULL) {
+        label = pph_ruleset_label(ruleset);
+    }
+
+    for (i = 0; i < 3; i++) {
+        tables[i] = &rules->ter_monthly[i];
+        tables[3 + i] = &rules->ter_daily[i];
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RULESET_MAGIC, 4);
+    header.version = RULESET_VERSION;
+    header.header_size = sizeof(ruleset_header_t);
+    header.byte_order = RULESET_BYTE_ORDER;
+    header.section_count = 8;
+    /* Longer labels are cut; the field needs no terminator when full */
+    label_length = strlen(label);
+    if (label_length > RULESET_LABEL_SIZE) {
+        label_length = RULESET_LABEL_SIZE;
+    }
+    memcpy(header.label, label, label_length);
+
+    offset = sizeof(ruleset_header_t) + sizeof(sections);
+    sections[0].kind = RULESET_PTKP;
+    sections[0].count = 8;
+    sections[0].offset = offset;
+    offset += 8 * sizeof(pph_uint32_t);
+    sections[1].kind = RULESET_PASAL17;
+    sections[1].count = (pph_uint32_t)rules->bracket_count;
+    sections[1].offset = offset;
+    offset += rules->bracket_count * sizeof(pph_pasal17_bracket_t);
+    for (i = 0; i < 6; i++) {
+        sections[2 + i].kind = (i < 3 ? RULESET_TER_MONTHLY : RULESET_TER_DAILY) | (i % 3);
+        sections[2 + i].count = (pph_uint32_t)tables[i]->count;
+        sections[2 + i].offset = offset;
+        offset += ter_section_size(tables[i]);
+    }
+    header.file_size = offset;
+
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        pph_set_last_error("Cannot write ruleset file");
+        return PPH_ERR_INVALID_INPUT;
+    }
+
+    offset = 0;
+    failed = write_padded(file, &header, sizeof(header), &offset) != 0 ||
+             write_padded(file, sections, sizeof(sections), &offset) != 0 ||
+             write_padded(file, rules->ptkp, 8 * sizeof(pph_uint32_t), &offset) != 0 ||
+             write_padded(file, rules->brackets,
+                          rules->bracket_count * sizeof(pph_pasal17_bracket_t), &offset) != 0;
+    for (i = 0; i < 6 && !failed; i++) {
+        failed = write_padded(file, tables[i]->ceilings,
+                              PPH_TER_PADDED(tables[i]->count) * sizeof(pph_uint32_t),
+                              &offset) != 0 ||
+                 write_padded(file, tables[i]->rates, tables[i]->count * sizeof(pph_uint16_t),
+                              &offset) != 0;
+    }
+
+    if (fclose(file) != 0 || failed) {
+        pph_set_last_error("Cannot write ruleset file");
+        return PPH_ERR_INVALID_INPUT;
+    }
+    return PPH_OK;
+}
+
+/* ============================================
+   Publication
+
+   Readers never lock. A thread pinning the rules claims a reader slot and
+   records the publication epoch in it, then loads the published pointer.
+   Publishing swaps the pointer, advances the epoch and retires the old
+   ruleset tagged with the new epoch; it is freed once no slot holds an
+   older epoch. A reader that saw the old pointer stored its slot before
+   the swap, so the scan cannot miss it. Threads that find every slot
+   taken count themselves in overflow_readers, which holds back all
+   reclamation while it is nonzero.
+   ============================================ */
+
+#define RULESET_READER_SLOTS 64
+#define READER_ADOPTED -2
+
+typedef struct {
+    volatile long epoch;  /* 0 when free */
+    char pad[64 - sizeof(long)];
+} reader_slot_t;
+
+static reader_slot_t reader_slots[RULESET_READER_SLOTS];
+static volatile long overflow_readers = 0;
+static volatile long global_epoch = 1;
+static volatile long next_slot_hint = 0;
+static void *volatile published = NULL;  /* pph_ruleset_t, NULL for built-in */
+
+/* Publishers only; publication is rare, so a spin lock is enough */
+static volatile long publish_lock = 0;
+static pph_ruleset_t *retired = NULL;
+
+static PPH_THREAD_LOCAL int reader_depth = 0;
+static PPH_THREAD_LOCAL int reader_slot = -1;  /* READER_ADOPTED, or -1 if counted in overflow */
+static PPH_THREAD_LOCAL int reader_hint = -1;
+static PPH_THREAD_LOCAL const pph_rules_t *pinned_rules = NULL;
+
+const pph_rules_t* pph_rules_enter(void) {
+    pph_ruleset_t *ruleset;
+    long epoch;
+    int i, n;
+
+    if (reader_depth++ > 0) {
+        return pinned_rules;
+    }
+
+    if (reader_hint < 0) {
+        reader_hint = (int)(pph_atomic_add_long(&next_slot_hint, 1) % RULESET_READER_SLOTS);
+    }
+
+    epoch = pph_atomic_load_long(&global_epoch);
+    reader_slot = -1;
+    for (i = reader_hint, n = 0; n < RULESET_READER_SLOTS; n++) {
+        if (pph_atomic_cas_long(&reader_slots[i].epoch, 0, epoch)) {
+            reader_slot = i;
+            reader_hint = i;
+            break;
+        }
+        i = (i + 1) % RULESET_READER_SLOTS;
+    }
+    if (reader_slot < 0) {
+        pph_atomic_add_long(&overflow_readers, 1);
+    }
+
+    ruleset = (pph_ruleset_t*)pph_atomic_load_ptr(&published);
+    pinned_rules = ruleset ? &ruleset->rules : pph_builtin_rules();
+    return pinned_rules;
+}
+
+const pph_rules_t* pph_rules_adopt(const pph_rules_t *rules) {
+    const pph_rules_t *previous = pinned_rules;
+
+    if (reader_depth++ == 0) {
+        reader_slot = READER_ADOPTED;
+    }
+    pinned_rules = rules;
+    return previous;
+}
+
+void pph_rules_restore(const pph_rules_t *previous) {
+    pinned_rules = previous;
+    pph_rules_exit();
+}
+
+void pph_rules_exit(void) {
+    if (--reader_depth > 0) {
+        return;
+    }
+
+    pinned_rules = NULL;
+    if (reader_slot == READER_ADOPTED) {
+        return;
+    }
+    if (reader_slot >= 0) {
+        pph_atomic_store_long(&reader_slots[reader_slot].epoch, 0);
+    } else {
+        pph_atomic_add_long(&overflow_readers, -1);
+    }
+}
+
+static void publish_lock_acquire(void) {
+    while (!pph_atomic_cas_long(&publish_lock, 0, 1)) {
+    }
+}
+
+static void publish_lock_release(void) {
+    pph_atomic_store_long(&publish_lock, 0);
+}
+
+/* Frees what no reader can still see; returns how many remain */
+static int reclaim_retired(void) {
+    pph_ruleset_t **link = &retired;
+    long oldest = 0;
+    int busy, pending = 0;
+    int i;
+
+    for (i = 0; i < RULESET_READER_SLOTS; i++) {
+        long epoch = pph_atomic_load_long(&reader_slots[i].epoch);
+
+        if (epoch != 0 && (oldest == 0 || epoch < oldest)) {
+            oldest = epoch;
+        }
+    }
+    busy = pph_atomic_load_long(&overflow_readers) != 0;
+
+    while (*link != NULL) {
+        pph_ruleset_t *ruleset = *link;
+
+        if (!busy && (oldest == 0 || oldest >= ruleset->retire_epoch)) {
+            *link = ruleset->next;
+            release_ruleset(ruleset);
+        } else {
+            link = &ruleset->next;
+            pending++;
+        }
+    }
+    return pending;
+}
+
+void pph_ruleset_publish(pph_ruleset_t *ruleset) {
+    pph_ruleset_t *old;
+
+    publish_lock_acquire();
+
+    old = (pph_ruleset_t*)pph_atomic_exchange_ptr(&published, (void*)ruleset);
+    if (old != NULL && old != ruleset) {
+        old->retire_epoch = pph_atomic_add_long(&global_epoch, 1);
+        old->next = retired;
+        retired = old;
+    }
+    reclaim_retired();
+
+    publish_lock_release();
+}
+
+int pph_ruleset_collect(void) {
+    int pending;
+
+    publish_lock_acquire();
+    pending = reclaim_retired();
+    publish_lock_release();
+    return pending;
+}
+
+/* ============================================
+   Registry
+
+   Rulesets keyed by the date they take effect, kept sorted so the one in
+   force on a date is found by binary search: the entry with the latest
+   effective date not after it.
+   ============================================ */
+
+typedef struct {
+    long effective_date;
+    pph_ruleset_t *ruleset;  /* NULL for the built-in rules */
+} registry_entry_t;
+
+struct pph_ruleset_registry {
+    registry_entry_t *entries;
+    int count;
+    int capacity;
+};
+
+/* YYYYMMDD with a plausible month and day */
+static int valid_date(long date) {
+    long month = (date / 100) % 100;
+    long day = date % 100;
+
+    return date > 10000 && date <= 99991231L && month >= 1 && month <= 12 && day >= 1 && day <= 31;
+}
+
+pph_ruleset_registry_t* pph_ruleset_registry_create(void) {
+    pph_ruleset_registry_t *registry;
+
+    registry = (pph_ruleset_registry_t*)pph_malloc(sizeof(pph_ruleset_registry_t));
+    if (registry == NULL) {
+        pph_set_last_error("Out of memory");
+        return NULL;
+    }
+    registry->entries = NULL;
+    registry->count = 0;
+    registry->capacity = 0;
+    return registry;
+}
+
+void pph_ruleset_registry_free(pph_ruleset_registry_t *registry) {
+    int i;
+
+    if (registry == NULL) {
+        return;
+    }
+    for (i = 0; i < registry->count; i++) {
+        pph_ruleset_free(registry->entries[i].ruleset);
+    }
+    pph_free(registry->entries);
+    pph_free(registry);
+}
+
+pph_status_t pph_ruleset_registry_add(pph_ruleset_registry_t *registry, long effective_date,
+                                      pph_ruleset_t *ruleset) {
+    int i, j;
+
+    if (registry == NULL) {
+        pph_set_last_error("Registry is NULL");
+        return PPH_ERR_NULL_INPUT;
+    }
+    if (!valid_date(effective_date)) {
+        pph_set_last_error("Effective date must be YYYYMMDD");
+        return PPH_ERR_INVALID_INPUT;
+    }
+
+    for (i = 0; i < registry->count && registry->entries[i].effective_date < effective_date; i++) {
+    }
+
+    if (i < registry->count && registry->entries[i].effective_date == effective_date) {
+        if (registry->entries[i].ruleset != ruleset) {
+            pph_ruleset_free(registry->entries[i].ruleset);
+            registry->entries[i].ruleset = ruleset;
+        }
+        return PPH_OK;
+    }
+
+    if (registry->count == registry->capacity) {
+        int capacity = registry->capacity ? registry->capacity * 2 : 8;
+        registry_entry_t *entries = (registry_entry_t*)pph_realloc(
+            registry->entries, sizeof(registry_entry_t) * (pph_size_t)capacity);
+
+        if (entries == NULL) {
+            pph_set_last_error("Out of memory");
+            return PPH_ERR_NO_MEMORY;
+        }
+        registry->entries = entries;
+        registry->capacity = capacity;
+    }
+
+    for (j = registry->count; j > i; j--) {
+        registry->entries[j] = registry->entries[j - 1];
+    }
+    registry->entries[i].effective_date = effective_date;
+    registry->entries[i].ruleset = ruleset;
+    registry->count++;
+    return PPH_OK;
+}
+
+/* Entry in force on date, or -1 */
+static int registry_find(const pph_ruleset_registry_t *registry, long date) {
+    int lo = 0, hi = registry->count;
+
+    /* First entry taking effect after date */
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+
+        if (registry->entries[mid].effective_date <= date) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo - 1;
+}
+
+const char* pph_ruleset_registry_label(const pph_ruleset_registry_t *registry, long date) {
+    int i;
+
+    if (registry == NULL || !valid_date(date) || (i = registry_find(registry, date)) < 0) {
+        return NULL;
+    }
+    return pph_ruleset_label(registry->entries[i].ruleset);
+}
+
+const pph_rules_t* pph_ruleset_registry_rules(const pph_ruleset_registry_t *registry, long date) {
+    const pph_ruleset_t *ruleset;
+    int i;
+
+    if (!valid_date(date) || (i = registry_find(registry, date)) < 0) {
+        return NULL;
+    }
+    ruleset = registry->entries[i].ruleset;
+    return ruleset ? &ruleset->rules : pph_builtin_rules();
+}
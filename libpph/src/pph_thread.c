@@ -0,0 +1,148 @@
+/*
+ * PPH Thread - Minimal portable threading layer
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#if defined(PPH_HAVE_THREADS) && !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    /* pthreads and sysconf() are hidden in strict C90 mode */
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "pph_thread.h"
+
+#if defined(PPH_HAVE_THREADS) && !defined(_WIN32)
+    #include <unistd.h>
+#endif
+
+#if !defined(PPH_HAVE_THREADS)
+
+/* ============================================
+   Single-Threaded Build
+   ============================================ */
+
+int pph_thread_create(pph_thread_t *thread, pph_thread_start_t *start) {
+    (void)thread;
+    (void)start;
+    return -1;
+}
+
+void pph_thread_join(pph_thread_t thread) {
+    (void)thread;
+}
+
+int pph_mutex_init(pph_mutex_t *mutex) { (void)mutex; return 0; }
+void pph_mutex_destroy(pph_mutex_t *mutex) { (void)mutex; }
+void pph_mutex_lock(pph_mutex_t *mutex) { (void)mutex; }
+void pph_mutex_unlock(pph_mutex_t *mutex) { (void)mutex; }
+
+int pph_cond_init(pph_cond_t *cond) { (void)cond; return 0; }
+void pph_cond_destroy(pph_cond_t *cond) { (void)cond; }
+void pph_cond_wait(pph_cond_t *cond, pph_mutex_t *mutex) { (void)cond; (void)mutex; }
+void pph_cond_broadcast(pph_cond_t *cond) { (void)cond; }
+
+int pph_cpu_count(void) {
+    return 1;
+}
+
+void* pph_exchange_ptr_plain(void *volatile *p, void *v) {
+    void *old = *p;
+    *p = v;
+    return old;
+}
+
+#elif defined(_WIN32)
+
+/* ============================================
+   Win32 Threads
+   ============================================ */
+
+static DWORD WINAPI win32_trampoline(LPVOID param) {
+    pph_thread_start_t *start = (pph_thread_start_t*)param;
+    start->fn(start->arg);
+    return 0;
+}
+
+int pph_thread_create(pph_thread_t *thread, pph_thread_start_t *start) {
+    *thread = CreateThread(NULL, 0, win32_trampoline, start, 0, NULL);
+    return (*thread != NULL) ? 0 : -1;
+}
+
+void pph_thread_join(pph_thread_t thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+int pph_mutex_init(pph_mutex_t *mutex) {
+    InitializeCriticalSection(mutex);
+    return 0;
+}
+
+void pph_mutex_destroy(pph_mutex_t *mutex) { DeleteCriticalSection(mutex); }
+void pph_mutex_lock(pph_mutex_t *mutex) { EnterCriticalSection(mutex); }
+void pph_mutex_unlock(pph_mutex_t *mutex) { LeaveCriticalSection(mutex); }
+
+int pph_cond_init(pph_cond_t *cond) {
+    InitializeConditionVariable(cond);
+    return 0;
+}
+
+void pph_cond_destroy(pph_cond_t *cond) { (void)cond; }
+
+void pph_cond_wait(pph_cond_t *cond, pph_mutex_t *mutex) {
+    SleepConditionVariableCS(cond, mutex, INFINITE);
+}
+
+void pph_cond_broadcast(pph_cond_t *cond) { WakeAllConditionVariable(cond); }
+
+int pph_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (info.dwNumberOfProcessors > 0) ? (int)info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+/* ============================================
+   POSIX Threads
+   ============================================ */
+
+static void* posix_trampoline(void *param) {
+    pph_thread_start_t *start = (pph_thread_start_t*)param;
+    start->fn(start->arg);
+    return NULL;
+}
+
+int pph_thread_create(pph_thread_t *thread, pph_thread_start_t *start) {
+    return (pthread_create(thread, NULL, posix_trampoline, start) == 0) ? 0 : -1;
+}
+
+void pph_thread_join(pph_thread_t thread) {
+    pthread_join(thread, NULL);
+}
+
+int pph_mutex_init(pph_mutex_t *mutex) {
+    return (pthread_mutex_init(mutex, NULL) == 0) ? 0 : -1;
+}
+
+void pph_mutex_destroy(pph_mutex_t *mutex) { pthread_mutex_destroy(mutex); }
+void pph_mutex_lock(pph_mutex_t *mutex) { pthread_mutex_lock(mutex); }
+void pph_mutex_unlock(pph_mutex_t *mutex) { pthread_mutex_unlock(mutex); }
+
+int pph_cond_init(pph_cond_t *cond) {
+    return (pthread_cond_init(cond, NULL) == 0) ? 0 : -1;
+}
+
+void pph_cond_destroy(pph_cond_t *cond) { pthread_cond_destroy(cond); }
+void pph_cond_wait(pph_cond_t *cond, pph_mutex_t *mutex) { pthread_cond_wait(cond, mutex); }
+void pph_cond_broadcast(pph_cond_t *cond) { pthread_cond_broadcast(cond); }
+
+int pph_cpu_count(void) {
+#if defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+#else
+    return 1;
+#endif
+}
+
+#endif
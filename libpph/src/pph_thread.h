@@ -0,0 +1,128 @@
+/*
+ * PPH Thread - Minimal portable threading layer
+ *
+ * DO NOT include this header in public headers or user code.
+ * Only built with real threads when PPH_HAVE_THREADS is defined; other
+ * targets (DOS, OpenWatcom, single-threaded WASM) run everything on the
+ * calling thread.
+ *
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#ifndef PPH_THREAD_H
+#define PPH_THREAD_H
+
+#include <pph/pph_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================
+   Thread-Local Storage
+   ============================================ */
+#if defined(PPH_HAVE_THREADS) && defined(_MSC_VER)
+    #define PPH_THREAD_LOCAL __declspec(thread)
+#elif defined(PPH_HAVE_THREADS) && (defined(__GNUC__) || defined(__clang__))
+    #define PPH_THREAD_LOCAL __thread
+#else
+    #define PPH_THREAD_LOCAL
+#endif
+
+/* ============================================
+   Atomics
+
+   Sequentially consistent operations on a long or a pointer, for the few
+   lock-free paths (ruleset publication). Plain accesses without threads.
+   ============================================ */
+#if defined(PPH_HAVE_THREADS) && (defined(__GNUC__) || defined(__clang__))
+    #define pph_atomic_load_long(p)          __atomic_load_n((p), __ATOMIC_SEQ_CST)
+    #define pph_atomic_store_long(p, v)      __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+    #define pph_atomic_add_long(p, v)        __atomic_add_fetch((p), (v), __ATOMIC_SEQ_CST)
+    #define pph_atomic_cas_long(p, old, v)   __sync_bool_compare_and_swap((p), (old), (v))
+    #define pph_atomic_load_ptr(p)           __atomic_load_n((p), __ATOMIC_SEQ_CST)
+    #define pph_atomic_exchange_ptr(p, v)    __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#elif defined(PPH_HAVE_THREADS) && defined(_MSC_VER)
+    #define pph_atomic_load_long(p)          InterlockedCompareExchange((p), 0, 0)
+    #define pph_atomic_store_long(p, v)      ((void)InterlockedExchange((p), (v)))
+    #define pph_atomic_add_long(p, v)        (InterlockedExchangeAdd((p), (v)) + (v))
+    #define pph_atomic_cas_long(p, old, v)   (InterlockedCompareExchange((p), (v), (old)) == (old))
+    #define pph_atomic_load_ptr(p)           InterlockedCompareExchangePointer((p), NULL, NULL)
+    #define pph_atomic_exchange_ptr(p, v)    InterlockedExchangePointer((p), (v))
+#else
+    #define pph_atomic_load_long(p)          (*(p))
+    #define pph_atomic_store_long(p, v)      ((void)(*(p) = (v)))
+    #define pph_atomic_add_long(p, v)        (*(p) += (v))
+    #define pph_atomic_cas_long(p, old, v)   ((*(p) == (old)) ? (*(p) = (v), 1) : 0)
+    #define pph_atomic_load_ptr(p)           (*(p))
+    #define pph_atomic_exchange_ptr(p, v)    pph_exchange_ptr_plain((p), (v))
+
+    void* pph_exchange_ptr_plain(void *volatile *p, void *v);
+#endif
+
+/* ============================================
+   Native Handles
+   ============================================ */
+#if defined(PPH_HAVE_THREADS)
+    #if defined(_WIN32)
+        #include <windows.h>
+        typedef HANDLE pph_thread_t;
+        typedef CRITICAL_SECTION pph_mutex_t;
+        typedef CONDITION_VARIABLE pph_cond_t;
+    #else
+        #include <pthread.h>
+        typedef pthread_t pph_thread_t;
+        typedef pthread_mutex_t pph_mutex_t;
+        typedef pthread_cond_t pph_cond_t;
+    #endif
+#else
+    typedef int pph_thread_t;
+    typedef int pph_mutex_t;
+    typedef int pph_cond_t;
+#endif
+
+/**
+ * Thread entry point and its argument
+ * Must stay alive until the thread has been joined.
+ */
+typedef struct {
+    void (*fn)(void *arg);
+    void *arg;
+} pph_thread_start_t;
+
+/**
+ * Start a thread
+ * @param thread Receives the thread handle
+ * @param start Entry point (must outlive the thread)
+ * @return 0 on success, -1 on error (always -1 without thread support)
+ */
+int pph_thread_create(pph_thread_t *thread, pph_thread_start_t *start);
+
+/**
+ * Wait for a thread to finish
+ * @param thread Thread handle from pph_thread_create()
+ */
+void pph_thread_join(pph_thread_t thread);
+
+/* Mutex and condition variable (no-ops without thread support) */
+int pph_mutex_init(pph_mutex_t *mutex);
+void pph_mutex_destroy(pph_mutex_t *mutex);
+void pph_mutex_lock(pph_mutex_t *mutex);
+void pph_mutex_unlock(pph_mutex_t *mutex);
+
+int pph_cond_init(pph_cond_t *cond);
+void pph_cond_destroy(pph_cond_t *cond);
+void pph_cond_wait(pph_cond_t *cond, pph_mutex_t *mutex);
+void pph_cond_broadcast(pph_cond_t *cond);
+
+/**
+ * Number of online processors
+ * @return Processor count, 1 when unknown or without thread support
+ */
+int pph_cpu_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PPH_THREAD_H */
@@ -33,10 +33,10 @@ pph_result_t* ppn_calculate(const ppn_input_t *input) {
         ppn = pph_money_mul(dpp, input->rate);
     }
 
-    pph_result_add_section(result, "PPN");
-    pph_result_add_currency(result, "DPP", dpp, NULL);
-    pph_result_add_percent(result, "Tarif PPN", input->rate, NULL);
-    pph_result_add_total(result, "PPN", ppn);
+    pph_result_add_section(result, PPH_LABEL_PPN);
+    pph_result_add_currency(result, PPH_LABEL_DPP, dpp, PPH_LABEL_NONE);
+    pph_result_add_percent(result, PPH_LABEL_TARIF_PPN, input->rate, PPH_LABEL_NONE);
+    pph_result_add_total(result, PPH_LABEL_PPN, ppn);
 
     result->total_tax = ppn;
     return result;
@@ -25,13 +25,13 @@ pph_result_t* ppnbm_calculate(const ppnbm_input_t *input) {
     ppnbm = pph_money_mul(input->dpp, input->ppnbm_rate);
     total = pph_money_add(ppn, ppnbm);
 
-    pph_result_add_section(result, "PPN dan PPnBM");
-    pph_result_add_currency(result, "DPP", input->dpp, NULL);
-    pph_result_add_percent(result, "Tarif PPN", input->ppn_rate, NULL);
-    pph_result_add_currency(result, "PPN", ppn, NULL);
-    pph_result_add_percent(result, "Tarif PPnBM", input->ppnbm_rate, NULL);
-    pph_result_add_currency(result, "PPnBM", ppnbm, NULL);
-    pph_result_add_total(result, "Total PPN + PPnBM", total);
+    pph_result_add_section(result, PPH_LABEL_SECTION_PPN_PPNBM);
+    pph_result_add_currency(result, PPH_LABEL_DPP, input->dpp, PPH_LABEL_NONE);
+    pph_result_add_percent(result, PPH_LABEL_TARIF_PPN, input->ppn_rate, PPH_LABEL_NONE);
+    pph_result_add_currency(result, PPH_LABEL_PPN, ppn, PPH_LABEL_NONE);
+    pph_result_add_percent(result, PPH_LABEL_TARIF_PPNBM, input->ppnbm_rate, PPH_LABEL_NONE);
+    pph_result_add_currency(result, PPH_LABEL_PPNBM, ppnbm, PPH_LABEL_NONE);
+    pph_result_add_total(result, PPH_LABEL_TOTAL_PPN_PPNBM, total);
 
     result->total_tax = total;
     return result;
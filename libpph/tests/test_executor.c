@@ -0,0 +1,206 @@
+/*
+ * Test: Parallel batch executor
+ * Copyright (c) 2025 OpenPajak Contributors
+ */
+
+#include <pph/pph_calculator.h>
+#include "test_common.h"
+#include <string.h>
+
+int g_test_total = 0;
+int g_test_passed = 0;
+int g_test_failed = 0;
+
+#define PAYROLL_SIZE 5000
+
+static pph21_input_t g_inputs[PAYROLL_SIZE];
+static pph21_summary_t g_expected[PAYROLL_SIZE];
+static pph21_summary_t g_outputs[PAYROLL_SIZE];
+static pph21_bonus_t g_thr;
+
+static int summaries_equal(const pph21_summary_t *a, const pph21_summary_t *b, int count) {
+    int i, m;
+
+    for (i = 0; i < count; i++) {
+        if (a[i].status != b[i].status ||
+            a[i].total_tax.value != b[i].total_tax.value ||
+            a[i].ter_paid.value != b[i].ter_paid.value ||
+            a[i].adjustment.value != b[i].adjustment.value) {
+            return 0;
+        }
+        for (m = 0; m < 12; m++) {
+            if (a[i].monthly_ter[m].value != b[i].monthly_ter[m].value) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static void build_payroll(void) {
+    pph_uint32_t seed = 42;
+    int i;
+
+    memset(g_inputs, 0, sizeof(g_inputs));
+    memset(&g_thr, 0, sizeof(g_thr));
+    g_thr.month = 4;
+    g_thr.amount = PPH_RUPIAH(12000000);
+    strcpy(g_thr.name, "THR");
+
+    for (i = 0; i < PAYROLL_SIZE; i++) {
+        seed = seed * 1103515245u + 12345u;
+        g_inputs[i].subject_type = (i % 50 == 0) ? PPH21_BUKAN_PEGAWAI : PPH21_PEGAWAI_TETAP;
+        g_inputs[i].bruto_monthly = PPH_RUPIAH(4000000 + (pph_int64_t)(seed % 80000u) * 1000);
+        g_inputs[i].months_paid = 12;
+        g_inputs[i].pension_contribution = PPH_RUPIAH(100000);
+        g_inputs[i].ptkp_status = (pph_ptkp_status_t)(i % 8);
+        g_inputs[i].scheme = (i % 3) ? PPH21_SCHEME_TER : PPH21_SCHEME_LAMA;
+        g_inputs[i].ter_category = (pph21_ter_category_t)(i % 3);
+        if (i % 7 == 0) {
+            g_inputs[i].bonuses = &g_thr;
+            g_inputs[i].bonus_count = 1;
+        }
+    }
+}
+
+TEST(executor_matches_sequential) {
+    static const int thread_counts[] = { 1, 2, 4, 7 };
+    pph21_batch_totals_t totals;
+    pph_money_t expected_tax = PPH_ZERO;
+    unsigned t;
+    int i;
+
+    ASSERT_EQ(PPH_OK, pph21_calculate_batch(g_inputs, PAYROLL_SIZE, g_expected));
+    for (i = 0; i < PAYROLL_SIZE; i++) {
+        expected_tax = pph_money_add(expected_tax, g_expected[i].total_tax);
+    }
+
+    for (t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        pph_executor_t *executor = pph_executor_create(thread_counts[t]);
+        ASSERT_NOT_NULL(executor);
+        ASSERT_TRUE(pph_executor_thread_count(executor) >= 1);
+
+        memset(g_outputs, 0xAB, sizeof(g_outputs));
+        ASSERT_EQ(PPH_OK, pph21_calculate_batch_parallel(executor, g_inputs, PAYROLL_SIZE,
+                                                         g_outputs, &totals));
+        ASSERT_TRUE(summaries_equal(g_expected, g_outputs, PAYROLL_SIZE));
+        ASSERT_EQ(expected_tax.value, totals.total_tax.value);
+        ASSERT_EQ(0, totals.failed);
+
+        /* The pool is reusable */
+        ASSERT_EQ(PPH_OK, pph21_calculate_batch_parallel(executor, g_inputs, 3,
+                                                         g_outputs, &totals));
+        ASSERT_EQ(g_expected[0].total_tax.value + g_expected[1].total_tax.value +
+                  g_expected[2].total_tax.value, totals.total_tax.value);
+
+        pph_executor_free(executor);
+    }
+
+    return 0;
+}
+
+TEST(executor_reports_first_error) {
+    pph21_batch_totals_t totals;
+    pph_executor_t *executor = pph_executor_create(4);
+    ASSERT_NOT_NULL(executor);
+
+    g_inputs[4321].subject_type = (pph21_subject_type_t)99;
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, pph21_calculate_batch_parallel(executor, g_inputs, PAYROLL_SIZE,
+                                                                    g_outputs, &totals));
+    g_inputs[4321].subject_type = PPH21_PEGAWAI_TETAP;
+
+    ASSERT_EQ(1, totals.failed);
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, g_outputs[4321].status);
+    ASSERT_EQ(PPH_ERR_NULL_INPUT, pph21_calculate_batch_parallel(executor, NULL, 1, g_outputs, &totals));
+    ASSERT_EQ(PPH_OK, pph21_calculate_batch_parallel(executor, g_inputs, 0, g_outputs, &totals));
+
+    pph_executor_free(executor);
+    return 0;
+}
+
+TEST(executor_uneven_records) {
+    static pph21_bonus_t bonuses[36];
+    pph21_batch_totals_t totals;
+    pph_executor_t *executor = pph_executor_create(4);
+    int i;
+
+    ASSERT_NOT_NULL(executor);
+
+    /* A block of expensive records at the front, then two bad records
+       where the lowest index must win however the tasks are stolen */
+    for (i = 0; i < 36; i++) {
+        bonuses[i].month = 1 + i % 12;
+        bonuses[i].amount = PPH_RUPIAH(1000000 + i * 250000);
+        strcpy(bonuses[i].name, "Insentif");
+    }
+    for (i = 0; i < 600; i++) {
+        g_inputs[i].bonuses = bonuses;
+        g_inputs[i].bonus_count = 36;
+        g_inputs[i].subject_type = PPH21_PEGAWAI_TETAP;
+    }
+    g_inputs[4900].subject_type = (pph21_subject_type_t)98;
+    g_inputs[1200].subject_type = (pph21_subject_type_t)99;
+
+    pph21_calculate_batch(g_inputs, PAYROLL_SIZE, g_expected);
+    ASSERT_EQ(g_expected[1200].status, pph21_calculate_batch_parallel(executor, g_inputs, PAYROLL_SIZE,
+                                                                      g_outputs, &totals));
+    ASSERT_TRUE(g_expected[1200].status != PPH_OK);
+    ASSERT_EQ(2, totals.failed);
+    ASSERT_TRUE(summaries_equal(g_expected, g_outputs, PAYROLL_SIZE));
+
+    build_payroll();
+    pph_executor_free(executor);
+    return 0;
+}
+
+typedef struct {
+    pph_int64_t values[1000];
+    pph_int64_t worker_sum[256];
+} run_ctx_t;
+
+static void square_task(void *ctx, int worker, pph_size_t task) {
+    run_ctx_t *run = (run_ctx_t*)ctx;
+    run->values[task] = (pph_int64_t)task * (pph_int64_t)task;
+    run->worker_sum[worker] += (pph_int64_t)task;
+}
+
+TEST(executor_runs_tasks) {
+    static run_ctx_t run;
+    pph_executor_t *executor = pph_executor_create(3);
+    pph_int64_t sum = 0;
+    int i;
+
+    ASSERT_NOT_NULL(executor);
+    memset(&run, 0, sizeof(run));
+
+    pph_executor_run(executor, square_task, &run, 1000);
+
+    for (i = 0; i < 1000; i++) {
+        ASSERT_EQ((pph_int64_t)i * i, run.values[i]);
+    }
+    for (i = 0; i < pph_executor_thread_count(executor); i++) {
+        sum += run.worker_sum[i];
+    }
+    ASSERT_EQ(999 * 1000 / 2, sum);
+
+    pph_executor_free(executor);
+    return 0;
+}
+
+int main(void) {
+    pph_init();
+    build_payroll();
+
+    printf("========================================\n");
+    printf("  Batch Executor Tests\n");
+    printf("========================================\n\n");
+
+    RUN_TEST(executor_matches_sequential);
+    RUN_TEST(executor_reports_first_error);
+    RUN_TEST(executor_uneven_records);
+    RUN_TEST(executor_runs_tasks);
+
+    TEST_SUMMARY();
+
+    return g_test_failed > 0 ? 1 : 0;
+}
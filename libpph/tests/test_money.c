@@ -4,6 +4,9 @@
  */
 
 #include <pph/pph_calculator.h>
+#define PPH_MONEY_INLINE_NO_REDIRECT
+#include <pph/pph_money_inline.h>
+#include <string.h>
 #include "test_common.h"
 
 int g_test_total = 0;
@@ -44,6 +47,127 @@ TEST(money_round_down_thousand) {
     return 0;
 }
 
+TEST(money_multiply_wide) {
+    pph_money_t rate = PPH_MONEY(0, 3500);  /* 35% */
+    pph_money_t big = { PPH_INT64_C(10000000000000000) };  /* 1e12 Rp */
+    pph_money_t max = { PPH_INT64_C(0x7FFFFFFFFFFFFFFF) };
+    pph_money_t min = { -PPH_INT64_C(0x7FFFFFFFFFFFFFFF) - 1 };
+
+    ASSERT_EQ(5000, pph_money_mul(PPH_RUPIAH(1), PPH_MONEY(0, 5000)).value);
+    ASSERT_EQ(-5000, pph_money_mul(PPH_RUPIAH(-1), PPH_MONEY(0, 5000)).value);
+
+    /* Products past 2^64 keep every digit */
+    ASSERT_EQ(PPH_INT64_C(3500000000000000), pph_money_mul(big, rate).value);
+    ASSERT_EQ(-PPH_INT64_C(3500000000000000), pph_money_mul(pph_money_neg(big), rate).value);
+    ASSERT_EQ(PPH_INT64_C(922337203685477580), pph_money_mul(max, PPH_MONEY(0, 1000)).value);
+
+    /* Results out of range saturate */
+    ASSERT_EQ(max.value, pph_money_mul(max, PPH_RUPIAH(2)).value);
+    ASSERT_EQ(min.value, pph_money_mul(max, PPH_RUPIAH(-2)).value);
+    ASSERT_EQ(min.value, pph_money_mul(min, PPH_RUPIAH(1)).value);
+    ASSERT_EQ(max.value, pph_money_mul(min, PPH_RUPIAH(-1)).value);
+    return 0;
+}
+
+TEST(money_reciprocal_division) {
+    static const pph_uint64_t divisors[3] = { 1000, 10000, 10000000 };
+    pph_uint64_t n, x = PPH_UINT64_C(0x9E3779B97F4A7C15);
+    int i, k;
+
+    /* Around multiples of each divisor, around powers of two, and a
+       pseudo-random sweep */
+    for (i = 0; i < 20000; i++) {
+        x = x * PPH_UINT64_C(6364136223846793005) + PPH_UINT64_C(1442695040888963407);
+        for (k = 0; k < 4; k++) {
+            n = (k == 0) ? x
+              : (k == 1) ? (x >> (i % 64)) / divisors[i % 3] * divisors[i % 3] - (pph_uint64_t)(i & 1)
+              : (k == 2) ? (((pph_uint64_t)1 << (i % 64)) - (pph_uint64_t)(i & 1))
+              : ~(pph_uint64_t)0 - (pph_uint64_t)i;
+            ASSERT_TRUE(pph_udiv_1e3_inline(n) == n / 1000);
+            ASSERT_TRUE(pph_udiv_1e4_inline(n) == n / 10000);
+            ASSERT_TRUE(pph_udiv_1e7_inline(n) == n / 10000000);
+        }
+    }
+
+    /* Division by the scale factor truncates toward zero like '/' */
+    ASSERT_EQ(-12, pph_money_div(PPH_MONEY(0, -129999), PPH_SCALE_FACTOR).value);
+    ASSERT_EQ(12, pph_money_div(PPH_MONEY(0, 129999), PPH_SCALE_FACTOR).value);
+    return 0;
+}
+
+TEST(money_array_matches_scalar) {
+    pph_money_t values[23], out[23];
+    pph_money_t rate = PPH_MONEY(0, 3500);
+    pph_money_t huge = { PPH_INT64_C(0x7FFFFFFFFFFFFFFF) };
+    int i;
+
+    /* Mixed signs, exact multiples and values past the vector range */
+    for (i = 0; i < 23; i++) {
+        values[i].value = (i % 3 == 1 ? -1 : 1) * (PPH_INT64_C(123456789) * i * i + i);
+    }
+    values[4].value = PPH_INT64_C(50000000);
+    values[9].value = PPH_INT64_C(1) << 51;
+    values[10].value = huge.value;
+    values[11].value = -huge.value - 1;
+    values[12].value = -PPH_INT64_C(9999999);
+
+    ASSERT_EQ(PPH_OK, pph_money_mul_array(values, rate, out, 23));
+    for (i = 0; i < 23; i++) {
+        ASSERT_EQ(pph_money_mul(values[i], rate).value, out[i].value);
+    }
+    ASSERT_EQ(PPH_OK, pph_money_round_down_thousand_array(values, out, 23));
+    for (i = 0; i < 23; i++) {
+        ASSERT_EQ(pph_money_round_down_thousand(values[i]).value, out[i].value);
+    }
+
+    /* Percent stays within int64 in the scalar form, so skip the extremes */
+    values[10].value = PPH_INT64_C(1) << 40;
+    values[11].value = -(PPH_INT64_C(1) << 40);
+    ASSERT_EQ(PPH_OK, pph_money_percent_array(values, 7, -3, out, 23));
+    for (i = 0; i < 23; i++) {
+        ASSERT_EQ(pph_money_percent(values[i], 7, -3).value, out[i].value);
+    }
+
+    /* In place */
+    ASSERT_EQ(PPH_OK, pph_money_percent_array(values, 1, 1000, values, 23));
+    ASSERT_EQ(PPH_INT64_C(50000), values[4].value);
+
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, pph_money_percent_array(values, 1, 0, out, 23));
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT,
+              pph_money_percent_array(values, -PPH_INT64_C(0x7FFFFFFFFFFFFFFF) - 1, -1, out, 23));
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT,
+              pph_money_percent_array(values, 5, -PPH_INT64_C(0x7FFFFFFFFFFFFFFF) - 1, out, 23));
+    ASSERT_EQ(PPH_ERR_NULL_INPUT, pph_money_mul_array(NULL, rate, out, 1));
+    ASSERT_EQ(PPH_OK, pph_money_mul_array(NULL, rate, NULL, 0));
+    return 0;
+}
+
+TEST(money_checked_ops) {
+    pph_money_t max = { PPH_INT64_C(0x7FFFFFFFFFFFFFFF) };
+    pph_money_t min = { -PPH_INT64_C(0x7FFFFFFFFFFFFFFF) - 1 };
+    pph_money_t out = PPH_RUPIAH(7);
+
+    ASSERT_EQ(PPH_OK, pph_money_add_checked(PPH_RUPIAH(1), PPH_RUPIAH(2), &out));
+    ASSERT_EQ(30000, out.value);
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph_money_add_checked(max, PPH_MONEY(0, 1), &out));
+    ASSERT_EQ(30000, out.value);  /* Untouched */
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph_money_sub_checked(min, PPH_MONEY(0, 1), &out));
+    ASSERT_EQ(PPH_OK, pph_money_sub_checked(PPH_ZERO, max, &out));
+    ASSERT_EQ(-max.value, out.value);
+
+    ASSERT_EQ(PPH_OK, pph_money_mul_int_checked(PPH_RUPIAH(-5), 12, &out));
+    ASSERT_EQ(-600000, out.value);
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph_money_mul_int_checked(max, 2, &out));
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph_money_mul_int_checked(min, -1, &out));
+
+    ASSERT_EQ(PPH_OK, pph_money_percent_checked(PPH_RUPIAH(1000), 5, 100, &out));
+    ASSERT_EQ(500000, out.value);
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph_money_percent_checked(max, 5, 100, &out));
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph_money_percent_checked(min, 1, -1, &out));
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, pph_money_percent_checked(max, 5, 0, &out));
+    return 0;
+}
+
 TEST(money_min) {
     pph_money_t a = PPH_RUPIAH(100);
     pph_money_t b = PPH_RUPIAH(50);
@@ -146,6 +270,121 @@ TEST(parse_id_large_number) {
     return 0;
 }
 
+TEST(parse_bounded_stops_at_length) {
+    /* Field slices out of a CSV line: nothing past len is read */
+    const char *line = "1.234,56;999";
+    ASSERT_EQ(12345600, pph_money_from_string_id_n(line, 8).value);
+    ASSERT_EQ(12340000, pph_money_from_string_id_n(line, 5).value);
+    ASSERT_EQ(0, pph_money_from_string_id_n(line, 0).value);
+    ASSERT_EQ(10000000, pph_money_from_string_n("1000.5", 4).value);
+    ASSERT_EQ(10005000, pph_money_from_string_n("1000.5", 6).value);
+    ASSERT_EQ(-15000, pph_money_from_string_n("-1.5,7", 4).value);
+    return 0;
+}
+
+TEST(format_styles) {
+    char buf[PPH_MONEY_FORMAT_MAX];
+    pph_money_t min = { -PPH_INT64_C(0x7FFFFFFFFFFFFFFF) - 1 };
+
+    ASSERT_EQ(14, pph_money_format(PPH_MONEY(1234567, 8900), PPH_MONEY_FORMAT_EN, buf, sizeof(buf)));
+    ASSERT_TRUE(strcmp(buf, "1,234,567.8900") == 0);
+    pph_money_format(PPH_MONEY(1234567, 8900), PPH_MONEY_FORMAT_ID, buf, sizeof(buf));
+    ASSERT_TRUE(strcmp(buf, "1.234.567,8900") == 0);
+    pph_money_format(PPH_MONEY(-1234567, -8900), PPH_MONEY_FORMAT_PLAIN, buf, sizeof(buf));
+    ASSERT_TRUE(strcmp(buf, "-1234567.8900") == 0);
+    pph_money_format(PPH_MONEY(0, -5000), PPH_MONEY_FORMAT_EN, buf, sizeof(buf));
+    ASSERT_TRUE(strcmp(buf, "-0.5000") == 0);
+    pph_money_format(PPH_MONEY(100, 0), PPH_MONEY_FORMAT_EN, buf, sizeof(buf));
+    ASSERT_TRUE(strcmp(buf, "100.0000") == 0);
+    pph_money_format(min, PPH_MONEY_FORMAT_EN, buf, sizeof(buf));
+    ASSERT_TRUE(strcmp(buf, "-922,337,203,685,477.5808") == 0);
+
+    /* Too small: nothing written */
+    ASSERT_EQ(0, pph_money_format(PPH_RUPIAH(1000), PPH_MONEY_FORMAT_EN, buf, 10));
+    ASSERT_EQ(10, pph_money_format(PPH_RUPIAH(1000), PPH_MONEY_FORMAT_EN, buf, 11));
+
+    pph_money_to_string_formatted(PPH_RUPIAH(-12345), buf, sizeof(buf));
+    ASSERT_TRUE(strcmp(buf, "-12,345.0000") == 0);
+    return 0;
+}
+
+TEST(format_column_chunks) {
+    pph_money_t values[3];
+    char buf[32];
+    pph_size_t written, done;
+
+    values[0] = PPH_RUPIAH(1000);
+    values[1] = PPH_MONEY(-2, 5);
+    values[2] = PPH_RUPIAH(3);
+
+    done = pph_money_format_column(values, 3, PPH_MONEY_FORMAT_ID, '\n', buf, sizeof(buf), &written);
+    ASSERT_EQ(3, done);
+    ASSERT_EQ(26, written);
+    ASSERT_TRUE(memcmp(buf, "1.000,0000\n-1,9995\n3,0000\n", 26) == 0);
+
+    /* Only whole values are written */
+    done = pph_money_format_column(values, 3, PPH_MONEY_FORMAT_ID, ';', buf, 20, &written);
+    ASSERT_EQ(2, done);
+    ASSERT_EQ(19, written);
+    return 0;
+}
+
+TEST(parse_validating) {
+    pph_money_t m;
+    pph_size_t used;
+    const char *line = "1.234.567,89;x";
+
+    ASSERT_EQ(PPH_OK, pph_money_parse(line, 12, PPH_MONEY_FORMAT_ID, &m, &used));
+    ASSERT_EQ(PPH_INT64_C(12345678900), m.value);
+    ASSERT_EQ(12, used);
+
+    /* Stops at the first byte that is not part of the amount */
+    ASSERT_EQ(PPH_OK, pph_money_parse(line, 14, PPH_MONEY_FORMAT_ID, &m, &used));
+    ASSERT_EQ(12, used);
+
+    ASSERT_EQ(PPH_OK, pph_money_parse(" -1,234.5 ", 10, PPH_MONEY_FORMAT_EN, &m, &used));
+    ASSERT_EQ(-12345000, m.value);
+    ASSERT_EQ(10, used);
+
+    /* A real zero is not an error */
+    ASSERT_EQ(PPH_OK, pph_money_parse("0", 1, PPH_MONEY_FORMAT_PLAIN, &m, &used));
+    ASSERT_EQ(0, m.value);
+
+    ASSERT_EQ(PPH_ERR_SYNTAX, pph_money_parse("abc", 3, PPH_MONEY_FORMAT_PLAIN, &m, &used));
+    ASSERT_EQ(0, used);
+    ASSERT_EQ(PPH_ERR_SYNTAX, pph_money_parse("1.23.456", 8, PPH_MONEY_FORMAT_ID, &m, &used));
+    ASSERT_EQ(4, used);
+    ASSERT_EQ(PPH_ERR_SYNTAX, pph_money_parse("1.000.", 6, PPH_MONEY_FORMAT_ID, &m, &used));
+    ASSERT_EQ(PPH_ERR_SYNTAX, pph_money_parse("100,12345", 9, PPH_MONEY_FORMAT_ID, &m, &used));
+    ASSERT_EQ(PPH_ERR_SYNTAX, pph_money_parse("1.", 2, PPH_MONEY_FORMAT_PLAIN, &m, &used));
+    ASSERT_EQ(PPH_ERR_NULL_INPUT, pph_money_parse(NULL, 0, PPH_MONEY_FORMAT_PLAIN, &m, &used));
+    return 0;
+}
+
+TEST(parse_long_and_overflow) {
+    pph_money_t m;
+    pph_size_t used;
+    const char *max = "922.337.203.685.477,5807";
+    const char *min = "-922337203685477.5808";
+
+    /* Long enough for the 16-byte path, with separators straddling it */
+    ASSERT_EQ(PPH_OK, pph_money_parse(max, 24, PPH_MONEY_FORMAT_ID, &m, &used));
+    ASSERT_EQ(PPH_INT64_C(0x7FFFFFFFFFFFFFFF), m.value);
+    ASSERT_EQ(PPH_OK, pph_money_parse(min, 21, PPH_MONEY_FORMAT_PLAIN, &m, &used));
+    ASSERT_EQ(-PPH_INT64_C(0x7FFFFFFFFFFFFFFF) - 1, m.value);
+
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph_money_parse("922337203685477.5808", 20,
+                                                PPH_MONEY_FORMAT_PLAIN, &m, &used));
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph_money_parse("12345678901234567890", 20,
+                                                PPH_MONEY_FORMAT_PLAIN, &m, &used));
+    ASSERT_EQ(15, used);
+    ASSERT_EQ(0, m.value);
+    ASSERT_EQ(PPH_ERR_SYNTAX, pph_money_parse("1,000,000,000,0000,000", 22,
+                                              PPH_MONEY_FORMAT_EN, &m, &used));
+    ASSERT_EQ(18, used);
+    return 0;
+}
+
 int main(void) {
     printf("========================================\n");
     printf("  Money Arithmetic Tests\n");
@@ -155,6 +394,10 @@ int main(void) {
     RUN_TEST(money_subtraction);
     RUN_TEST(money_percentage);
     RUN_TEST(money_round_down_thousand);
+    RUN_TEST(money_multiply_wide);
+    RUN_TEST(money_reciprocal_division);
+    RUN_TEST(money_array_matches_scalar);
+    RUN_TEST(money_checked_ops);
     RUN_TEST(money_min);
     RUN_TEST(money_max);
 
@@ -173,6 +416,16 @@ int main(void) {
     RUN_TEST(parse_id_zero);
     RUN_TEST(parse_id_zero_with_decimal);
     RUN_TEST(parse_id_null);
+    RUN_TEST(parse_bounded_stops_at_length);
+
+    printf("\n");
+    printf("  Formatter Tests\n");
+    printf("========================================\n\n");
+
+    RUN_TEST(format_styles);
+    RUN_TEST(format_column_chunks);
+    RUN_TEST(parse_validating);
+    RUN_TEST(parse_long_and_overflow);
     RUN_TEST(parse_id_empty);
     RUN_TEST(parse_id_invalid_chars);
     RUN_TEST(parse_id_large_number);
@@ -5,6 +5,7 @@
 
 #include <pph/pph_calculator.h>
 #include "test_common.h"
+#include <string.h>
 
 int g_test_total = 0;
 int g_test_passed = 0;
@@ -31,6 +32,69 @@ TEST(pph21_pegawai_tetap_basic) {
     return 0;
 }
 
+TEST(pph21_breakdown_labels) {
+    pph21_input_t input = {0};
+    pph21_bonus_t bonuses[2];
+    pph_result_t *result;
+    pph_size_t i;
+    int bonus_rows = 0, found_total = 0;
+
+    strcpy(bonuses[0].name, "THR");
+    bonuses[0].month = 3;
+    bonuses[0].amount = PPH_RUPIAH(10000000);
+    strcpy(bonuses[1].name, "Bonus Tahunan");
+    bonuses[1].month = 3;
+    bonuses[1].amount = PPH_RUPIAH(5000000);
+
+    input.subject_type = PPH21_PEGAWAI_TETAP;
+    input.bruto_monthly = PPH_RUPIAH(10000000);
+    input.months_paid = 12;
+    input.ptkp_status = PPH_PTKP_TK0;
+    input.scheme = PPH21_SCHEME_LAMA;
+    input.bonuses = bonuses;
+    input.bonus_count = 2;
+
+    result = pph21_calculate(&input);
+    ASSERT_NOT_NULL(result);
+    ASSERT_EQ(32, (int)sizeof(pph_breakdown_row_t));
+    for (i = 0; i < result->breakdown_count; i++) {
+        pph_breakdown_row_t *row = &result->breakdown[i];
+
+        if (row->label == PPH_LABEL_GAJI_SETAHUN) {
+            ASSERT_EQ(PPH_LABEL_NOTE_MONTHS, row->note);
+            ASSERT_TRUE(strcmp(pph_result_row_label(result, i), "Gaji setahun") == 0);
+            ASSERT_TRUE(strcmp(pph_result_row_note(result, i), "12 bulan") == 0);
+        } else if (row->label == PPH_LABEL_BONUS) {
+            ASSERT_TRUE(strcmp(pph_result_row_label(result, i), bonuses[bonus_rows].name) == 0);
+            ASSERT_EQ(bonuses[bonus_rows].amount.value, row->value.value);
+            bonus_rows++;
+        } else if (row->label == PPH_LABEL_PPH21_SETAHUN) {
+            ASSERT_EQ(PPH_BREAKDOWN_TOTAL, row->variant);
+            ASSERT_EQ(result->total_tax.value, row->value.value);
+            found_total = 1;
+        }
+    }
+    ASSERT_EQ(2, bonus_rows);
+    ASSERT_TRUE(found_total);
+    ASSERT_TRUE(strcmp(pph_result_row_label(result, result->breakdown_count), "") == 0);
+    pph_result_free(result);
+
+    /* TER groups both bonuses into one dynamic month label */
+    input.scheme = PPH21_SCHEME_TER;
+    result = pph21_calculate(&input);
+    ASSERT_NOT_NULL(result);
+    ASSERT_EQ(PPH_LABEL_SECTION_TER, result->breakdown[0].label);
+    ASSERT_EQ(PPH_LABEL_TER_REGULAR_MONTHS, result->breakdown[4].label);
+    ASSERT_TRUE(strcmp(pph_result_row_label(result, 1), "Bulan 3 (THR, Bonus Tahunan)") == 0);
+    ASSERT_TRUE(strcmp(pph_result_row_label(result, 4), "10 bulan reguler") == 0);
+    ASSERT_TRUE(strcmp(pph_result_row_note(result, 4), "per bulan") == 0);
+    pph_result_free(result);
+
+    ASSERT_TRUE(strcmp(pph_label_text(PPH_LABEL_PTKP), "PTKP") == 0);
+    ASSERT_TRUE(strcmp(pph_label_text(PPH_LABEL_COUNT), "") == 0);
+    return 0;
+}
+
 TEST(pph21_null_input) {
     pph_result_t *result;
 
@@ -40,6 +104,679 @@ TEST(pph21_null_input) {
     return 0;
 }
 
+TEST(pph21_batch_matches_single) {
+    pph21_input_t inputs[3];
+    pph21_summary_t outputs[3];
+    pph21_bonus_t thr;
+    pph_status_t status;
+    int i;
+
+    memset(inputs, 0, sizeof(inputs));
+    memset(&thr, 0, sizeof(thr));
+    thr.month = 3;
+    thr.amount = PPH_RUPIAH(15000000);
+    strcpy(thr.name, "THR");
+
+    inputs[0].subject_type = PPH21_PEGAWAI_TETAP;
+    inputs[0].bruto_monthly = PPH_RUPIAH(10000000);
+    inputs[0].months_paid = 12;
+    inputs[0].pension_contribution = PPH_RUPIAH(100000);
+    inputs[0].ptkp_status = PPH_PTKP_TK0;
+    inputs[0].scheme = PPH21_SCHEME_TER;
+    inputs[0].ter_category = PPH21_TER_CATEGORY_A;
+
+    inputs[1] = inputs[0];
+    inputs[1].bruto_monthly = PPH_RUPIAH(25000000);
+    inputs[1].ptkp_status = PPH_PTKP_K2;
+    inputs[1].ter_category = PPH21_TER_CATEGORY_B;
+    inputs[1].bonuses = &thr;
+    inputs[1].bonus_count = 1;
+
+    inputs[2] = inputs[0];
+    inputs[2].scheme = PPH21_SCHEME_LAMA;
+    inputs[2].months_paid = 6;
+
+    status = pph21_calculate_batch(inputs, 3, outputs);
+    ASSERT_EQ(PPH_OK, status);
+
+    for (i = 0; i < 3; i++) {
+        pph_result_t *result = pph21_calculate(&inputs[i]);
+        ASSERT_NOT_NULL(result);
+        ASSERT_EQ(PPH_OK, outputs[i].status);
+        ASSERT_EQ(result->total_tax.value, outputs[i].total_tax.value);
+        pph_result_free(result);
+    }
+
+    return 0;
+}
+
+TEST(pph21_batch_reports_bad_record) {
+    pph21_input_t inputs[2];
+    pph21_summary_t outputs[2];
+
+    memset(inputs, 0, sizeof(inputs));
+    inputs[0].subject_type = PPH21_PEGAWAI_TETAP;
+    inputs[0].bruto_monthly = PPH_RUPIAH(10000000);
+    inputs[0].months_paid = 12;
+    inputs[1] = inputs[0];
+    inputs[1].subject_type = (pph21_subject_type_t)99;
+
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, pph21_calculate_batch(inputs, 2, outputs));
+    ASSERT_EQ(PPH_OK, outputs[0].status);
+    ASSERT_TRUE(outputs[0].total_tax.value > 0);
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, outputs[1].status);
+    ASSERT_EQ(0, outputs[1].total_tax.value);
+
+    ASSERT_EQ(PPH_ERR_NULL_INPUT, pph21_calculate_batch(NULL, 2, outputs));
+    ASSERT_EQ(PPH_OK, pph21_calculate_batch(NULL, 0, NULL));
+
+    return 0;
+}
+
+TEST(pph21_batch_range_checks) {
+    static pph21_input_t inputs[600];
+    static pph21_summary_t outputs[600];
+    pph21_summary_t single;
+    pph21_bonus_t bonus;
+    int i;
+
+    memset(inputs, 0, sizeof(inputs));
+    for (i = 0; i < 600; i++) {
+        inputs[i].subject_type = PPH21_PEGAWAI_TETAP;
+        inputs[i].bruto_monthly = PPH_RUPIAH(10000000 + i * 1000);
+        inputs[i].months_paid = 12;
+        inputs[i].scheme = PPH21_SCHEME_TER;
+    }
+
+    /* One record in the third block would wrap bruto * 12 */
+    inputs[520].bruto_monthly.value = PPH_INT64_C(0x7FFFFFFFFFFFFFFF) / 4;
+    bonus.month = 12;
+    bonus.amount.value = -PPH_INT64_C(0x7FFFFFFFFFFFFFFF) - 1;
+    strcpy(bonus.name, "Bonus");
+    inputs[10].bonuses = &bonus;
+    inputs[10].bonus_count = 1;
+
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph21_calculate_batch(inputs, 600, outputs));
+    for (i = 0; i < 600; i++) {
+        if (i == 10 || i == 520) {
+            ASSERT_EQ(PPH_ERR_OVERFLOW, outputs[i].status);
+            ASSERT_EQ(0, outputs[i].total_tax.value);
+        } else {
+            ASSERT_EQ(PPH_OK, pph21_calculate_summary(&inputs[i], &single));
+            ASSERT_EQ(PPH_OK, outputs[i].status);
+            ASSERT_EQ(single.total_tax.value, outputs[i].total_tax.value);
+            ASSERT_EQ(single.adjustment.value, outputs[i].adjustment.value);
+        }
+    }
+
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph21_calculate_summary(&inputs[520], &single));
+    ASSERT_TRUE(pph21_calculate(&inputs[520]) == NULL);
+
+    /* Rp 50 trillion a year is still in range */
+    inputs[0].bruto_monthly = PPH_RUPIAH(PPH_INT64_C(4000000000000));
+    ASSERT_EQ(PPH_OK, pph21_calculate_summary(&inputs[0], &single));
+    return 0;
+}
+
+TEST(pph21_summary_ter_months) {
+    pph21_input_t input;
+    pph21_summary_t summary;
+    pph21_bonus_t thr;
+    pph_money_t sum = PPH_ZERO;
+    int i;
+
+    memset(&input, 0, sizeof(input));
+    memset(&thr, 0, sizeof(thr));
+    thr.month = 3;
+    thr.amount = PPH_RUPIAH(10000000);
+    strcpy(thr.name, "THR");
+
+    input.subject_type = PPH21_PEGAWAI_TETAP;
+    input.bruto_monthly = PPH_RUPIAH(10000000);
+    input.months_paid = 12;
+    input.ptkp_status = PPH_PTKP_TK0;
+    input.scheme = PPH21_SCHEME_TER;
+    input.ter_category = PPH21_TER_CATEGORY_A;
+    input.bonuses = &thr;
+    input.bonus_count = 1;
+
+    ASSERT_EQ(PPH_OK, pph21_calculate_summary(&input, &summary));
+
+    /* 10 jt at TER A is 2%, 20 jt in the THR month is 9% */
+    ASSERT_EQ(PPH_RUPIAH(200000).value, summary.monthly_ter[0].value);
+    ASSERT_EQ(PPH_RUPIAH(1800000).value, summary.monthly_ter[2].value);
+    ASSERT_EQ(0, summary.monthly_ter[11].value);
+
+    for (i = 0; i < 12; i++) {
+        sum = pph_money_add(sum, summary.monthly_ter[i]);
+    }
+    ASSERT_EQ(sum.value, summary.ter_paid.value);
+    ASSERT_EQ(summary.total_tax.value - summary.ter_paid.value, summary.adjustment.value);
+
+    ASSERT_EQ(PPH_ERR_NULL_INPUT, pph21_calculate_summary(NULL, &summary));
+
+    return 0;
+}
+
+TEST(pph21_columns_match_summary) {
+    enum { N = 200 };
+    pph_int64_t bruto[N], pension[N], zakat[N];
+    pph_uint8_t months[N], ptkp[N], scheme[N], category[N];
+    pph_uint32_t bonus_start[N + 1];
+    pph21_bonus_t bonuses[N / 10];
+    pph_int64_t total_tax[N], ter_paid[N], adjustment[N];
+    pph_uint8_t status[N];
+    pph21_columns_t columns;
+    pph21_column_results_t results;
+    pph_uint32_t seed = 12345;
+    int i, bonus_count = 0;
+
+    memset(bonuses, 0, sizeof(bonuses));
+
+    for (i = 0; i < N; i++) {
+        seed = seed * 1103515245u + 12345u;
+        bruto[i] = PPH_RUPIAH(3000000).value + (pph_int64_t)(seed % 900000u) * PPH_RUPIAH(1000).value;
+        pension[i] = (i % 3) ? PPH_RUPIAH(100000).value : 0;
+        zakat[i] = (i % 7) ? 0 : PPH_RUPIAH(2500000).value;
+        months[i] = (pph_uint8_t)((i % 5) ? 12 : 1 + i % 12);
+        ptkp[i] = (pph_uint8_t)(i % 8);
+        scheme[i] = (pph_uint8_t)((i % 4) ? PPH21_SCHEME_TER : PPH21_SCHEME_LAMA);
+        category[i] = (pph_uint8_t)(i % 3);
+
+        bonus_start[i] = (pph_uint32_t)bonus_count;
+        if (i % 10 == 0) {
+            bonuses[bonus_count].month = 1 + i % 12;
+            bonuses[bonus_count].amount = PPH_RUPIAH(20000000);
+            bonus_count++;
+        }
+    }
+    bonus_start[N] = (pph_uint32_t)bonus_count;
+
+    /* A bruto exactly on a ceiling and one above the last ceiling */
+    bruto[1] = PPH_RUPIAH(5650000).value;
+    bruto[2] = PPH_RUPIAH(3000000000).value;
+
+    memset(&columns, 0, sizeof(columns));
+    columns.count = N;
+    columns.bruto_monthly = bruto;
+    columns.pension_contribution = pension;
+    columns.zakat_or_donation = zakat;
+    columns.months_paid = months;
+    columns.ptkp_status = ptkp;
+    columns.scheme = scheme;
+    columns.ter_category = category;
+    columns.bonus_start = bonus_start;
+    columns.bonuses = bonuses;
+
+    results.total_tax = total_tax;
+    results.ter_paid = ter_paid;
+    results.adjustment = adjustment;
+    results.status = status;
+
+    ASSERT_EQ(PPH_OK, pph21_calculate_columns(&columns, &results));
+
+    for (i = 0; i < N; i++) {
+        pph21_input_t input;
+        pph21_summary_t summary;
+
+        memset(&input, 0, sizeof(input));
+        input.subject_type = PPH21_PEGAWAI_TETAP;
+        input.bruto_monthly.value = bruto[i];
+        input.pension_contribution.value = pension[i];
+        input.zakat_or_donation.value = zakat[i];
+        input.months_paid = months[i];
+        input.ptkp_status = (pph_ptkp_status_t)ptkp[i];
+        input.scheme = (pph21_scheme_t)scheme[i];
+        input.ter_category = (pph21_ter_category_t)category[i];
+        input.bonuses = bonuses + bonus_start[i];
+        input.bonus_count = (int)(bonus_start[i + 1] - bonus_start[i]);
+
+        ASSERT_EQ(PPH_OK, pph21_calculate_summary(&input, &summary));
+        ASSERT_EQ(PPH_OK, status[i]);
+        ASSERT_EQ(summary.total_tax.value, total_tax[i]);
+        ASSERT_EQ(summary.ter_paid.value, ter_paid[i]);
+        ASSERT_EQ(summary.adjustment.value, adjustment[i]);
+    }
+
+    /* A failing bonus record is flagged in place; the rest still run */
+    bonuses[2].amount.value = PPH_INT64_C(0x7FFFFFFFFFFFFFFF);
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph21_calculate_columns(&columns, &results));
+    for (i = 0; i < N; i++) {
+        ASSERT_EQ((i == 20) ? PPH_ERR_OVERFLOW : PPH_OK, status[i]);
+    }
+    ASSERT_EQ(0, total_tax[20]);
+    bonuses[2].amount = PPH_RUPIAH(20000000);
+
+    /* Out-of-range records fail like pph21_calculate_summary(), in a
+       block that otherwise still computes */
+    bruto[70] = PPH_RUPIAH(PPH_INT64_C(40000000000000)).value;
+    bruto[71] = PPH_RUPIAH(PPH_INT64_C(100000000000000)).value;
+    pension[72] = PPH_INT64_C(0x7FFFFFFFFFFFFFFF);
+    ASSERT_EQ(PPH_ERR_OVERFLOW, pph21_calculate_columns(&columns, &results));
+    for (i = 64; i < 128; i++) {
+        pph21_input_t input;
+        pph21_summary_t summary;
+
+        memset(&input, 0, sizeof(input));
+        input.subject_type = PPH21_PEGAWAI_TETAP;
+        input.bruto_monthly.value = bruto[i];
+        input.pension_contribution.value = pension[i];
+        input.zakat_or_donation.value = zakat[i];
+        input.months_paid = months[i];
+        input.ptkp_status = (pph_ptkp_status_t)ptkp[i];
+        input.scheme = (pph21_scheme_t)scheme[i];
+        input.ter_category = (pph21_ter_category_t)category[i];
+        input.bonuses = bonuses + bonus_start[i];
+        input.bonus_count = (int)(bonus_start[i + 1] - bonus_start[i]);
+
+        ASSERT_EQ(pph21_calculate_summary(&input, &summary), status[i]);
+        ASSERT_EQ((i >= 70 && i <= 72) ? PPH_ERR_OVERFLOW : PPH_OK, status[i]);
+        ASSERT_EQ(summary.total_tax.value, total_tax[i]);
+        ASSERT_EQ(summary.ter_paid.value, ter_paid[i]);
+        ASSERT_EQ(summary.adjustment.value, adjustment[i]);
+    }
+
+    return 0;
+}
+
+/* Feed a full-year input month by month through the YTD state */
+static int run_ytd_year(const pph21_input_t *input, pph21_month_result_t results[12]) {
+    pph21_ytd_state_t state;
+    pph21_month_input_t month;
+    int m, b;
+
+    pph21_ytd_init(&state, input->ptkp_status, input->scheme, input->ter_category);
+
+    for (m = 1; m <= input->months_paid; m++) {
+        memset(&month, 0, sizeof(month));
+        month.bruto = input->bruto_monthly;
+        month.pension_contribution = input->pension_contribution;
+        month.is_final = (m == input->months_paid);
+        for (b = 0; b < input->bonus_count; b++) {
+            if (input->bonuses[b].month == m) {
+                month.bonus = pph_money_add(month.bonus, input->bonuses[b].amount);
+            }
+        }
+        if (month.is_final) {
+            month.zakat_or_donation = input->zakat_or_donation;
+        }
+        if (pph21_ytd_apply_month(&state, &month, &results[m - 1]) != PPH_OK) {
+            return -1;
+        }
+    }
+
+    /* The year is closed after the true-up */
+    return (pph21_ytd_apply_month(&state, &month, &results[0]) == PPH_ERR_INVALID_INPUT) ? 0 : -1;
+}
+
+TEST(pph21_ytd_matches_summary) {
+    pph21_bonus_t bonuses[2];
+    pph21_input_t input;
+    pph21_summary_t summary;
+    pph21_month_result_t months[12];
+    pph_int64_t bruto[4] = { 4500000, 10000000, 32000000, 250000000 };
+    int i, m;
+
+    memset(bonuses, 0, sizeof(bonuses));
+    bonuses[0].month = 4;
+    bonuses[0].amount = PPH_RUPIAH(15000000);
+    bonuses[1].month = 12;
+    bonuses[1].amount = PPH_RUPIAH(20000000);
+
+    for (i = 0; i < 8; i++) {
+        memset(&input, 0, sizeof(input));
+        input.subject_type = PPH21_PEGAWAI_TETAP;
+        input.bruto_monthly = PPH_RUPIAH(bruto[i % 4]);
+        input.months_paid = 12;
+        input.pension_contribution = PPH_RUPIAH(200000);
+        input.zakat_or_donation = PPH_RUPIAH(1200000);
+        input.ptkp_status = (pph_ptkp_status_t)(i % 8);
+        input.scheme = (i == 7) ? PPH21_SCHEME_LAMA : PPH21_SCHEME_TER;
+        input.ter_category = (pph21_ter_category_t)(i % 3);
+        input.bonuses = bonuses;
+        input.bonus_count = 2;
+
+        ASSERT_EQ(PPH_OK, pph21_calculate_summary(&input, &summary));
+        ASSERT_EQ(0, run_ytd_year(&input, months));
+
+        for (m = 0; m < 11; m++) {
+            ASSERT_EQ(summary.monthly_ter[m].value, months[m].withholding.value);
+            ASSERT_TRUE(!months[m].is_true_up);
+        }
+        ASSERT_TRUE(months[11].is_true_up);
+        ASSERT_EQ(summary.total_tax.value - summary.ter_paid.value, months[11].withholding.value);
+        ASSERT_EQ(summary.total_tax.value, months[11].withheld_ytd.value);
+    }
+
+    /* Leaving mid-year: the last month trues up to the same annual tax */
+    input.scheme = PPH21_SCHEME_TER;
+    input.months_paid = 7;
+    input.bonus_count = 1;      /* Only the April bonus falls in the period */
+    ASSERT_EQ(PPH_OK, pph21_calculate_summary(&input, &summary));
+    ASSERT_EQ(0, run_ytd_year(&input, months));
+    ASSERT_TRUE(months[6].is_true_up);
+    ASSERT_EQ(summary.total_tax.value, months[6].withheld_ytd.value);
+
+    return 0;
+}
+
+/* Curve evaluation must agree with the direct calculation everywhere */
+static int check_curve_point(const pph21_curve_t *curve, const pph21_profile_t *profile,
+                             pph_int64_t bruto) {
+    pph21_input_t input;
+    pph21_summary_t expected, actual;
+    pph_money_t money;
+    int m;
+
+    memset(&input, 0, sizeof(input));
+    input.subject_type = PPH21_PEGAWAI_TETAP;
+    input.bruto_monthly.value = bruto;
+    input.pension_contribution = profile->pension_contribution;
+    input.zakat_or_donation = profile->zakat_or_donation;
+    input.months_paid = profile->months_paid;
+    input.ptkp_status = profile->ptkp_status;
+    input.scheme = profile->scheme;
+    input.ter_category = profile->ter_category;
+
+    money.value = bruto;
+    ASSERT_EQ(PPH_OK, pph21_calculate_summary(&input, &expected));
+    ASSERT_EQ(PPH_OK, pph21_curve_evaluate(curve, money, &actual));
+    ASSERT_EQ(expected.total_tax.value, actual.total_tax.value);
+    ASSERT_EQ(expected.ter_paid.value, actual.ter_paid.value);
+    ASSERT_EQ(expected.adjustment.value, actual.adjustment.value);
+    for (m = 0; m < 12; m++) {
+        ASSERT_EQ(expected.monthly_ter[m].value, actual.monthly_ter[m].value);
+    }
+    ASSERT_EQ(expected.total_tax.value, pph21_curve_total_tax(curve, money).value);
+    return 0;
+}
+
+TEST(pph21_curve_matches_summary) {
+    enum { SWEEP = 500 };
+    pph21_profile_t profile;
+    pph21_curve_t curve;
+    pph_money_t from, step, sweep[SWEEP];
+    pph_uint32_t seed = 777;
+    int p, i;
+
+    for (p = 0; p < 24; p++) {
+        memset(&profile, 0, sizeof(profile));
+        profile.ptkp_status = (pph_ptkp_status_t)(p % 8);
+        profile.scheme = (p % 4) ? PPH21_SCHEME_TER : PPH21_SCHEME_LAMA;
+        profile.ter_category = (pph21_ter_category_t)(p % 3);
+        profile.months_paid = (p % 3) ? 12 : 1 + p % 12;
+        profile.pension_contribution = (p % 2) ? PPH_RUPIAH(150000) : PPH_ZERO;
+        profile.zakat_or_donation = (p % 5) ? PPH_ZERO : PPH_MONEY(1234567, 89);
+
+        ASSERT_EQ(PPH_OK, pph21_curve_compile(&profile, &curve));
+        ASSERT_TRUE(curve.segment_count > 1 && curve.segment_count <= PPH21_CURVE_MAX_SEGMENTS);
+
+        /* Both sides of every breakpoint */
+        for (i = 1; i < curve.segment_count; i++) {
+            ASSERT_EQ(0, check_curve_point(&curve, &profile, curve.segments[i].bruto_start - 1));
+            ASSERT_EQ(0, check_curve_point(&curve, &profile, curve.segments[i].bruto_start));
+        }
+
+        /* Random salaries from a few rupiah to billions a month */
+        for (i = 0; i < 200; i++) {
+            seed = seed * 1103515245u + 12345u;
+            ASSERT_EQ(0, check_curve_point(&curve, &profile,
+                                           (pph_int64_t)(seed >> 4) << (seed % 17)));
+        }
+
+        from = PPH_RUPIAH(1000000);
+        step = PPH_MONEY(12345, 6789);
+        ASSERT_EQ(PPH_OK, pph21_curve_sweep(&curve, from, step, SWEEP, sweep));
+        for (i = 0; i < SWEEP; i++) {
+            ASSERT_EQ(pph21_curve_total_tax(&curve, from).value, sweep[i].value);
+            from = pph_money_add(from, step);
+        }
+    }
+
+    /* Out of range */
+    from.value = -1;
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, pph21_curve_sweep(&curve, from, step, 1, sweep));
+    from.value = PPH21_CURVE_BRUTO_MAX;
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, pph21_curve_sweep(&curve, from, step, 2, sweep));
+
+    return 0;
+}
+
+/* Annual net (bruto less PPh 21) for a profile via the direct calculation */
+static pph_int64_t direct_net(const pph21_profile_t *profile, pph_int64_t bruto) {
+    pph21_input_t input;
+    pph21_summary_t summary;
+
+    memset(&input, 0, sizeof(input));
+    input.subject_type = PPH21_PEGAWAI_TETAP;
+    input.bruto_monthly.value = bruto;
+    input.pension_contribution = profile->pension_contribution;
+    input.zakat_or_donation = profile->zakat_or_donation;
+    input.months_paid = profile->months_paid;
+    input.ptkp_status = profile->ptkp_status;
+    input.scheme = profile->scheme;
+    input.ter_category = profile->ter_category;
+
+    pph21_calculate_summary(&input, &summary);
+    return bruto * profile->months_paid - summary.total_tax.value;
+}
+
+TEST(pph21_gross_up_reaches_net) {
+    enum { N = 300 };
+    pph21_profile_t profiles[N];
+    pph_money_t nets[N], brutos[N], bruto;
+    pph_uint32_t seed = 4242;
+    pph_int64_t target;
+    int i;
+
+    memset(profiles, 0, sizeof(profiles));
+    for (i = 0; i < N; i++) {
+        profiles[i].ptkp_status = (pph_ptkp_status_t)((i / 40) % 8);
+        profiles[i].scheme = (i % 2) ? PPH21_SCHEME_TER : PPH21_SCHEME_LAMA;
+        profiles[i].ter_category = PPH21_TER_CATEGORY_B;
+        profiles[i].months_paid = (i / 40 == 3) ? 5 : 12;
+        profiles[i].pension_contribution = (i / 80) ? PPH_RUPIAH(200000) : PPH_ZERO;
+
+        seed = seed * 1103515245u + 12345u;
+        nets[i].value = (pph_int64_t)(seed >> 4) << (seed % 15);
+    }
+    nets[0] = PPH_ZERO;
+    nets[1] = PPH_RUPIAH(4000000);           /* Below PTKP: no tax */
+    nets[2] = PPH_RUPIAH(150000000);         /* Top Pasal 17 layer */
+
+    ASSERT_EQ(PPH_OK, pph21_gross_up_batch(profiles, nets, N, brutos));
+
+    for (i = 0; i < N; i++) {
+        ASSERT_EQ(PPH_OK, pph21_gross_up(&profiles[i], nets[i], &bruto));
+        ASSERT_EQ(bruto.value, brutos[i].value);
+
+        /* Reaches the net, and one unit less does not */
+        target = nets[i].value * profiles[i].months_paid;
+        ASSERT_TRUE(direct_net(&profiles[i], bruto.value) >= target);
+        if (bruto.value > 0) {
+            ASSERT_TRUE(direct_net(&profiles[i], bruto.value - 1) < target);
+        }
+    }
+    ASSERT_EQ(PPH_RUPIAH(4000000).value, brutos[1].value);
+
+    nets[0].value = PPH21_CURVE_BRUTO_MAX;
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, pph21_gross_up(&profiles[0], nets[0], &bruto));
+    nets[0].value = PPH_INT64_C(0x7FFFFFFFFFFFFFFF) / 2;  /* Net * 12 would wrap */
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, pph21_gross_up(&profiles[0], nets[0], &bruto));
+    ASSERT_EQ(0, bruto.value);
+
+    return 0;
+}
+
+TEST(pph21_pasal17_brackets) {
+    pph21_input_t input;
+    pph21_summary_t summary;
+
+    memset(&input, 0, sizeof(input));
+    input.subject_type = PPH21_PEGAWAI_TETAP;
+    input.months_paid = 12;
+    input.ptkp_status = PPH_PTKP_TK0;
+    input.scheme = PPH21_SCHEME_LAMA;
+
+    /* PKP 120.000.000 - 6.000.000 - 54.000.000 = 60.000.000: top of 5% */
+    input.bruto_monthly = PPH_RUPIAH(10000000);
+    ASSERT_EQ(PPH_OK, pph21_calculate_summary(&input, &summary));
+    ASSERT_EQ(PPH_RUPIAH(3000000).value, summary.total_tax.value);
+
+    /* PKP 11.940.000.000: 1.444.000.000 + 35% of 6.940.000.000 */
+    input.bruto_monthly = PPH_RUPIAH(1000000000);
+    ASSERT_EQ(PPH_OK, pph21_calculate_summary(&input, &summary));
+    ASSERT_EQ(PPH_RUPIAH(3873000000).value, summary.total_tax.value);
+
+    return 0;
+}
+
+TEST(pph21_ter_bracket_edges) {
+    /* Category A: income (money units) and the TER rate expected for it */
+    static const pph_int64_t cases[][2] = {
+        { 0, 0 },
+        { PPH_INT64_C(54000000000), 0 },        /* On the first ceiling */
+        { PPH_INT64_C(54000000001), 25 },
+        { PPH_INT64_C(56500000000), 25 },
+        { PPH_INT64_C(56500000001), 50 },
+        { PPH_INT64_C(1024000000000), 2400 },   /* Last quantized bucket */
+        { PPH_INT64_C(1024000000001), 2400 },   /* First value past the index */
+        { PPH_INT64_C(1030000000000), 2400 },
+        { PPH_INT64_C(1100000000000), 2500 },
+        { PPH_INT64_C(50000000000000), 3400 }   /* Above the last ceiling */
+    };
+    pph21_input_t input;
+    pph21_summary_t summary;
+    int i;
+
+    memset(&input, 0, sizeof(input));
+    input.subject_type = PPH21_PEGAWAI_TETAP;
+    input.months_paid = 1;
+    input.ptkp_status = PPH_PTKP_TK0;
+    input.scheme = PPH21_SCHEME_TER;
+    input.ter_category = PPH21_TER_CATEGORY_A;
+
+    for (i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); i++) {
+        input.bruto_monthly.value = cases[i][0];
+        ASSERT_EQ(PPH_OK, pph21_calculate_summary(&input, &summary));
+        ASSERT_EQ(cases[i][0] * cases[i][1] / 10000, summary.monthly_ter[0].value);
+    }
+
+    return 0;
+}
+
+/* Overwrite bytes of a ruleset file in place */
+static int patch_file(const char *path, long offset, const void *data, size_t size) {
+    FILE *file = fopen(path, "r+b");
+    int ok;
+
+    if (file == NULL) {
+        return 0;
+    }
+    ok = fseek(file, offset, SEEK_SET) == 0 && fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && ok;
+}
+
+TEST(pph21_ruleset_publish) {
+    const char *path = "test_pph21_ruleset.pphr";
+    /* Header (64) and eight directory entries (16 each) come first */
+    const long ptkp_offset = 64 + 8 * 16;
+    const long base_tax_offset = ptkp_offset + 8 * 4 + 24 + 8;
+    pph_uint32_t ptkp_tk0 = 44000;
+    pph_int64_t base_tax = 1;
+    pph_ruleset_t *ruleset;
+    pph21_input_t input;
+    pph21_summary_t summary;
+
+    memset(&input, 0, sizeof(input));
+    input.subject_type = PPH21_PEGAWAI_TETAP;
+    input.bruto_monthly = PPH_RUPIAH(10000000);
+    input.months_paid = 12;
+    input.ptkp_status = PPH_PTKP_TK0;
+    input.scheme = PPH21_SCHEME_LAMA;
+
+    /* The exported built-in rules give the built-in results */
+    ASSERT_EQ(PPH_OK, pph_ruleset_write(NULL, "PMK 168/2023", path));
+    ruleset = pph_ruleset_load(path);
+    ASSERT_NOT_NULL(ruleset);
+    ASSERT_TRUE(strcmp(pph_ruleset_label(ruleset), "PMK 168/2023") == 0);
+    pph_ruleset_publish(ruleset);
+    ASSERT_EQ(PPH_OK, pph21_calculate_summary(&input, &summary));
+    ASSERT_EQ(PPH_RUPIAH(3000000).value, summary.total_tax.value);
+
+    /* PTKP TK/0 of 44 juta: PKP 70.000.000, 3.000.000 + 15% of 10.000.000 */
+    ASSERT_TRUE(patch_file(path, ptkp_offset, &ptkp_tk0, sizeof(ptkp_tk0)));
+    ruleset = pph_ruleset_load(path);
+    ASSERT_NOT_NULL(ruleset);
+    pph_ruleset_publish(ruleset);
+    ASSERT_EQ(PPH_OK, pph21_calculate_summary(&input, &summary));
+    ASSERT_EQ(PPH_RUPIAH(4500000).value, summary.total_tax.value);
+    ASSERT_EQ(0, pph_ruleset_collect());
+
+    /* A base tax that disagrees with the layers below it is rejected */
+    ASSERT_TRUE(patch_file(path, base_tax_offset, &base_tax, sizeof(base_tax)));
+    ASSERT_TRUE(pph_ruleset_load(path) == NULL);
+    ASSERT_TRUE(pph_ruleset_load("missing.pphr") == NULL);
+
+    pph_ruleset_publish(NULL);
+    ASSERT_EQ(0, pph_ruleset_collect());
+    ASSERT_EQ(PPH_OK, pph21_calculate_summary(&input, &summary));
+    ASSERT_EQ(PPH_RUPIAH(3000000).value, summary.total_tax.value);
+
+    remove(path);
+    return 0;
+}
+
+TEST(pph21_batch_dated_registry) {
+    const char *path = "test_pph21_registry.pphr";
+    const long ptkp_offset = 64 + 8 * 16;
+    static const long dates[4] = { 20221231L, 20230615L, 20240101L, 20230101L };
+    pph_uint32_t ptkp_tk0 = 44000;
+    pph_ruleset_registry_t *registry;
+    pph_ruleset_t *ruleset;
+    pph21_input_t inputs[4];
+    pph21_summary_t outputs[4];
+    int i;
+
+    memset(inputs, 0, sizeof(inputs));
+    for (i = 0; i < 4; i++) {
+        inputs[i].subject_type = PPH21_PEGAWAI_TETAP;
+        inputs[i].bruto_monthly = PPH_RUPIAH(10000000);
+        inputs[i].months_paid = 12;
+        inputs[i].ptkp_status = PPH_PTKP_TK0;
+        inputs[i].scheme = PPH21_SCHEME_LAMA;
+    }
+
+    /* 2023 with a PTKP TK/0 of 44 juta, the built-in rules from 2024 */
+    ASSERT_EQ(PPH_OK, pph_ruleset_write(NULL, "2023", path));
+    ASSERT_TRUE(patch_file(path, ptkp_offset, &ptkp_tk0, sizeof(ptkp_tk0)));
+    ruleset = pph_ruleset_load(path);
+    ASSERT_NOT_NULL(ruleset);
+
+    registry = pph_ruleset_registry_create();
+    ASSERT_NOT_NULL(registry);
+    ASSERT_EQ(PPH_OK, pph_ruleset_registry_add(registry, 20240101L, NULL));
+    ASSERT_EQ(PPH_OK, pph_ruleset_registry_add(registry, 20230101L, ruleset));
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, pph_ruleset_registry_add(registry, 20231301L, NULL));
+    ASSERT_TRUE(pph_ruleset_registry_label(registry, 20221231L) == NULL);
+    ASSERT_TRUE(strcmp(pph_ruleset_registry_label(registry, 20231231L), "2023") == 0);
+
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT,
+              pph21_calculate_batch_dated(registry, inputs, dates, 4, outputs));
+    ASSERT_EQ(PPH_ERR_INVALID_INPUT, outputs[0].status);
+    ASSERT_EQ(PPH_RUPIAH(4500000).value, outputs[1].total_tax.value);
+    ASSERT_EQ(PPH_RUPIAH(3000000).value, outputs[2].total_tax.value);
+    ASSERT_EQ(PPH_RUPIAH(4500000).value, outputs[3].total_tax.value);
+
+    /* The published rules are unaffected */
+    ASSERT_EQ(PPH_OK, pph21_calculate_summary(&inputs[1], &outputs[1]));
+    ASSERT_EQ(PPH_RUPIAH(3000000).value, outputs[1].total_tax.value);
+
+    pph_ruleset_registry_free(registry);
+    remove(path);
+    return 0;
+}
+
 int main(void) {
     pph_init();
 
@@ -48,7 +785,20 @@ int main(void) {
     printf("========================================\n\n");
 
     RUN_TEST(pph21_pegawai_tetap_basic);
+    RUN_TEST(pph21_breakdown_labels);
     RUN_TEST(pph21_null_input);
+    RUN_TEST(pph21_summary_ter_months);
+    RUN_TEST(pph21_batch_matches_single);
+    RUN_TEST(pph21_batch_reports_bad_record);
+    RUN_TEST(pph21_batch_range_checks);
+    RUN_TEST(pph21_pasal17_brackets);
+    RUN_TEST(pph21_ter_bracket_edges);
+    RUN_TEST(pph21_columns_match_summary);
+    RUN_TEST(pph21_ytd_matches_summary);
+    RUN_TEST(pph21_curve_matches_summary);
+    RUN_TEST(pph21_gross_up_reaches_net);
+    RUN_TEST(pph21_ruleset_publish);
+    RUN_TEST(pph21_batch_dated_registry);
 
     TEST_SUMMARY();
 
@@ -35,6 +35,8 @@ export interface PPh21Bonus {
 export interface TaxBreakdownRow {
     /** Row label */
     label: string;
+    /** Stable label ID (pph_label_id_t), for matching rows without comparing text */
+    labelId: number;
     /** Value (currency, percent, or text) */
     value: bigint | string;
     /** Value type (0=currency, 1=percent, 2=text) */
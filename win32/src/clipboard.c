@@ -44,6 +44,8 @@ void CopyResultsToClipboard(HWND hwnd)
     /* Add breakdown rows */
     for (i = 0; i < result->breakdown_count && offset < MAX_TEXT_SIZE - 256; i++) {
         pph_breakdown_row_t *row = &result->breakdown[i];
+        const char *label = pph_result_row_label(result, i);
+        const char *note = pph_result_row_note(result, i);
         char valueStr[128];
 
         /* Format value */
@@ -58,16 +60,16 @@ void CopyResultsToClipboard(HWND hwnd)
 
         /* Add row to text */
         if (row->variant == PPH_BREAKDOWN_SECTION) {
-            offset += sprintf(text + offset, "\r\n%s\r\n", row->label);
+            offset += sprintf(text + offset, "\r\n%s\r\n", label);
         } else {
             if (valueStr[0] != '\0') {
-                offset += sprintf(text + offset, "  %-40s %20s", row->label, valueStr);
-                if (row->note[0] != '\0') {
-                    offset += sprintf(text + offset, "  (%s)", row->note);
+                offset += sprintf(text + offset, "  %-40s %20s", label, valueStr);
+                if (note[0] != '\0') {
+                    offset += sprintf(text + offset, "  (%s)", note);
                 }
                 offset += sprintf(text + offset, "\r\n");
             } else {
-                offset += sprintf(text + offset, "  %s\r\n", row->label);
+                offset += sprintf(text + offset, "  %s\r\n", label);
             }
         }
     }
@@ -167,7 +169,8 @@ void ExportResultsToCSV(HWND hwnd)
         }
 
         /* Write CSV row - escape commas in text */
-        fprintf(fp, "\"%s\",\"%s\",\"%s\"\r\n", row->label, valueStr, row->note);
+        fprintf(fp, "\"%s\",\"%s\",\"%s\"\r\n", pph_result_row_label(result, i), valueStr,
+                pph_result_row_note(result, i));
     }
 
     /* Write total */
@@ -54,14 +54,11 @@ void DisplaySummary(HWND hwnd, pph_result_t* result)
         pph_size_t i;
         int months = 12;
 
-        /* Find total bruto from breakdown - search more broadly */
+        /* Find total bruto from breakdown */
         for (i = 0; i < result->breakdown_count; i++) {
             pph_breakdown_row_t *row = &result->breakdown[i];
-            /* Look for any variation of "bruto" total */
-            if ((strstr(row->label, "bruto") != NULL && strstr(row->label, "Total") != NULL) ||
-                strstr(row->label, "Total bruto") != NULL ||
-                strstr(row->label, "bruto setahun") != NULL ||
-                strstr(row->label, "Gaji pokok") != NULL) {
+            if (row->label == PPH_LABEL_TOTAL_BRUTO ||
+                row->label == PPH_LABEL_BRUTO_SETAHUN) {
                 /* Take the largest value as total bruto */
                 if (pph_money_cmp(row->value, brutoAnnual) > 0) {
                     brutoAnnual = row->value;
@@ -73,7 +70,7 @@ void DisplaySummary(HWND hwnd, pph_result_t* result)
         if (pph_money_cmp(brutoAnnual, PPH_ZERO) == 0) {
             for (i = 0; i < result->breakdown_count; i++) {
                 pph_breakdown_row_t *row = &result->breakdown[i];
-                if (strstr(row->label, "Penghasilan") != NULL &&
+                if (row->label == PPH_LABEL_PENGHASILAN_BRUTO &&
                     pph_money_cmp(row->value, PPH_ZERO) > 0) {
                     if (pph_money_cmp(row->value, brutoAnnual) > 0) {
                         brutoAnnual = row->value;
@@ -137,7 +134,7 @@ void DisplayBreakdown(HWND hwnd, pph_result_t* result)
         lvi.mask = LVIF_TEXT | LVIF_PARAM;
         lvi.iItem = (int)i;
         lvi.iSubItem = 0;
-        lvi.pszText = row->label;
+        lvi.pszText = (LPSTR)pph_result_row_label(result, i);
         lvi.lParam = (LPARAM)row->variant;  /* Store variant for custom draw */
 
         itemIndex = ListView_InsertItem(hwndListView, &lvi);
@@ -147,9 +144,9 @@ void DisplayBreakdown(HWND hwnd, pph_result_t* result)
             ListView_SetItemText(hwndListView, itemIndex, 1, valueStr);
         }
 
-        /* Column 2: Note */
-        if (row->note[0] != '\0') {
-            ListView_SetItemText(hwndListView, itemIndex, 2, row->note);
+        /* Column 2: Note, built in or from the result's string pool */
+        if (row->note != PPH_LABEL_NONE || row->note_text != 0) {
+            ListView_SetItemText(hwndListView, itemIndex, 2, (LPSTR)pph_result_row_note(result, i));
         }
 
         /* Apply styling based on variant */